@@ -16,11 +16,12 @@
 #include "bt/uni_bt.h"
 #include "bt/uni_bt_allowlist.h"
 #include "bt/uni_bt_le.h"
+#include "controller/uni_motion_fusion.h"
+#include "parser/uni_hid_parser_mouse.h"
 #include "platform/uni_platform.h"
 #include "uni_common.h"
 #include "uni_gpio.h"
 #include "uni_log.h"
-#include "uni_mouse_quadrature.h"
 #include "uni_property.h"
 #include "uni_virtual_device.h"
 
@@ -76,6 +77,11 @@ static struct {
     struct arg_end* end;
 } virtual_device_enable_args;
 
+static struct {
+    struct arg_int* enabled;
+    struct arg_end* end;
+} motion_fusion_enable_args;
+
 static struct {
     struct arg_str* prop;
     struct arg_end* end;
@@ -93,7 +99,7 @@ static int list_devices(int argc, char** argv) {
 
 static void print_mouse_scale(void) {
     char buf[32];
-    float scale = uni_mouse_quadrature_get_scale_factor();
+    float scale = uni_hid_parser_mouse_get_global_scale();
 
     // ets_printf() doesn't support "%f"
     sprintf(buf, "%f\n", scale);
@@ -113,7 +119,7 @@ static int mouse_scale(int argc, char** argv) {
     }
 
     scale = mouse_scale_args.value->dval[0];
-    uni_mouse_quadrature_set_scale_factor(scale);
+    uni_hid_parser_mouse_set_global_scale(scale);
     logi("Done\n");
     return 0;
 }
@@ -306,6 +312,24 @@ static int virtual_device_enable(int argc, char** argv) {
     return 0;
 }
 
+static int motion_fusion_enable(int argc, char** argv) {
+    int enabled;
+
+    int nerrors = arg_parse(argc, argv, (void**)&motion_fusion_enable_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, motion_fusion_enable_args.end, argv[0]);
+
+        // Don't treat it as error, just report the current value
+        logi("Motion fusion: %s\n", uni_motion_fusion_is_enabled() ? "Enabled" : "Disabled");
+        return 0;
+    }
+
+    enabled = motion_fusion_enable_args.enabled->ival[0];
+
+    uni_motion_fusion_set_enabled(enabled);
+    return 0;
+}
+
 static int getprop(int argc, char** argv) {
     int nerrors = arg_parse(argc, argv, (void**)&getprop_args);
     if (nerrors != 0) {
@@ -364,6 +388,10 @@ static void register_bluepad32() {
     virtual_device_enable_args.enabled = arg_int1(NULL, NULL, "<0 | 1>", "Whether virtual devices are allowed");
     virtual_device_enable_args.end = arg_end(2);
 
+    motion_fusion_enable_args.enabled =
+        arg_int1(NULL, NULL, "<0 | 1>", "Whether orientation is calculated from gyro / accel");
+    motion_fusion_enable_args.end = arg_end(2);
+
     getprop_args.prop = arg_str1(NULL, NULL, "<property_name>", "Return property value");
     getprop_args.end = arg_end(2);
 
@@ -483,6 +511,14 @@ static void register_bluepad32() {
         .argtable = &virtual_device_enable_args,
     };
 
+    const esp_console_cmd_t cmd_motion_fusion_enable = {
+        .command = "motion_fusion_enable",
+        .help = "Enables/Disables motion fusion",
+        .hint = NULL,
+        .func = &motion_fusion_enable,
+        .argtable = &motion_fusion_enable_args,
+    };
+
     const esp_console_cmd_t cmd_getprop = {
         .command = "getprop",
         .help = "Get property or all properties",
@@ -505,6 +541,7 @@ static void register_bluepad32() {
     ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_allowlist_enable));
     ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_mouse_scale));
     ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_virtual_device_enable));
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_motion_fusion_enable));
     ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_getprop));
 }
 #endif  // CONFIG_BLUEPAD32_USB_CONSOLE_ENABLE
@@ -64,6 +64,7 @@
 #include "bt/uni_bt_bredr.h"
 #include "bt/uni_bt_hci_cmd.h"
 #include "bt/uni_bt_le.h"
+#include "bt/uni_bt_link_quality.h"
 #include "bt/uni_bt_service.h"
 #include "bt/uni_bt_setup.h"
 #include "platform/uni_platform.h"
@@ -81,6 +82,18 @@ static btstack_context_callback_registration_t cmd_callback_registration;
 
 static bool bt_scanning_enabled;
 
+// Scan scheduler.
+// Scanning competes for airtime with the connected controllers. The inquiry / scan duty is lowered as the
+// seats get filled, and scanning stops when there are no free seats.
+// When new connections get enabled, it scans at full duty for a while.
+#define SCAN_SCHEDULER_PERIOD_MS 1000
+static btstack_timer_source_t scan_scheduler_timer;
+// Might be false while "bt_scanning_enabled" is true, when there are no free seats
+static bool scan_running;
+static uint32_t scan_burst_end_ms;
+static bool scan_adaptive;
+static uint8_t scan_min_duty;
+
 static void start_scan(void);
 static void stop_scan(void);
 
@@ -127,14 +140,73 @@ static void stop_scan(void) {
         uni_bt_le_scan_stop();
 }
 
+static uint8_t get_scan_duty(void) {
+    int free_slots = uni_hid_device_get_free_slots_count();
+
+    if (free_slots == 0)
+        return 0;
+    if (!scan_adaptive || free_slots == CONFIG_BLUEPAD32_MAX_DEVICES)
+        return 100;
+    if ((int32_t)(btstack_run_loop_get_time_ms() - scan_burst_end_ms) < 0)
+        return 100;
+    // From scan_min_duty with one free seat, up to 100 with all of them free
+    return scan_min_duty + (100 - scan_min_duty) * (free_slots - 1) / btstack_max(CONFIG_BLUEPAD32_MAX_DEVICES - 1, 1);
+}
+
+static void update_scan_duty(void) {
+    uint8_t duty = get_scan_duty();
+
+    if (duty == 0) {
+        if (scan_running) {
+            logi("No free seats, pausing scan\n");
+            scan_running = false;
+            stop_scan();
+        }
+        return;
+    }
+
+    if (IS_ENABLED(UNI_ENABLE_BREDR))
+        uni_bt_bredr_scan_set_duty(duty);
+    if (IS_ENABLED(UNI_ENABLE_BLE))
+        uni_bt_le_scan_set_duty(duty);
+
+    if (!scan_running) {
+        scan_running = true;
+        start_scan();
+    }
+}
+
+static void scan_scheduler_timer_handler(btstack_timer_source_t* ts) {
+    if (!bt_scanning_enabled)
+        return;
+    update_scan_duty();
+    btstack_run_loop_set_timer(ts, SCAN_SCHEDULER_PERIOD_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
 static void enable_new_connections(bool enabled) {
     if (bt_scanning_enabled != enabled) {
         bt_scanning_enabled = enabled;
 
-        if (enabled)
-            start_scan();
-        else
-            stop_scan();
+        if (enabled) {
+            // Read them once, instead of on every tick
+            scan_adaptive = uni_property_get(UNI_PROPERTY_IDX_SCAN_ADAPTIVE).boolean;
+            scan_min_duty = btstack_max(1, btstack_min(100, uni_property_get(UNI_PROPERTY_IDX_SCAN_MIN_DUTY).u8));
+            scan_burst_end_ms = btstack_run_loop_get_time_ms() + uni_property_get(UNI_PROPERTY_IDX_SCAN_BURST).u32;
+
+            update_scan_duty();
+
+            btstack_run_loop_remove_timer(&scan_scheduler_timer);
+            btstack_run_loop_set_timer_handler(&scan_scheduler_timer, scan_scheduler_timer_handler);
+            btstack_run_loop_set_timer(&scan_scheduler_timer, SCAN_SCHEDULER_PERIOD_MS);
+            btstack_run_loop_add_timer(&scan_scheduler_timer);
+        } else {
+            btstack_run_loop_remove_timer(&scan_scheduler_timer);
+            if (scan_running) {
+                scan_running = false;
+                stop_scan();
+            }
+        }
     }
 
     uni_get_platform()->on_oob_event(UNI_PLATFORM_OOB_BLUETOOTH_ENABLED, (void*)enabled);
@@ -309,8 +381,15 @@ void uni_bt_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* packe
                     if (status)
                         logi("Failed command: HCI_EVENT_COMMAND_COMPLETE: opcode = 0x%04x - status=%d\n", opcode,
                              status);
+                    uni_bt_link_quality_on_hci_command_complete(packet, size);
+                    if (IS_ENABLED(UNI_ENABLE_BREDR))
+                        uni_bt_bredr_on_hci_command_complete(channel, packet, size);
                     break;
                 }
+                case HCI_EVENT_COMMAND_STATUS:
+                    if (IS_ENABLED(UNI_ENABLE_BREDR))
+                        uni_bt_bredr_on_hci_command_status(channel, packet, size);
+                    break;
                 case HCI_EVENT_AUTHENTICATION_COMPLETE_EVENT: {
                     status = hci_event_authentication_complete_get_status(packet);
                     handle = hci_event_authentication_complete_get_connection_handle(packet);
@@ -399,6 +478,10 @@ void uni_bt_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* packe
                 case HCI_EVENT_LINK_KEY_REQUEST:
                     logi("--> HCI_EVENT_LINK_KEY_REQUEST:\n");
                     break;
+                case HCI_EVENT_MODE_CHANGE:
+                    if (IS_ENABLED(UNI_ENABLE_BREDR))
+                        uni_bt_bredr_on_hci_mode_change(channel, packet, size);
+                    break;
                 case HCI_EVENT_ROLE_CHANGE:
                     logi("--> HCI_EVENT_ROLE_CHANGE\n");
                     break;
@@ -449,23 +532,17 @@ void uni_bt_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* packe
                 case GAP_EVENT_INQUIRY_COMPLETE:
                     logd("--> GAP_EVENT_INQUIRY_COMPLETE\n");
                     // This can happen when "exit periodic inquiry" is called.
-                    // Just do nothing, don't call "start_scan" again.
+                    // Don't call "start_scan" again. BR/EDR might restart it if the duty cycle changed.
+                    if (IS_ENABLED(UNI_ENABLE_BREDR))
+                        uni_bt_bredr_on_gap_inquiry_complete(channel, packet, size);
                     break;
                 case GAP_EVENT_ADVERTISING_REPORT:
                     if (IS_ENABLED(UNI_ENABLE_BLE))
                         uni_bt_le_on_gap_event_advertising_report(packet, size);
                     break;
-                case GAP_EVENT_RSSI_MEASUREMENT: {
-                    uint8_t rssi = gap_event_rssi_measurement_get_rssi(packet);
-                    hci_con_handle_t conn = gap_event_rssi_measurement_get_con_handle(packet);
-                    uni_hid_device_t* d = uni_hid_device_get_instance_for_connection_handle(conn);
-                    if (!d) {
-                        loge("Could not found device for connection handle: %x\n", conn);
-                        break;
-                    }
-                    d->conn.rssi = rssi;
+                case GAP_EVENT_RSSI_MEASUREMENT:
+                    uni_bt_link_quality_on_gap_rssi_measurement(packet, size);
                     break;
-                }
                 // GATT EVENTS (BLE only)
                 case GATT_EVENT_LONG_CHARACTERISTIC_VALUE_QUERY_RESULT:
                     logd("--> GATT_EVENT_LONG_CHARACTERISTIC_VALUE_QUERY_RESULT\n");
@@ -19,6 +19,7 @@
 #include "uni_common.h"
 #include "uni_config.h"
 #include "uni_log.h"
+#include "uni_property.h"
 
 // These are the only two supported platforms with BR/EDR support.
 #if !(defined(CONFIG_IDF_TARGET_ESP32) || defined(CONFIG_TARGET_POSIX) || defined(CONFIG_TARGET_PICO_W))
@@ -30,6 +31,44 @@ _Static_assert(INQUIRY_REMOTE_NAME_TIMEOUT_MS < HID_DEVICE_CONNECTION_TIMEOUT_MS
 
 static bool bt_bredr_enabled = true;
 
+// Link policy manager.
+// Some controllers enter sniff mode with long intervals, and input latency jumps.
+// While input is active, sniff mode is disabled. After some idle time, sniff is allowed again, and requested
+// to save power.
+#define LINK_POLICY_TIMER_PERIOD_MS 250
+
+// Sniff parameters used when the link is idle. In 0.625ms units.
+#define SNIFF_MIN_INTERVAL 0x0030  // 30ms
+#define SNIFF_MAX_INTERVAL 0x00a0  // 100ms
+#define SNIFF_ATTEMPT 4
+#define SNIFF_TIMEOUT 1
+
+// QoS, as recommended by the HID spec for guaranteed polling.
+#define QOS_TOKEN_RATE 900              // Bytes per second
+#define QOS_LATENCY_US 11250            // 11.25ms
+#define QOS_DELAY_VARIATION 0xffffffff  // Don't care
+
+enum {
+    LINK_POLICY_TASK_WRITE_POLICY = BIT(0),
+    LINK_POLICY_TASK_WRITE_FLUSH_TIMEOUT = BIT(1),
+    // Queued once the controller accepted a policy that allows sniff mode
+    LINK_POLICY_TASK_ENTER_SNIFF = BIT(2),
+};
+
+// Inquiry duty cycle in percentage, set by the scan scheduler.
+static uint8_t inquiry_duty = 100;
+static bool inquiry_active;
+// Periodic inquiry parameters can't be changed while running. It needs to be stopped and started again.
+static bool inquiry_restart_pending;
+
+static btstack_timer_source_t link_policy_timer;
+static bool link_policy_timer_active;
+static uint32_t sniff_idle_ms;
+static uint16_t flush_timeout;  // In 0.625ms units
+static bool qos_enabled;
+// Sniff Mode is answered with a Command Status, which has no connection handle.
+static hci_con_handle_t sniff_request_handle = HCI_CON_HANDLE_INVALID;
+
 static void l2cap_create_control_connection(uni_hid_device_t* d) {
     uint8_t status;
     status = l2cap_create_channel(uni_bt_packet_handler, d->conn.btaddr, BLUETOOTH_PSM_HID_CONTROL,
@@ -61,12 +100,40 @@ static void inquiry_remote_name_timeout_callback(btstack_timer_source_t* ts) {
     uni_bt_bredr_process_fsm(d);
 }
 
-void uni_bt_bredr_scan_start(void) {
+static uint8_t inquiry_start(void) {
+    int len = uni_bt_get_gap_inquiry_length();
+    int max_len = uni_bt_get_gap_max_periodic_length();
+    int min_len = uni_bt_get_gap_min_periodic_length();
+
+    if (inquiry_duty < 100) {
+        // Same inquiry length, but longer pauses between inquiries.
+        int delta = max_len - min_len;
+        max_len = btstack_max(max_len, len * 100 / inquiry_duty);
+        min_len = max_len - delta;
+    }
+    return gap_inquiry_periodic_start(len, max_len, min_len);
+}
+
+static void inquiry_restart(void) {
     uint8_t status;
 
-    status = gap_inquiry_periodic_start(uni_bt_get_gap_inquiry_length(), uni_bt_get_gap_max_periodic_length(),
-                                        uni_bt_get_gap_min_periodic_length());
+    status = inquiry_start();
+    // Might still be stopping. Will be retried later.
+    if (status == ERROR_CODE_COMMAND_DISALLOWED)
+        return;
+    inquiry_restart_pending = false;
     if (status)
+        loge("Failed to restart period inquiry, error=0x%02x\n", status);
+}
+
+void uni_bt_bredr_scan_start(void) {
+    uint8_t status;
+
+    inquiry_active = true;
+    status = inquiry_start();
+    if (status == ERROR_CODE_COMMAND_DISALLOWED)
+        inquiry_restart_pending = true;
+    else if (status)
         loge("Failed to start period inquiry, error=0x%02x\n", status);
     logi("BR/EDR scan -> 1\n");
 }
@@ -74,6 +141,9 @@ void uni_bt_bredr_scan_start(void) {
 void uni_bt_bredr_scan_stop(void) {
     uint8_t status;
 
+    inquiry_active = false;
+    inquiry_restart_pending = false;
+
     status = gap_inquiry_stop();
     if (status)
         loge("Error: cannot stop inquiry (0x%02x), please try again\n", status);
@@ -177,11 +247,155 @@ void uni_bt_bredr_setup(void) {
     // try to become master on incoming connections
     hci_set_master_slave_policy(HCI_ROLE_MASTER);
 
+    sniff_idle_ms = uni_property_get(UNI_PROPERTY_IDX_BREDR_SNIFF_IDLE).u32;
+    // Convert to 0.625ms units. Max value allowed by the spec is 0x07ff
+    flush_timeout = btstack_min(uni_property_get(UNI_PROPERTY_IDX_BREDR_FLUSH_TIMEOUT).u32 * 1000 / 625, 0x07ff);
+    qos_enabled = uni_property_get(UNI_PROPERTY_IDX_BREDR_QOS_ENABLED).boolean;
+
     logi("Gap security level: %d\n", security_level);
     logi("Periodic Inquiry: max=%d, min=%d, len=%d\n", uni_bt_get_gap_max_periodic_length(),
          uni_bt_get_gap_min_periodic_length(), uni_bt_get_gap_inquiry_length());
 }
 
+static bool is_link_managed(uni_hid_device_t* d) {
+    return d->conn.protocol == UNI_BT_CONN_PROTOCOL_BR_EDR && d->conn.interrupt_cid != 0 &&
+           gap_get_connection_type(d->conn.handle) == GAP_CONNECTION_ACL;
+}
+
+// Sends the pending HCI commands, one per call, since the controller might not be able to take more.
+static void link_policy_run_tasks(uni_hid_device_t* d) {
+    uint16_t settings;
+
+    if (!d->conn.link_policy_tasks || !hci_can_send_command_packet_now())
+        return;
+
+    if (d->conn.link_policy_tasks & LINK_POLICY_TASK_WRITE_POLICY) {
+        d->conn.link_policy_tasks &= ~LINK_POLICY_TASK_WRITE_POLICY;
+        settings = LM_LINK_POLICY_ENABLE_ROLE_SWITCH;
+        if (d->conn.sniff_allowed)
+            settings |= LM_LINK_POLICY_ENABLE_SNIFF_MODE;
+        hci_send_cmd(&hci_write_link_policy_settings, d->conn.handle, settings);
+        return;
+    }
+
+    if (d->conn.link_policy_tasks & LINK_POLICY_TASK_WRITE_FLUSH_TIMEOUT) {
+        d->conn.link_policy_tasks &= ~LINK_POLICY_TASK_WRITE_FLUSH_TIMEOUT;
+        hci_send_cmd(&hci_write_automatic_flush_timeout, d->conn.handle, flush_timeout);
+        return;
+    }
+
+    if (d->conn.link_policy_tasks & LINK_POLICY_TASK_ENTER_SNIFF) {
+        d->conn.link_policy_tasks &= ~LINK_POLICY_TASK_ENTER_SNIFF;
+        // Input might have arrived while waiting for the policy
+        if (!d->conn.sniff_allowed || d->conn.mode == ACL_CONNECTION_MODE_SNIFF)
+            return;
+        logi("BR/EDR: %s idle, entering sniff mode\n", bd_addr_to_str(d->conn.btaddr));
+        sniff_request_handle = d->conn.handle;
+        hci_send_cmd(&hci_sniff_mode, d->conn.handle, SNIFF_MAX_INTERVAL, SNIFF_MIN_INTERVAL, SNIFF_ATTEMPT,
+                     SNIFF_TIMEOUT);
+        return;
+    }
+}
+
+static void link_policy_set_sniff_allowed(uni_hid_device_t* d, bool allowed) {
+    if (d->conn.sniff_allowed == allowed)
+        return;
+    d->conn.sniff_allowed = allowed;
+    d->conn.link_policy_tasks |= LINK_POLICY_TASK_WRITE_POLICY;
+
+    // Sniff mode is requested once the policy that allows it is written. See uni_bt_bredr_on_hci_command_complete().
+    if (!allowed && d->conn.mode == ACL_CONNECTION_MODE_SNIFF) {
+        logi("BR/EDR: %s active, exiting sniff mode\n", bd_addr_to_str(d->conn.btaddr));
+        gap_sniff_mode_exit(d->conn.handle);
+    }
+}
+
+static void link_policy_timer_handler(btstack_timer_source_t* ts) {
+    uint32_t now = btstack_run_loop_get_time_ms();
+    bool any = false;
+
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        uni_hid_device_t* d = uni_hid_device_get_instance_for_idx(i);
+        if (!is_link_managed(d))
+            continue;
+        any = true;
+
+        if (sniff_idle_ms && !d->conn.sniff_allowed && (now - d->conn.last_input_ms) >= sniff_idle_ms)
+            link_policy_set_sniff_allowed(d, true);
+        link_policy_run_tasks(d);
+    }
+
+    // Stop the timer when there are no more BR/EDR devices. Restarted on the next connection.
+    if (!any) {
+        link_policy_timer_active = false;
+        return;
+    }
+    btstack_run_loop_set_timer(ts, LINK_POLICY_TIMER_PERIOD_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+static void link_policy_on_connected(uni_hid_device_t* d) {
+    d->conn.last_input_ms = btstack_run_loop_get_time_ms();
+
+    // Force a write, since the link might have inherited the default policy which allows sniff.
+    d->conn.sniff_allowed = true;
+    link_policy_set_sniff_allowed(d, false);
+
+    if (flush_timeout)
+        d->conn.link_policy_tasks |= LINK_POLICY_TASK_WRITE_FLUSH_TIMEOUT;
+
+    if (qos_enabled)
+        gap_qos_set(d->conn.handle, HCI_SERVICE_TYPE_GUARANTEED, QOS_TOKEN_RATE, 0, QOS_LATENCY_US,
+                    QOS_DELAY_VARIATION);
+
+    link_policy_run_tasks(d);
+
+    if (!link_policy_timer_active) {
+        link_policy_timer_active = true;
+        btstack_run_loop_set_timer_handler(&link_policy_timer, link_policy_timer_handler);
+        btstack_run_loop_set_timer(&link_policy_timer, LINK_POLICY_TIMER_PERIOD_MS);
+        btstack_run_loop_add_timer(&link_policy_timer);
+    }
+}
+
+// The controller didn't accept sniff mode: back to active, and try again after another idle period.
+static void link_policy_on_sniff_failed(uni_hid_device_t* d, uint8_t status) {
+    logi("BR/EDR: %s failed to enter sniff mode, status=%#x\n", bd_addr_to_str(d->conn.btaddr), status);
+    d->conn.last_input_ms = btstack_run_loop_get_time_ms();
+    link_policy_set_sniff_allowed(d, false);
+    link_policy_run_tasks(d);
+}
+
+static void link_policy_on_input(uni_hid_device_t* d) {
+    d->conn.last_input_ms = btstack_run_loop_get_time_ms();
+    if (d->conn.sniff_allowed) {
+        link_policy_set_sniff_allowed(d, false);
+        link_policy_run_tasks(d);
+    }
+}
+
+void uni_bt_bredr_scan_set_duty(uint8_t duty) {
+    if (inquiry_restart_pending)
+        inquiry_restart();
+
+    if (duty == inquiry_duty)
+        return;
+    logi("BR/EDR inquiry duty -> %d%%\n", duty);
+    inquiry_duty = duty;
+
+    if (inquiry_active && gap_inquiry_stop() == ERROR_CODE_SUCCESS)
+        inquiry_restart_pending = true;
+}
+
+void uni_bt_bredr_on_gap_inquiry_complete(uint16_t channel, const uint8_t* packet, uint16_t size) {
+    ARG_UNUSED(channel);
+    ARG_UNUSED(packet);
+    ARG_UNUSED(size);
+
+    if (inquiry_restart_pending)
+        inquiry_restart();
+}
+
 void uni_bt_bredr_set_enabled(bool enabled) {
     bt_bredr_enabled = enabled;
 }
@@ -220,13 +434,22 @@ void uni_bt_bredr_process_fsm(uni_hid_device_t* d) {
     // The name is fetched at the very beginning, when we initiate the connection,
     // Or at the very end, when it is an incoming connection.
     if (!uni_hid_device_has_name(d) &&
-        ((state == UNI_BT_CONN_STATE_DEVICE_DISCOVERED) || state == UNI_BT_CONN_STATE_L2CAP_INTERRUPT_CONNECTED)) {
+        ((state == UNI_BT_CONN_STATE_DEVICE_DISCOVERED) || state == UNI_BT_CONN_STATE_L2CAP_INTERRUPT_CONNECTED ||
+         state == UNI_BT_CONN_STATE_REMOTE_NAME_REQUEST)) {
         logi("uni_bt_process_fsm: requesting name\n");
 
+        uint8_t status;
         if (d->conn.clock_offset & UNI_BT_CLOCK_OFFSET_VALID)
-            gap_remote_name_request(d->conn.btaddr, d->conn.page_scan_repetition_mode, d->conn.clock_offset);
+            status = gap_remote_name_request(d->conn.btaddr, d->conn.page_scan_repetition_mode, d->conn.clock_offset);
         else
-            gap_remote_name_request(d->conn.btaddr, 0x02, 0x0000);
+            status = gap_remote_name_request(d->conn.btaddr, 0x02, 0x0000);
+
+        if (status == ERROR_CODE_COMMAND_DISALLOWED) {
+            // Only one name request at the time is supported. Retried when the current one finishes.
+            logi("uni_bt_process_fsm: another name request in progress, %s waiting\n", bd_addr_to_str(d->conn.btaddr));
+            uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_REMOTE_NAME_REQUEST);
+            return;
+        }
 
         uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_REMOTE_NAME_INQUIRED);
 
@@ -454,6 +677,7 @@ void uni_bt_bredr_on_l2cap_channel_opened(uint16_t channel, const uint8_t* packe
 
             // Set "connected" only after PSM_HID_INTERRUPT.
             uni_hid_device_connect(device);
+            link_policy_on_connected(device);
             break;
         default:
             logi("Unknown PSM = 0x%02x\n", psm);
@@ -491,6 +715,13 @@ void uni_bt_bredr_on_l2cap_data_packet(uint16_t channel, const uint8_t* packet,
         return;
     }
 
+    // Answer to a SET_REPORT sent on the control channel.
+    if (channel == d->conn.control_cid && size >= 1 && (packet[0] >> 4) == HID_MESSAGE_TYPE_HANDSHAKE) {
+        if (d->report_parser.set_report_result)
+            d->report_parser.set_report_result(d, (packet[0] & 0x0f) == HID_HANDSHAKE_PARAM_TYPE_SUCCESSFUL);
+        return;
+    }
+
     // Sanity check. It must have at least a transaction type and a report id.
     if (size < 2) {
         // Might happen with certain gamepads like DS3 that sends a "0" after enabling rumble.
@@ -519,6 +750,8 @@ void uni_bt_bredr_on_l2cap_data_packet(uint16_t channel, const uint8_t* packet,
         return;
     }
 
+    link_policy_on_input(d);
+
     // Skip the first byte, which is always 0xa1
     uni_hid_parse_input_report(d, &packet[1], size - 1);
     uni_hid_device_process_controller(d);
@@ -745,4 +978,84 @@ void uni_bt_bredr_on_hci_remote_name_request_complete(uint16_t channel, const ui
         // Remove timer
         btstack_run_loop_remove_timer(&d->inquiry_remote_name_timer);
     }
+
+    // Serve the next device waiting for its name
+    d = uni_hid_device_get_first_device_with_state(UNI_BT_CONN_STATE_REMOTE_NAME_REQUEST);
+    if (d != NULL)
+        uni_bt_bredr_process_fsm(d);
+}
+
+void uni_bt_bredr_on_hci_command_complete(uint16_t channel, const uint8_t* packet, uint16_t size) {
+    const uint8_t* param;
+    uni_hid_device_t* d;
+
+    ARG_UNUSED(channel);
+    ARG_UNUSED(size);
+
+    if (hci_event_command_complete_get_command_opcode(packet) != HCI_OPCODE_HCI_WRITE_LINK_POLICY_SETTINGS)
+        return;
+
+    // Return parameters: status, connection handle.
+    param = hci_event_command_complete_get_return_parameters(packet);
+    d = uni_hid_device_get_instance_for_connection_handle(little_endian_read_16(param, 1));
+    if (!d || !is_link_managed(d))
+        return;
+
+    if (param[0] != ERROR_CODE_SUCCESS) {
+        if (d->conn.sniff_allowed)
+            link_policy_on_sniff_failed(d, param[0]);
+        return;
+    }
+
+    // Sniff mode is only requested once the controller allows it.
+    if (d->conn.sniff_allowed && d->conn.mode != ACL_CONNECTION_MODE_SNIFF) {
+        d->conn.link_policy_tasks |= LINK_POLICY_TASK_ENTER_SNIFF;
+        link_policy_run_tasks(d);
+    }
+}
+
+void uni_bt_bredr_on_hci_command_status(uint16_t channel, const uint8_t* packet, uint16_t size) {
+    uint8_t status;
+    uni_hid_device_t* d;
+
+    ARG_UNUSED(channel);
+    ARG_UNUSED(size);
+
+    if (hci_event_command_status_get_command_opcode(packet) != HCI_OPCODE_HCI_SNIFF_MODE)
+        return;
+
+    status = hci_event_command_status_get_status(packet);
+    d = uni_hid_device_get_instance_for_connection_handle(sniff_request_handle);
+    sniff_request_handle = HCI_CON_HANDLE_INVALID;
+    if (status == ERROR_CODE_SUCCESS || !d || !d->conn.sniff_allowed)
+        return;
+    link_policy_on_sniff_failed(d, status);
+}
+
+void uni_bt_bredr_on_hci_mode_change(uint16_t channel, const uint8_t* packet, uint16_t size) {
+    uint8_t status;
+    uni_hid_device_t* d;
+
+    ARG_UNUSED(channel);
+    ARG_UNUSED(size);
+
+    d = uni_hid_device_get_instance_for_connection_handle(hci_event_mode_change_get_handle(packet));
+    if (!d)
+        return;
+
+    status = hci_event_mode_change_get_status(packet);
+    if (status != ERROR_CODE_SUCCESS) {
+        if (d->conn.sniff_allowed && d->conn.mode != ACL_CONNECTION_MODE_SNIFF)
+            link_policy_on_sniff_failed(d, status);
+        return;
+    }
+
+    d->conn.mode = hci_event_mode_change_get_mode(packet);
+    d->conn.sniff_interval = hci_event_mode_change_get_interval(packet);
+    logi("BR/EDR: %s mode=%d, interval=%d (0.625ms units)\n", bd_addr_to_str(d->conn.btaddr), d->conn.mode,
+         d->conn.sniff_interval);
+
+    // Device entered sniff mode on its own while being active
+    if (d->conn.mode == ACL_CONNECTION_MODE_SNIFF && !d->conn.sniff_allowed)
+        gap_sniff_mode_exit(d->conn.handle);
 }
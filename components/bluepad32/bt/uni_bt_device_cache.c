@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#include "bt/uni_bt_device_cache.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <btstack_tlv.h>
+
+#include "uni_log.h"
+
+// Must be a power of two.
+#define DEVICE_CACHE_SLOTS_PER_KIND 16
+
+// Different than the ones used by uni_property, and the ones used by BTstack.
+static const char tag_0 = 'B';
+static const char tag_1 = 'P';
+static const char tag_2 = 'C';
+
+typedef struct {
+    bd_addr_t addr;
+    uint8_t len;
+    uint8_t data[UNI_BT_DEVICE_CACHE_MAX_LEN];
+} __attribute__((packed)) device_cache_entry_t;
+
+static uint32_t get_tag(uni_bt_device_cache_kind_t kind, const bd_addr_t addr) {
+    uint8_t slot = 0;
+
+    for (int i = 0; i < BD_ADDR_LEN; i++)
+        slot ^= addr[i];
+    slot = (slot ^ (slot >> 4)) & (DEVICE_CACHE_SLOTS_PER_KIND - 1);
+
+    return (tag_0 << 24) | (tag_1 << 16) | (tag_2 << 8) | (kind << 4) | slot;
+}
+
+static bool get_tlv(const btstack_tlv_t** impl, void** context) {
+    btstack_tlv_get_instance(impl, context);
+    return *impl != NULL && *context != NULL;
+}
+
+bool uni_bt_device_cache_get(uni_bt_device_cache_kind_t kind, const bd_addr_t addr, void* data, int len) {
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    device_cache_entry_t entry;
+    int read;
+
+    if (len <= 0 || len > UNI_BT_DEVICE_CACHE_MAX_LEN || !get_tlv(&tlv_impl, &tlv_context))
+        return false;
+
+    read = tlv_impl->get_tag(tlv_context, get_tag(kind, addr), (uint8_t*)&entry, sizeof(entry));
+    if (read != (int)offsetof(device_cache_entry_t, data) + len || entry.len != len ||
+        bd_addr_cmp(entry.addr, addr) != 0)
+        return false;
+
+    memcpy(data, entry.data, len);
+    return true;
+}
+
+void uni_bt_device_cache_set(uni_bt_device_cache_kind_t kind, const bd_addr_t addr, const void* data, int len) {
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    device_cache_entry_t entry;
+    uint8_t current[UNI_BT_DEVICE_CACHE_MAX_LEN];
+
+    if (len <= 0 || len > UNI_BT_DEVICE_CACHE_MAX_LEN || !get_tlv(&tlv_impl, &tlv_context))
+        return;
+
+    // Avoid flash writes when nothing changed.
+    if (uni_bt_device_cache_get(kind, addr, current, len) && memcmp(current, data, len) == 0)
+        return;
+
+    bd_addr_copy(entry.addr, addr);
+    entry.len = len;
+    memcpy(entry.data, data, len);
+    if (tlv_impl->store_tag(tlv_context, get_tag(kind, addr), (const uint8_t*)&entry,
+                            offsetof(device_cache_entry_t, data) + len))
+        loge("Failed to store device cache for %s\n", bd_addr_to_str(addr));
+}
+
+void uni_bt_device_cache_delete(uni_bt_device_cache_kind_t kind, const bd_addr_t addr) {
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    device_cache_entry_t entry;
+    uint32_t tag = get_tag(kind, addr);
+
+    if (!get_tlv(&tlv_impl, &tlv_context))
+        return;
+
+    // Don't delete the entry of another device that shares the slot.
+    if (tlv_impl->get_tag(tlv_context, tag, (uint8_t*)&entry, sizeof(entry)) < (int)sizeof(entry.addr) ||
+        bd_addr_cmp(entry.addr, addr) != 0)
+        return;
+    tlv_impl->delete_tag(tlv_context, tag);
+}
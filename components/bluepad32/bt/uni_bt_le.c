@@ -62,6 +62,7 @@
 
 #include "sdkconfig.h"
 
+#include "bt/uni_bt_allowlist.h"
 #include "bt/uni_bt_conn.h"
 #include "bt/uni_bt_defines.h"
 #include "parser/uni_hid_parser.h"
@@ -71,8 +72,50 @@
 #include "uni_log.h"
 #include "uni_property.h"
 
+// Connection parameters requested once the HID service is connected.
+// Gamepads want the shortest interval with no slave latency. The interval is increased
+// when more devices are connected, to give the radio time to serve all of them.
+// All intervals are in 1.25ms units.
+#define CONN_INTERVAL_MIN 6           // 7.5ms, the minimum allowed by the spec
+#define CONN_INTERVAL_MAX 24          // 30ms
+#define CONN_INTERVAL_BACKOFF 6       // Added per each extra connected device: 7.5ms
+#define CONN_INTERVAL_TOLERANCE 2     // Max - min of the requested range: 2.5ms
+#define CONN_SUPERVISION_TIMEOUT 200  // 2s, in 10ms units
+
+typedef struct {
+    uni_controller_type_t controller_type;
+    uint16_t conn_interval_min;
+    uint16_t conn_latency;
+} conn_params_policy_t;
+
+// Only the controllers that differ from the default: CONN_INTERVAL_MIN with no slave latency.
+static const conn_params_policy_t conn_params_policies[] = {
+    // Keyboards don't need such short intervals, and they save battery
+    {CONTROLLER_TYPE_GenericKeyboard, 12, 4},
+};
+
+// Scan interval is fixed. The window changes according to the duty cycle requested by the scan scheduler.
+#define SCAN_INTERVAL 48   // 30ms, in 0.625ms units
+#define SCAN_WINDOW_MIN 4  // 2.5ms, the minimum allowed by the spec
+
 static bool is_scanning;
 static bool ble_enabled;
+static uint16_t scan_window = SCAN_INTERVAL;
+
+// Recently ignored advertisers: not HID controllers, or denied. In crowded places there are lots of
+// beacons advertising all the time. Caching them avoids parsing their advertising data over and over.
+// Scanning is passive, so the advertising data of each report is complete: no scan response is expected.
+#define ADV_CACHE_SIZE 16
+#define ADV_CACHE_TTL_MS 10000  // Entries expire, so that devices entering pairing mode get re-evaluated
+
+typedef struct {
+    bd_addr_t addr;
+    uint32_t ignored_ms;
+} adv_cache_entry_t;
+
+// Sorted from most to least recently seen.
+static adv_cache_entry_t adv_cache[ADV_CACHE_SIZE];
+static int adv_cache_len;
 
 // Temporal space for SDP in BLE
 static uint8_t hid_descriptor_storage[512];
@@ -193,6 +236,35 @@ static void get_advertisement_data(const uint8_t* adv_data, uint8_t adv_size, ui
     }
 }
 
+// Returns the entry for the address, and moves it to the front. NULL if not found.
+static adv_cache_entry_t* adv_cache_lookup(const bd_addr_t addr) {
+    adv_cache_entry_t entry;
+
+    for (int i = 0; i < adv_cache_len; i++) {
+        if (bd_addr_cmp(adv_cache[i].addr, addr) != 0)
+            continue;
+        entry = adv_cache[i];
+        memmove(&adv_cache[1], &adv_cache[0], i * sizeof(adv_cache[0]));
+        adv_cache[0] = entry;
+        return &adv_cache[0];
+    }
+    return NULL;
+}
+
+// Adds or updates the address. When full, the least recently seen entry is evicted.
+static void adv_cache_ignore(const bd_addr_t addr) {
+    adv_cache_entry_t* entry = adv_cache_lookup(addr);
+
+    if (entry == NULL) {
+        if (adv_cache_len < ADV_CACHE_SIZE)
+            adv_cache_len++;
+        memmove(&adv_cache[1], &adv_cache[0], (adv_cache_len - 1) * sizeof(adv_cache[0]));
+        entry = &adv_cache[0];
+        bd_addr_copy(entry->addr, addr);
+    }
+    entry->ignored_ms = btstack_run_loop_get_time_ms();
+}
+
 static void adv_event_get_data(const uint8_t* packet, uint16_t* appearance, char* name) {
     const uint8_t* ad_data;
     uint16_t ad_len;
@@ -205,17 +277,13 @@ static void adv_event_get_data(const uint8_t* packet, uint16_t* appearance, char
 }
 
 static void parse_report(uint8_t* packet, uint16_t size) {
-    uint16_t service_index;
     uint16_t hids_cid;
     uni_hid_device_t* device;
-    const uint8_t* descriptor_data;
-    uint16_t descriptor_len;
     const uint8_t* report_data;
     uint16_t report_len;
 
     ARG_UNUSED(size);
 
-    service_index = gattservice_subevent_hid_report_get_service_index(packet);
     hids_cid = gattservice_subevent_hid_report_get_hids_cid(packet);
     device = uni_hid_device_get_instance_for_hids_cid(hids_cid);
 
@@ -224,15 +292,6 @@ static void parse_report(uint8_t* packet, uint16_t size) {
         return;
     }
 
-    // FIXME: Copying the HID descriptor should be done at setup time since some device, like Xbox requires it
-    // to set the correct parser.
-    // But not clear how to get the "service_index" from setup
-    if (device->hid_descriptor_len == 0) {
-        descriptor_data = hids_client_descriptor_storage_get_descriptor_data(hids_cid, service_index);
-        descriptor_len = hids_client_descriptor_storage_get_descriptor_len(hids_cid, service_index);
-
-        uni_hid_device_set_hid_descriptor(device, descriptor_data, descriptor_len);
-    }
     report_data = gattservice_subevent_hid_report_get_report(packet);
     report_len = gattservice_subevent_hid_report_get_report_len(packet);
 
@@ -240,6 +299,85 @@ static void parse_report(uint8_t* packet, uint16_t size) {
     uni_hid_device_process_controller(device);
 }
 
+// The HID descriptor is needed before the device is ready, since some parsers, like Xbox, depend on it.
+static void set_hid_descriptor(uni_hid_device_t* device, uint16_t hids_cid, uint8_t num_instances) {
+    const uint8_t* descriptor_data;
+    uint16_t descriptor_len;
+
+    // Might have been set already, like when the name matches a known controller.
+    if (uni_hid_device_has_hid_descriptor(device))
+        return;
+
+    // Use the first HID service instance with a descriptor.
+    for (uint8_t service_index = 0; service_index < num_instances; service_index++) {
+        descriptor_len = hids_client_descriptor_storage_get_descriptor_len(hids_cid, service_index);
+        if (descriptor_len == 0)
+            continue;
+        descriptor_data = hids_client_descriptor_storage_get_descriptor_data(hids_cid, service_index);
+        uni_hid_device_set_hid_descriptor(device, descriptor_data, descriptor_len);
+        return;
+    }
+    loge("BLE: No HID descriptor found for hids_cid=%d\n", hids_cid);
+}
+
+static int get_le_ready_devices_count(void) {
+    int count = 0;
+
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        uni_hid_device_t* d = uni_hid_device_get_instance_for_idx(i);
+        if (d->conn.protocol == UNI_BT_CONN_PROTOCOL_BLE &&
+            uni_bt_conn_get_state(&d->conn) == UNI_BT_CONN_STATE_DEVICE_READY)
+            count++;
+    }
+    return count;
+}
+
+static void get_conn_params_policy(const uni_hid_device_t* d, int devices_count, conn_params_policy_t* out) {
+    out->controller_type = d->controller_type;
+    out->conn_interval_min = CONN_INTERVAL_MIN;
+    out->conn_latency = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(conn_params_policies); i++) {
+        if (conn_params_policies[i].controller_type == d->controller_type) {
+            *out = conn_params_policies[i];
+            break;
+        }
+    }
+
+    // Back off when more devices share the radio
+    if (devices_count > 1)
+        out->conn_interval_min += (devices_count - 1) * CONN_INTERVAL_BACKOFF;
+    out->conn_interval_min = btstack_min(out->conn_interval_min, CONN_INTERVAL_MAX);
+}
+
+// Requests the policy connection parameters to all the connected BLE devices, if not already in use.
+// Should be called when a BLE device is ready or disconnected.
+static void update_conn_params(void) {
+    conn_params_policy_t policy;
+    uint16_t interval_max;
+    int devices_count = get_le_ready_devices_count();
+
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        uni_hid_device_t* d = uni_hid_device_get_instance_for_idx(i);
+        if (d->conn.protocol != UNI_BT_CONN_PROTOCOL_BLE ||
+            uni_bt_conn_get_state(&d->conn) != UNI_BT_CONN_STATE_DEVICE_READY)
+            continue;
+
+        get_conn_params_policy(d, devices_count, &policy);
+        interval_max = btstack_min(policy.conn_interval_min + CONN_INTERVAL_TOLERANCE, CONN_INTERVAL_MAX);
+
+        if (d->conn.le_conn_interval >= policy.conn_interval_min && d->conn.le_conn_interval <= interval_max &&
+            d->conn.le_conn_latency == policy.conn_latency)
+            continue;
+
+        logi("BLE: %s requesting conn interval=%d-%d (1.25ms units), latency=%d\n", bd_addr_to_str(d->conn.btaddr),
+             policy.conn_interval_min, interval_max, policy.conn_latency);
+        if (gap_update_connection_parameters(d->conn.handle, policy.conn_interval_min, interval_max,
+                                             policy.conn_latency, CONN_SUPERVISION_TIMEOUT) != ERROR_CODE_SUCCESS)
+            loge("BLE: failed to update connection parameters for %s\n", bd_addr_to_str(d->conn.btaddr));
+    }
+}
+
 static void hids_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* packet, uint16_t size) {
     uint8_t status;
     uint16_t hids_cid;
@@ -290,9 +428,13 @@ static void hids_client_packet_handler(uint8_t packet_type, uint16_t channel, ui
                         logi("Client notifications enabled for for hids_cid=%d\n", hids_cid);
 #endif
 
+                    set_hid_descriptor(device, hids_cid,
+                                       gattservice_subevent_hid_service_connected_get_num_instances(packet));
                     uni_hid_device_guess_controller_type_from_pid_vid(device);
                     uni_hid_device_connect(device);
                     uni_hid_device_set_ready(device);
+                    // Controller type is known at this point
+                    update_conn_params();
 
                     resume_scanning_hint();
                     break;
@@ -335,6 +477,11 @@ static void hids_client_packet_handler(uint8_t packet_type, uint16_t channel, ui
             // Called when a client a hid report was written.
             // E.g.: "set rumble" was sent to the gamepad.
             // TODO: Inform the device that it is ready to write another hid report?
+            // BTstack emits it once the write response arrives, without the ATT status.
+            hids_cid = gattservice_subevent_hid_report_written_get_hids_cid(packet);
+            device = uni_hid_device_get_instance_for_hids_cid(hids_cid);
+            if (device && device->report_parser.set_report_result)
+                device->report_parser.set_report_result(device, true);
             break;
         default:
             logi("Unsupported gatt client event: 0x%02x\n", hci_event_gattservice_meta_get_subevent_code(packet));
@@ -681,6 +828,9 @@ void uni_bt_le_on_hci_event_le_meta(const uint8_t* packet, uint16_t size) {
             logi("Using con_handle: %#x\n", con_handle);
 
             uni_hid_device_set_connection_handle(device, con_handle);
+            device->conn.le_conn_interval = hci_subevent_le_connection_complete_get_conn_interval(packet);
+            device->conn.le_conn_latency = hci_subevent_le_connection_complete_get_conn_latency(packet);
+            device->conn.le_supervision_timeout = hci_subevent_le_connection_complete_get_supervision_timeout(packet);
             sm_request_pairing(con_handle);
 
             // Resume scanning
@@ -691,6 +841,26 @@ void uni_bt_le_on_hci_event_le_meta(const uint8_t* packet, uint16_t size) {
             // Safely ignore it, we handle the GAP advertising report instead
             break;
 
+        case HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE:
+            // Either requested by us, or by the peripheral
+            con_handle = hci_subevent_le_connection_update_complete_get_connection_handle(packet);
+            device = uni_hid_device_get_instance_for_connection_handle(con_handle);
+            if (!device)
+                break;
+            if (hci_subevent_le_connection_update_complete_get_status(packet) != ERROR_CODE_SUCCESS) {
+                loge("BLE: connection update failed for %s, status=%#x\n", bd_addr_to_str(device->conn.btaddr),
+                     hci_subevent_le_connection_update_complete_get_status(packet));
+                break;
+            }
+            device->conn.le_conn_interval = hci_subevent_le_connection_update_complete_get_conn_interval(packet);
+            device->conn.le_conn_latency = hci_subevent_le_connection_update_complete_get_conn_latency(packet);
+            device->conn.le_supervision_timeout =
+                hci_subevent_le_connection_update_complete_get_supervision_timeout(packet);
+            logi("BLE: %s conn interval=%d (1.25ms units), latency=%d, supervision timeout=%d (10ms units)\n",
+                 bd_addr_to_str(device->conn.btaddr), device->conn.le_conn_interval, device->conn.le_conn_latency,
+                 device->conn.le_supervision_timeout);
+            break;
+
         default:
             logd("Unsupported LE_META sub-event: %#x\n", subevent);
             break;
@@ -741,6 +911,7 @@ void uni_bt_le_on_gap_event_advertising_report(const uint8_t* packet, uint16_t s
     uint16_t cod;
     uint8_t rssi;
     char name[64];
+    adv_cache_entry_t* entry;
 
     appearance = 0;
     name[0] = 0;
@@ -753,6 +924,14 @@ void uni_bt_le_on_gap_event_advertising_report(const uint8_t* packet, uint16_t s
         return;
     }
 
+    // Cheapest checks first: the allowlist, and then whether it was ignored recently.
+    if (!uni_bt_allowlist_is_allowed_addr(addr))
+        return;
+
+    entry = adv_cache_lookup(addr);
+    if (entry && (btstack_run_loop_get_time_ms() - entry->ignored_ms) < ADV_CACHE_TTL_MS)
+        return;
+
     adv_event_get_data(packet, &appearance, name);
 
     if (appearance != UNI_BT_HID_APPEARANCE_GAMEPAD && appearance != UNI_BT_HID_APPEARANCE_JOYSTICK &&
@@ -760,6 +939,7 @@ void uni_bt_le_on_gap_event_advertising_report(const uint8_t* packet, uint16_t s
         // Don't log it. There too many devices advertising themselves.
         if (appearance != 0 || strlen(name) != 0)
             logd("Not a HID controller, appearance: %#x, name =%s\n", appearance, name);
+        adv_cache_ignore(addr);
         return;
     }
 
@@ -789,8 +969,13 @@ void uni_bt_le_on_gap_event_advertising_report(const uint8_t* packet, uint16_t s
     logi(", rssi %u dBm", rssi);
     logi(", name '%s'\n", name);
 
-    if (uni_hid_device_on_device_discovered(addr, name, cod, rssi) != UNI_ERROR_SUCCESS)
+    if (uni_hid_device_on_device_discovered(addr, name, cod, rssi) != UNI_ERROR_SUCCESS) {
+        // Denied, E.g: by the platform. Try again once the entry expires.
+        // Devices that are too far away are not cached, so that they are accepted as soon as they get closer.
+        if (rssi >= HID_DEVICE_MIN_RSSI)
+            adv_cache_ignore(addr);
         return;
+    }
 
     uni_hid_device_t* d = uni_hid_device_create(addr);
     if (!d) {
@@ -813,6 +998,9 @@ void uni_bt_le_on_hci_disconnection_complete(uint16_t channel, const uint8_t* pa
     ARG_UNUSED(packet);
     ARG_UNUSED(size);
 
+    // One less device sharing the radio: the remaining ones can use shorter intervals.
+    update_conn_params();
+
     resume_scanning_hint();
 }
 
@@ -908,7 +1096,7 @@ void uni_bt_le_setup(void) {
     // scan_parameters_service_client_init();
     device_information_service_client_init();
 
-    gap_set_scan_parameters(0 /* type: passive */, 48 /* interval */, 48 /* window */);
+    gap_set_scan_parameters(0 /* type: passive */, SCAN_INTERVAL, scan_window);
 }
 
 void uni_bt_le_scan_start(void) {
@@ -929,6 +1117,17 @@ void uni_bt_le_scan_stop(void) {
     is_scanning = false;
 }
 
+void uni_bt_le_scan_set_duty(uint8_t duty) {
+    uint16_t window = btstack_max(SCAN_INTERVAL * duty / 100, SCAN_WINDOW_MIN);
+
+    if (window == scan_window)
+        return;
+    scan_window = window;
+    logi("BLE scan window -> %d (0.625ms units)\n", scan_window);
+    // BTstack applies it even if it is already scanning
+    gap_set_scan_parameters(0 /* type: passive */, SCAN_INTERVAL, scan_window);
+}
+
 void uni_bt_le_disconnect(uni_hid_device_t* d) {
     // if (gap_get_connection_type(conn->handle) == GAP_CONNECTION_INVALID)
     //     return;
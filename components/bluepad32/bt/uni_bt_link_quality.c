@@ -0,0 +1,244 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#include "bt/uni_bt_link_quality.h"
+
+#include <btstack.h>
+
+#include "sdkconfig.h"
+
+#include "platform/uni_platform.h"
+#include "uni_common.h"
+#include "uni_log.h"
+#include "uni_property.h"
+
+// Only one HCI command is sent per tick, to keep the overhead low.
+#define LINK_QUALITY_TIMER_PERIOD_MS 100
+
+// Smoothed values use an EWMA with alpha = 1/4, and are stored in 1/16 units.
+#define LINK_QUALITY_EWMA_SHIFT 2
+#define LINK_QUALITY_FRACTION_BITS 4
+
+// Hysteresis, to avoid sending the event over and over when the values are around the threshold.
+#define LINK_QUALITY_HYSTERESIS 8  // Link quality units
+#define RSSI_HYSTERESIS 4          // dBm
+
+enum {
+    LINK_QUALITY_TASK_READ_RSSI = BIT(0),
+    LINK_QUALITY_TASK_READ_LINK_QUALITY = BIT(1),
+    LINK_QUALITY_TASK_READ_FAILED_CONTACT_COUNTER = BIT(2),
+};
+
+static btstack_timer_source_t link_quality_timer;
+static bool link_quality_timer_active;
+static int next_device_idx;
+static uint32_t sample_period_ms;
+static uint8_t link_quality_min;
+static int8_t rssi_min;
+
+static bool is_link_monitored(uni_hid_device_t* d) {
+    if (d == NULL || uni_hid_device_is_virtual_device(d))
+        return false;
+    if (d->conn.state != UNI_BT_CONN_STATE_DEVICE_READY || d->conn.handle == UNI_BT_CONN_HANDLE_INVALID)
+        return false;
+    return d->conn.protocol == UNI_BT_CONN_PROTOCOL_BR_EDR || d->conn.protocol == UNI_BT_CONN_PROTOCOL_BLE;
+}
+
+static int32_t ewma(int32_t avg, int32_t sample, bool first) {
+    sample <<= LINK_QUALITY_FRACTION_BITS;
+    if (first)
+        return sample;
+    return avg + ((sample - avg) >> LINK_QUALITY_EWMA_SHIFT);
+}
+
+static void update_link_quality_low(uni_hid_device_t* d, bool failed_contacts_increased) {
+    int rssi = d->conn.rssi_avg >> LINK_QUALITY_FRACTION_BITS;
+    int quality = d->conn.link_quality_avg >> LINK_QUALITY_FRACTION_BITS;
+    bool low;
+
+    if (d->conn.protocol == UNI_BT_CONN_PROTOCOL_BR_EDR) {
+        // Link Quality is vendor specific, but in all cases the higher the better.
+        if (d->conn.link_quality_low)
+            low = failed_contacts_increased || quality < link_quality_min + LINK_QUALITY_HYSTERESIS;
+        else
+            low = failed_contacts_increased || quality < link_quality_min;
+    } else {
+        // On BLE, RSSI is absolute.
+        if (d->conn.link_quality_low)
+            low = rssi < rssi_min + RSSI_HYSTERESIS;
+        else
+            low = rssi < rssi_min;
+    }
+
+    if (low == d->conn.link_quality_low)
+        return;
+    d->conn.link_quality_low = low;
+
+    if (low) {
+        logi("Link quality low for %s: rssi=%d dBm, link quality=%d, failed contacts=%d\n",
+             bd_addr_to_str(d->conn.btaddr), rssi, quality, d->conn.failed_contacts);
+        uni_get_platform()->on_oob_event(UNI_PLATFORM_OOB_LINK_QUALITY_LOW, d);
+    } else {
+        logi("Link quality recovered for %s\n", bd_addr_to_str(d->conn.btaddr));
+    }
+}
+
+// Sends at most one command. Returns true if a command was sent.
+static bool link_quality_run_tasks(uni_hid_device_t* d) {
+    if (d->conn.link_quality_tasks & LINK_QUALITY_TASK_READ_RSSI) {
+        // gap_read_rssi() gets queued by BTstack, no need to check whether the command can be sent now.
+        d->conn.link_quality_tasks &= ~LINK_QUALITY_TASK_READ_RSSI;
+        gap_read_rssi(d->conn.handle);
+        return true;
+    }
+
+    if (!d->conn.link_quality_tasks || !hci_can_send_command_packet_now())
+        return false;
+
+    if (d->conn.link_quality_tasks & LINK_QUALITY_TASK_READ_LINK_QUALITY) {
+        d->conn.link_quality_tasks &= ~LINK_QUALITY_TASK_READ_LINK_QUALITY;
+        hci_send_cmd(&hci_read_link_quality, d->conn.handle);
+        return true;
+    }
+
+    if (d->conn.link_quality_tasks & LINK_QUALITY_TASK_READ_FAILED_CONTACT_COUNTER) {
+        d->conn.link_quality_tasks &= ~LINK_QUALITY_TASK_READ_FAILED_CONTACT_COUNTER;
+        hci_send_cmd(&hci_read_failed_contact_counter, d->conn.handle);
+        return true;
+    }
+    return false;
+}
+
+static void link_quality_schedule_next(uint32_t now) {
+    // Round-robin, so that all connections get sampled at the same rate.
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        int idx = (next_device_idx + i) % CONFIG_BLUEPAD32_MAX_DEVICES;
+        uni_hid_device_t* d = uni_hid_device_get_instance_for_idx(idx);
+        if (!is_link_monitored(d) || (now - d->conn.link_quality_last_ms) < sample_period_ms)
+            continue;
+
+        d->conn.link_quality_last_ms = now;
+        d->conn.link_quality_tasks = LINK_QUALITY_TASK_READ_RSSI;
+        if (d->conn.protocol == UNI_BT_CONN_PROTOCOL_BR_EDR)
+            d->conn.link_quality_tasks |=
+                LINK_QUALITY_TASK_READ_LINK_QUALITY | LINK_QUALITY_TASK_READ_FAILED_CONTACT_COUNTER;
+        next_device_idx = (idx + 1) % CONFIG_BLUEPAD32_MAX_DEVICES;
+        return;
+    }
+}
+
+static void link_quality_timer_handler(btstack_timer_source_t* ts) {
+    uint32_t now = btstack_run_loop_get_time_ms();
+    bool any = false;
+    bool sent = false;
+
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        uni_hid_device_t* d = uni_hid_device_get_instance_for_idx(i);
+        if (!is_link_monitored(d))
+            continue;
+        any = true;
+        if (!sent)
+            sent = link_quality_run_tasks(d);
+    }
+
+    // Stop the timer when there are no more connections. Restarted on the next connection.
+    if (!any) {
+        link_quality_timer_active = false;
+        return;
+    }
+
+    if (!sent)
+        link_quality_schedule_next(now);
+
+    btstack_run_loop_set_timer(ts, LINK_QUALITY_TIMER_PERIOD_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+//
+// Public functions
+//
+void uni_bt_link_quality_setup(void) {
+    sample_period_ms = uni_property_get(UNI_PROPERTY_IDX_LINK_QUALITY_PERIOD).u32;
+    link_quality_min = uni_property_get(UNI_PROPERTY_IDX_LINK_QUALITY_MIN).u8;
+    rssi_min = -(int8_t)btstack_min(uni_property_get(UNI_PROPERTY_IDX_LINK_QUALITY_RSSI_MIN).u8, 127);
+
+    btstack_run_loop_set_timer_handler(&link_quality_timer, link_quality_timer_handler);
+}
+
+bool uni_bt_link_quality_get(const uni_hid_device_t* d, uni_bt_link_quality_t* out) {
+    if (d == NULL || d->conn.link_quality_samples == 0)
+        return false;
+
+    out->rssi = d->conn.rssi_avg >> LINK_QUALITY_FRACTION_BITS;
+    out->link_quality = d->conn.link_quality_avg >> LINK_QUALITY_FRACTION_BITS;
+    out->failed_contacts = d->conn.failed_contacts;
+    out->low = d->conn.link_quality_low;
+    return true;
+}
+
+void uni_bt_link_quality_on_device_ready(uni_hid_device_t* d) {
+    if (sample_period_ms == 0 || !is_link_monitored(d))
+        return;
+
+    // Sample it in the next tick
+    d->conn.link_quality_last_ms = btstack_run_loop_get_time_ms() - sample_period_ms;
+
+    if (!link_quality_timer_active) {
+        link_quality_timer_active = true;
+        btstack_run_loop_set_timer(&link_quality_timer, LINK_QUALITY_TIMER_PERIOD_MS);
+        btstack_run_loop_add_timer(&link_quality_timer);
+    }
+}
+
+void uni_bt_link_quality_on_gap_rssi_measurement(const uint8_t* packet, uint16_t size) {
+    ARG_UNUSED(size);
+
+    hci_con_handle_t handle = gap_event_rssi_measurement_get_con_handle(packet);
+    uni_hid_device_t* d = uni_hid_device_get_instance_for_connection_handle(handle);
+    if (!d) {
+        loge("Could not found device for connection handle: %x\n", handle);
+        return;
+    }
+
+    d->conn.rssi = gap_event_rssi_measurement_get_rssi(packet);
+    d->conn.rssi_avg = ewma(d->conn.rssi_avg, (int8_t)d->conn.rssi, d->conn.link_quality_samples == 0);
+    if (d->conn.link_quality_samples < UINT8_MAX)
+        d->conn.link_quality_samples++;
+
+    // BR/EDR gets evaluated once the rest of the values are read.
+    if (d->conn.protocol == UNI_BT_CONN_PROTOCOL_BLE)
+        update_link_quality_low(d, false);
+}
+
+void uni_bt_link_quality_on_hci_command_complete(const uint8_t* packet, uint16_t size) {
+    ARG_UNUSED(size);
+
+    uint16_t opcode = hci_event_command_complete_get_command_opcode(packet);
+    const uint8_t* param = hci_event_command_complete_get_return_parameters(packet);
+    uni_hid_device_t* d;
+    uint16_t failed_contacts;
+    bool increased;
+
+    if (opcode != HCI_OPCODE_HCI_READ_LINK_QUALITY && opcode != HCI_OPCODE_HCI_READ_FAILED_CONTACT_COUNTER)
+        return;
+
+    // Return parameters: status, connection handle, value.
+    if (param[0] != ERROR_CODE_SUCCESS)
+        return;
+    d = uni_hid_device_get_instance_for_connection_handle(little_endian_read_16(param, 1));
+    if (!d)
+        return;
+
+    if (opcode == HCI_OPCODE_HCI_READ_LINK_QUALITY) {
+        // link_quality_samples is updated by the RSSI, which is always read first.
+        d->conn.link_quality_avg = ewma(d->conn.link_quality_avg, param[3], d->conn.link_quality_samples <= 1);
+        return;
+    }
+
+    // Failed Contact Counter is the last value to be read.
+    failed_contacts = little_endian_read_16(param, 3);
+    increased = failed_contacts > d->conn.failed_contacts;
+    d->conn.failed_contacts = failed_contacts;
+    update_link_quality_low(d, increased);
+}
@@ -49,6 +49,7 @@
 
 #include <btstack.h>
 #include <inttypes.h>
+#include <string.h>
 
 #include "sdkconfig.h"
 
@@ -73,9 +74,17 @@ _Static_assert(SDP_QUERY_TIMEOUT_MS < HID_DEVICE_CONNECTION_TIMEOUT_MS, "Timeout
 static uint8_t sdp_attribute_value[MAX_ATTRIBUTE_VALUE_SIZE];
 static const unsigned int sdp_attribute_value_buffer_size = MAX_ATTRIBUTE_VALUE_SIZE;
 static uni_hid_device_t* sdp_device = NULL;
-static btstack_timer_source_t sdp_query_timer;
+
+// BTstack supports only one SDP query at the time. Devices that need an SDP query while another one
+// is in progress are queued, and served in order. Meanwhile, they can continue with the rest of the setup.
+static uni_hid_device_t* sdp_queue[CONFIG_BLUEPAD32_MAX_DEVICES];
+static int sdp_queue_len;
+// Used when the SDP client is still busy, like when finishing the query of a device that timed out.
+static btstack_context_callback_registration_t sdp_client_ready_registration;
+static bool sdp_client_ready_registered;
 
 static void sdp_query_timeout(btstack_timer_source_t* ts);
+static void sdp_query_next(void);
 
 // SDP Server
 static uint8_t device_id_sdp_service_buffer[100];
@@ -212,36 +221,106 @@ static void sdp_query_timeout(btstack_timer_source_t* ts) {
 
     logi("Failed to query SDP for %s, timeout\n", bd_addr_to_str(d->conn.btaddr));
     sdp_device = NULL;
+
+    // Dropping the connection also finishes the pending SDP query, which is needed to serve the next device.
+    uni_hid_device_disconnect(d);
+    uni_hid_device_delete(d);
+    /* 'd' is destroyed after this call, don't use it */
+
+    sdp_query_next();
+}
+
+static void sdp_client_ready_callback(void* context) {
+    ARG_UNUSED(context);
+    sdp_client_ready_registered = false;
+    sdp_query_next();
+}
+
+static bool sdp_queue_remove(uni_hid_device_t* d) {
+    for (int i = 0; i < sdp_queue_len; i++) {
+        if (sdp_queue[i] != d)
+            continue;
+        sdp_queue_len--;
+        memmove(&sdp_queue[i], &sdp_queue[i + 1], (sdp_queue_len - i) * sizeof(sdp_queue[0]));
+        return true;
+    }
+    return false;
+}
+
+static void sdp_query_next(void) {
+    uni_hid_device_t* d;
+
+    if (sdp_device != NULL || sdp_queue_len == 0)
+        return;
+
+    if (!sdp_client_ready()) {
+        // Try again once BTstack finishes the current query.
+        if (!sdp_client_ready_registered) {
+            sdp_client_ready_registered = true;
+            sdp_client_ready_registration.callback = &sdp_client_ready_callback;
+            sdp_client_register_query_callback(&sdp_client_ready_registration);
+        }
+        return;
+    }
+
+    d = sdp_queue[0];
+    sdp_queue_remove(d);
+
+    sdp_device = d;
+    btstack_run_loop_set_timer_context(&d->sdp_query_timer, d);
+    btstack_run_loop_set_timer_handler(&d->sdp_query_timer, &sdp_query_timeout);
+    btstack_run_loop_set_timer(&d->sdp_query_timer, SDP_QUERY_TIMEOUT_MS);
+    btstack_run_loop_add_timer(&d->sdp_query_timer);
+
+    uni_bt_sdp_query_start_vid_pid(d);
 }
 
 // Public functions
 
 void uni_bt_sdp_query_start(uni_hid_device_t* d) {
     logi("-----------> sdp_query_start()\n");
-    // Needed for the SDP query since it only supports one SDP query at the time.
-    if (sdp_device != NULL) {
-        logi("Another SDP query is in progress (%s), disconnecting...\n", bd_addr_to_str(sdp_device->conn.btaddr));
-        uni_hid_device_disconnect(d);
-        uni_hid_device_delete(d);
-        /* 'd'' is destroyed after this call, don't use it */
+
+    if (d == sdp_device)
+        return;
+    for (int i = 0; i < sdp_queue_len; i++) {
+        if (sdp_queue[i] == d)
+            return;
+    }
+    if (sdp_queue_len == (int)ARRAY_SIZE(sdp_queue)) {
+        loge("SDP queue full, cannot add %s\n", bd_addr_to_str(d->conn.btaddr));
         return;
     }
 
-    sdp_device = d;
-    btstack_run_loop_set_timer_context(&sdp_query_timer, d);
-    btstack_run_loop_set_timer_handler(&sdp_query_timer, &sdp_query_timeout);
-    btstack_run_loop_set_timer(&sdp_query_timer, SDP_QUERY_TIMEOUT_MS);
-    btstack_run_loop_add_timer(&sdp_query_timer);
+    sdp_queue[sdp_queue_len++] = d;
+    if (sdp_device != NULL)
+        logi("Another SDP query is in progress (%s), %s queued at position %d\n",
+             bd_addr_to_str(sdp_device->conn.btaddr), bd_addr_to_str(d->conn.btaddr), sdp_queue_len);
 
-    uni_bt_sdp_query_start_vid_pid(d);
+    sdp_query_next();
 }
 
 void uni_bt_sdp_query_end(uni_hid_device_t* d) {
     logi("<----------- sdp_query_end()\n");
     uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_SDP_HID_DESCRIPTOR_FETCHED);
     sdp_device = NULL;
-    btstack_run_loop_remove_timer(&sdp_query_timer);
+    btstack_run_loop_remove_timer(&d->sdp_query_timer);
     uni_bt_bredr_process_fsm(d);
+    /* 'd' might be invalid */
+
+    sdp_query_next();
+}
+
+void uni_bt_sdp_query_cancel(uni_hid_device_t* d) {
+    if (sdp_queue_remove(d))
+        logi("SDP query for %s removed from queue\n", bd_addr_to_str(d->conn.btaddr));
+
+    if (d != sdp_device)
+        return;
+
+    // The in-flight query finishes once the connection is dropped. The next query will start after that.
+    btstack_run_loop_remove_timer(&d->sdp_query_timer);
+    sdp_device = NULL;
+    sdp_query_next();
 }
 
 void uni_bt_sdp_query_start_vid_pid(uni_hid_device_t* d) {
@@ -252,9 +331,12 @@ void uni_bt_sdp_query_start_vid_pid(uni_hid_device_t* d) {
         sdp_client_query_uuid16(&handle_sdp_pid_query_result, d->conn.btaddr, BLUETOOTH_SERVICE_CLASS_PNP_INFORMATION);
     if (status != 0) {
         loge("Failed to perform SDP VID/PID query\n");
+        btstack_run_loop_remove_timer(&d->sdp_query_timer);
+        sdp_device = NULL;
         uni_hid_device_disconnect(d);
         uni_hid_device_delete(d);
         /* 'd' is destroyed after this call, don't use it */
+        sdp_query_next();
         return;
     }
 }
@@ -279,10 +361,12 @@ void uni_bt_sdp_query_start_hid_descriptor(uni_hid_device_t* d) {
                                              BLUETOOTH_SERVICE_CLASS_HUMAN_INTERFACE_DEVICE_SERVICE);
     if (status != 0) {
         loge("Failed to perform SDP query for %s. Removing it...\n", bd_addr_to_str(d->conn.btaddr));
-        btstack_run_loop_remove_timer(&sdp_query_timer);
+        btstack_run_loop_remove_timer(&d->sdp_query_timer);
+        sdp_device = NULL;
         uni_hid_device_disconnect(d);
         uni_hid_device_delete(d);
         /* 'd'' is destroyed after this call, don't use it */
+        sdp_query_next();
     }
 }
 
@@ -4,6 +4,8 @@
 
 #include "bt/uni_bt_service.h"
 
+#include <stddef.h>
+
 #include <btstack.h>
 
 #include "bt/uni_bt.h"
@@ -22,10 +24,14 @@
 #define APP_AD_FLAGS 0x06
 
 // Max number of clients that can connect to the service at the same time.
-#define MAX_NR_CLIENT_CONNECTIONS 1
+// E.g: a config app and a monitor.
+#define MAX_NR_CLIENT_CONNECTIONS 3
+
+// Notification payload when the client didn't negotiate a bigger ATT MTU: 20 (23 - 3)
+#define NOTIFICATION_MTU (ATT_DEFAULT_MTU - 3)
 
-// Don't know how to increate MTU for notification, so use the minimum which is 20 (23 - 3)
-#define NOTIFICATION_MTU 20
+// Large enough to hold all the devices in one notification
+#define NOTIFICATION_MAX_LEN (sizeof(compact_device_t) * CONFIG_BLUEPAD32_MAX_DEVICES)
 
 // Struct sent to the BLE client
 // A compact version of uni_hid_device_t.
@@ -41,22 +47,75 @@ typedef struct __attribute((packed)) {
 } compact_device_t;
 _Static_assert(sizeof(compact_device_t) <= NOTIFICATION_MTU, "compact_device_t too big");
 
+// Version of input_report_t. Should be updated when the format changes.
+#define INPUT_REPORT_VERSION 1
+
+// Min interval between input notifications of the same controller, unless the client changes it.
+#define INPUT_DEFAULT_MIN_INTERVAL_MS 20
+
+enum {
+    INPUT_REPORT_FLAG_IMU = BIT(0),  // gyro and accel are present
+};
+
+// Controller input, sent to the BLE client.
+// Gyro and accel are only sent when the controller has them, and the MTU is big enough.
+typedef struct __attribute((packed)) {
+    uint8_t version;  // INPUT_REPORT_VERSION
+    uint8_t idx;      // device index number: 0...CONFIG_BLUEPAD32_MAX_DEVICES-1
+    uint8_t flags;    // INPUT_REPORT_FLAG_
+    uint8_t dpad;
+    uint16_t buttons;
+    uint8_t misc_buttons;
+    int16_t axis_x;
+    int16_t axis_y;
+    int16_t axis_rx;
+    int16_t axis_ry;
+    int16_t brake;
+    int16_t throttle;
+    uint8_t battery;
+
+    // Optional
+    int16_t gyro[3];
+    int16_t accel[3];
+} input_report_t;
+#define INPUT_REPORT_NO_IMU_LEN (offsetof(input_report_t, gyro))
+_Static_assert(INPUT_REPORT_NO_IMU_LEN <= NOTIFICATION_MTU, "input_report_t too big");
+
 // client connection
 typedef struct {
     bool notification_enabled;
     uint16_t value_handle;
     hci_con_handle_t connection_handle;
+    // Max payload for a notification: ATT MTU - 3
+    uint16_t notification_mtu;
+    // Devices whose state changed, and were not notified yet. One bit per device.
+    uint32_t dirty_devices;
+
+    // Controller input stream
+    bool input_notification_enabled;
+    uint16_t input_min_interval_ms;
+    // Devices with new input, not notified yet. One bit per device.
+    uint32_t dirty_inputs;
+    uint32_t input_last_notified_ms[CONFIG_BLUEPAD32_MAX_DEVICES];
+    // Where to start looking for dirty input, so that all devices get notified in turn.
+    uint8_t next_input_idx;
+
+    // Each client needs its own registration: BTstack keeps them in a per-connection list,
+    // and serves the connections in round-robin.
+    btstack_context_callback_registration_t send_request;
 } client_connection_t;
 static client_connection_t client_connections[MAX_NR_CLIENT_CONNECTIONS];
 
-// Iterate all over the connected clients, but only one is supported. Hardcoded to 0, don't change.
-static int notification_connection_idx;
-// Iterate all over the connected controllers
-static int notification_device_idx;
-
+// Shared by all clients: serialized once when a device changes, regardless of the number of clients.
 static compact_device_t compact_devices[CONFIG_BLUEPAD32_MAX_DEVICES];
+static input_report_t input_reports[CONFIG_BLUEPAD32_MAX_DEVICES];
 static bool service_enabled;
 
+// Wakes up the notifications that were delayed by the input rate cap.
+static btstack_timer_source_t input_rate_timer;
+static bool input_rate_timer_active;
+static uint32_t input_rate_timer_deadline_ms;
+
 // clang-format off
 static const uint8_t adv_data[] = {
     // Flags general discoverable
@@ -84,61 +143,214 @@ static uint16_t att_read_callback(hci_con_handle_t conn_handle,
                                   uint8_t* buffer,
                                   uint16_t buffer_size);
 static client_connection_t* connection_for_conn_handle(hci_con_handle_t conn_handle);
-static bool next_notify_device(void);
-static void notify_client(void);
+static void notify_client(void* context);
 static void maybe_notify_client();
 
-static bool is_notify_client_valid(void) {
-    return ((client_connections[notification_connection_idx].connection_handle != HCI_CON_HANDLE_INVALID) &&
-            (client_connections[notification_connection_idx].notification_enabled));
+static void request_can_send_now(client_connection_t* ctx) {
+    // No-op if the request is already queued.
+    ctx->send_request.callback = &notify_client;
+    ctx->send_request.context = ctx;
+    att_server_request_to_send_notification(&ctx->send_request, ctx->connection_handle);
+}
+
+// Returns the devices with input that can be notified now, honoring the client rate cap.
+// "next_ms" returns how long to wait for the rest, if any.
+static uint32_t ready_inputs(const client_connection_t* ctx, uint32_t now, uint32_t* next_ms) {
+    uint32_t ready = 0;
+
+    *next_ms = UINT32_MAX;
+    if (!ctx->input_notification_enabled)
+        return 0;
+
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        if (!(ctx->dirty_inputs & BIT(i)))
+            continue;
+        uint32_t elapsed = now - ctx->input_last_notified_ms[i];
+        if (elapsed >= ctx->input_min_interval_ms)
+            ready |= BIT(i);
+        else
+            *next_ms = btstack_min(*next_ms, ctx->input_min_interval_ms - elapsed);
+    }
+    return ready;
 }
 
-static bool next_notify_device(void) {
-    // TODO: For simplicity, we send all 4 devices.
-    // But we should only send the connected ones.
-    notification_device_idx++;
-    if (notification_device_idx == CONFIG_BLUEPAD32_MAX_DEVICES) {
-        notification_device_idx = 0;
+static bool has_pending_notifications(const client_connection_t* ctx) {
+    uint32_t next_ms;
+
+    if (ctx->connection_handle == HCI_CON_HANDLE_INVALID)
+        return false;
+    if (ctx->notification_enabled && ctx->dirty_devices)
         return true;
+    return ready_inputs(ctx, btstack_run_loop_get_time_ms(), &next_ms) != 0;
+}
+
+static void input_rate_timer_handler(btstack_timer_source_t* ts) {
+    ARG_UNUSED(ts);
+    input_rate_timer_active = false;
+    maybe_notify_client();
+}
+
+static void schedule_input_rate_timer(uint32_t timeout_ms) {
+    uint32_t deadline_ms = btstack_run_loop_get_time_ms() + timeout_ms;
+
+    // Shared by all clients: keep the earliest deadline, so that no client gets throttled
+    // to the interval of another one.
+    if (input_rate_timer_active) {
+        if ((int32_t)(deadline_ms - input_rate_timer_deadline_ms) >= 0)
+            return;
+        btstack_run_loop_remove_timer(&input_rate_timer);
     }
-    return false;
+    input_rate_timer_active = true;
+    input_rate_timer_deadline_ms = deadline_ms;
+    btstack_run_loop_set_timer_handler(&input_rate_timer, input_rate_timer_handler);
+    btstack_run_loop_set_timer(&input_rate_timer, timeout_ms);
+    btstack_run_loop_add_timer(&input_rate_timer);
 }
 
-static void notify_client(void) {
-    logd("Notifying client idx = %d, device idx = %d\n", notification_connection_idx, notification_device_idx);
+// Returns true if a notification was sent.
+static bool notify_client_devices(client_connection_t* ctx) {
+    uint8_t buf[NOTIFICATION_MAX_LEN];
+    uint16_t len = 0;
     uint8_t status;
-    client_connection_t* ctx;
-    bool finish_round;
 
-    if (!is_notify_client_valid())
-        return;
+    if (!ctx->notification_enabled)
+        return false;
+
+    // Pack as many changed devices as the MTU allows. Each entry has its own "idx".
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        if (!(ctx->dirty_devices & BIT(i)))
+            continue;
+        if (len + sizeof(compact_devices[0]) > ctx->notification_mtu)
+            break;
+        memcpy(&buf[len], &compact_devices[i], sizeof(compact_devices[0]));
+        len += sizeof(compact_devices[0]);
+        ctx->dirty_devices &= ~BIT(i);
+    }
 
-    ctx = &client_connections[notification_connection_idx];
+    if (len == 0)
+        return false;
 
-    // send
-    status = att_server_notify(ctx->connection_handle, ctx->value_handle,
-                               (const uint8_t*)&compact_devices[notification_device_idx], sizeof(compact_devices[0]));
+    status = att_server_notify(ctx->connection_handle, ctx->value_handle, buf, len);
     if (status != ERROR_CODE_SUCCESS) {
         loge("BLE Service: Failed to notify client, error: %#x\n", status);
     }
+    return true;
+}
 
-    finish_round = next_notify_device();
-    if (!finish_round)
-        att_server_request_can_send_now_event(ctx->connection_handle);
+// Returns true if a notification was sent.
+static bool notify_client_input(client_connection_t* ctx) {
+    uint32_t now = btstack_run_loop_get_time_ms();
+    uint32_t next_ms;
+    uint8_t status;
+
+    uint32_t ready = ready_inputs(ctx, now, &next_ms);
+    if (next_ms != UINT32_MAX)
+        schedule_input_rate_timer(next_ms);
+    if (!ready)
+        return false;
+
+    // One controller per notification, in round-robin.
+    int idx = ctx->next_input_idx;
+    while (!(ready & BIT(idx)))
+        idx = (idx + 1) % CONFIG_BLUEPAD32_MAX_DEVICES;
+    ctx->next_input_idx = (idx + 1) % CONFIG_BLUEPAD32_MAX_DEVICES;
+    const input_report_t* report = &input_reports[idx];
+    uint16_t len = sizeof(*report);
+    if (!(report->flags & INPUT_REPORT_FLAG_IMU) || len > ctx->notification_mtu)
+        len = INPUT_REPORT_NO_IMU_LEN;
+
+    status = att_server_notify(ctx->connection_handle,
+                               ATT_CHARACTERISTIC_4627C4A4_AC0E_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE,
+                               (const uint8_t*)report, len);
+    if (status != ERROR_CODE_SUCCESS) {
+        loge("BLE Service: Failed to notify input, error: %#x\n", status);
+    }
+    ctx->dirty_inputs &= ~BIT(idx);
+    ctx->input_last_notified_ms[idx] = now;
+    return true;
+}
+
+// Sends at most one notification, and queues itself again if there is more to send.
+// That gives the other clients a chance to send theirs.
+static void notify_client(void* context) {
+    client_connection_t* ctx = context;
+
+    if (ctx->connection_handle == HCI_CON_HANDLE_INVALID)
+        return;
+
+    logd("Notifying client handle = %#x, dirty devices = %#x, dirty inputs = %#x\n", ctx->connection_handle,
+         ctx->dirty_devices, ctx->dirty_inputs);
+
+    // Connection changes have priority over input.
+    if (!notify_client_devices(ctx))
+        notify_client_input(ctx);
+
+    if (has_pending_notifications(ctx))
+        request_can_send_now(ctx);
+}
+
+static void mark_device_dirty(int idx) {
+    for (int i = 0; i < MAX_NR_CLIENT_CONNECTIONS; i++)
+        client_connections[i].dirty_devices |= BIT(idx);
+}
+
+// Updates the compact device, and marks it as dirty only if it changed.
+static void update_compact_device(int idx, const compact_device_t* cd) {
+    if (memcmp(&compact_devices[idx], cd, sizeof(*cd)) == 0)
+        return;
+    compact_devices[idx] = *cd;
+    mark_device_dirty(idx);
+    maybe_notify_client();
 }
 
 static void maybe_notify_client(void) {
-    client_connection_t* ctx = NULL;
+    uint32_t next_ms;
 
     for (int i = 0; i < MAX_NR_CLIENT_CONNECTIONS; i++) {
-        if (client_connections[i].connection_handle != HCI_CON_HANDLE_INVALID &&
-            client_connections[i].notification_enabled) {
-            ctx = &client_connections[i];
-            break;
+        client_connection_t* ctx = &client_connections[i];
+        if (has_pending_notifications(ctx)) {
+            request_can_send_now(ctx);
+            continue;
+        }
+        // Input held back by the rate cap: try again when it expires.
+        if (ctx->connection_handle != HCI_CON_HANDLE_INVALID) {
+            ready_inputs(ctx, btstack_run_loop_get_time_ms(), &next_ms);
+            if (next_ms != UINT32_MAX)
+                schedule_input_rate_timer(next_ms);
         }
     }
-    if (ctx)
-        att_server_request_can_send_now_event(ctx->connection_handle);
+}
+
+static int16_t clamp_int16(int32_t v) {
+    return (int16_t)btstack_max(INT16_MIN, btstack_min(INT16_MAX, v));
+}
+
+// Serialized once per controller report, regardless of the number of clients.
+static void encode_input_report(int idx, const uni_controller_t* ctl, input_report_t* report) {
+    const uni_gamepad_t* gp = &ctl->gamepad;
+
+    memset(report, 0, sizeof(*report));
+    report->version = INPUT_REPORT_VERSION;
+    report->idx = idx;
+    report->dpad = gp->dpad;
+    report->buttons = gp->buttons;
+    report->misc_buttons = gp->misc_buttons;
+    report->axis_x = clamp_int16(gp->axis_x);
+    report->axis_y = clamp_int16(gp->axis_y);
+    report->axis_rx = clamp_int16(gp->axis_rx);
+    report->axis_ry = clamp_int16(gp->axis_ry);
+    report->brake = clamp_int16(gp->brake);
+    report->throttle = clamp_int16(gp->throttle);
+    report->battery = ctl->battery;
+
+    bool has_imu = false;
+    for (int i = 0; i < 3; i++) {
+        report->gyro[i] = clamp_int16(gp->gyro[i]);
+        report->accel[i] = clamp_int16(gp->accel[i]);
+        has_imu |= (gp->gyro[i] != 0 || gp->accel[i] != 0);
+    }
+    if (has_imu)
+        report->flags |= INPUT_REPORT_FLAG_IMU;
 }
 
 static int att_write_callback(hci_con_handle_t con_handle,
@@ -179,13 +391,39 @@ static int att_write_callback(hci_con_handle_t con_handle,
             ctx->notification_enabled =
                 little_endian_read_16(buffer, 0) == GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION;
             ctx->value_handle = ATT_CHARACTERISTIC_4627C4A4_AC06_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE;
-            if (ctx->notification_enabled)
-                att_server_request_can_send_now_event(ctx->connection_handle);
+            if (ctx->notification_enabled) {
+                // Send the initial state of all the devices
+                ctx->dirty_devices = BIT(CONFIG_BLUEPAD32_MAX_DEVICES) - 1;
+                request_can_send_now(ctx);
+            }
 
             logi("BLE Service: Notification enabled = %d for handle %#x\n", ctx->notification_enabled,
                  ctx->connection_handle);
             break;
         }
+        case ATT_CHARACTERISTIC_4627C4A4_AC0E_46B9_B688_AFC5C1BF7F63_01_CLIENT_CONFIGURATION_HANDLE: {
+            // Notify controller input
+            ctx = connection_for_conn_handle(con_handle);
+            if (!ctx)
+                return ATT_ERROR_REQUEST_NOT_SUPPORTED;
+            ctx->input_notification_enabled =
+                little_endian_read_16(buffer, 0) == GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION;
+            ctx->dirty_inputs = 0;
+
+            logi("BLE Service: Input notification enabled = %d for handle %#x\n", ctx->input_notification_enabled,
+                 ctx->connection_handle);
+            break;
+        }
+        case ATT_CHARACTERISTIC_4627C4A4_AC0F_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE: {
+            // Min interval in ms between input notifications of the same controller
+            if (buffer_size != 2 || offset != 0)
+                return ATT_ERROR_REQUEST_NOT_SUPPORTED;
+            ctx = connection_for_conn_handle(con_handle);
+            if (!ctx)
+                return ATT_ERROR_REQUEST_NOT_SUPPORTED;
+            ctx->input_min_interval_ms = little_endian_read_16(buffer, 0);
+            break;
+        }
         case ATT_CHARACTERISTIC_4627C4A4_AC07_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE: {
             // Mappings: Nintendo or Xbox: A,B,X,Y vs B,A,Y,X
             if (buffer_size != 1 || offset != 0)
@@ -260,7 +498,7 @@ static uint16_t att_read_callback(hci_con_handle_t conn_handle,
                                   uint16_t offset,
                                   uint8_t* buffer,
                                   uint16_t buffer_size) {
-    ARG_UNUSED(conn_handle);
+    client_connection_t* ctx;
 
     switch (att_handle) {
         case ATT_CHARACTERISTIC_4627C4A4_AC01_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE:
@@ -287,9 +525,7 @@ static uint16_t att_read_callback(hci_con_handle_t conn_handle,
             return att_read_callback_handle_blob((const void*)compact_devices, (uint16_t)sizeof(compact_devices),
                                                  offset, buffer, buffer_size);
         case ATT_CHARACTERISTIC_4627C4A4_AC06_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE:
-            // Notify all connected devices, only when there is a change, one at a time.
-            // Ideally it should be merged with the previous one, but don't know how to increase
-            // the MTU for the notify package.
+            // Notify the devices that changed. As many as the MTU allows per notification.
             // Notify only. Read not supported.
             loge("BLE Service: 4627C4A4_AC06_46B9_B688_AFC5C1BF7F63 does not support read\n");
             break;
@@ -325,6 +561,19 @@ static uint16_t att_read_callback(hci_con_handle_t conn_handle,
             // Delete stored Bluetooth bond keys
             loge("BLE Service: 4627C4A4_AC0C_46B9_B688_AFC5C1BF7F63 does not support read\n");
             break;
+        case ATT_CHARACTERISTIC_4627C4A4_AC0E_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE:
+            // Controller input. Notify only.
+            loge("BLE Service: 4627C4A4_AC0E_46B9_B688_AFC5C1BF7F63 does not support read\n");
+            break;
+        case ATT_CHARACTERISTIC_4627C4A4_AC0F_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE: {
+            // Min interval in ms between input notifications of the same controller
+            uint8_t interval[2];
+            ctx = connection_for_conn_handle(conn_handle);
+            if (!ctx)
+                break;
+            little_endian_store_16(interval, 0, ctx->input_min_interval_ms);
+            return att_read_callback_handle_blob(interval, (uint16_t)sizeof(interval), offset, buffer, buffer_size);
+        }
 
         case ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_BATTERY_LEVEL_01_VALUE_HANDLE:
             break;
@@ -380,7 +629,9 @@ static void att_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* p
             if (!ctx)
                 break;
             ctx->connection_handle = att_event_connected_get_handle(packet);
+            ctx->input_min_interval_ms = INPUT_DEFAULT_MIN_INTERVAL_MS;
             mtu = att_server_get_mtu(ctx->connection_handle);
+            ctx->notification_mtu = btstack_max(mtu - 3, NOTIFICATION_MTU);
             logi("BLE Service: New client connected handle = %#x, mtu = %d\n", ctx->connection_handle, mtu);
             break;
         case ATT_EVENT_MTU_EXCHANGE_COMPLETE:
@@ -388,10 +639,9 @@ static void att_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* p
             ctx = connection_for_conn_handle(att_event_mtu_exchange_complete_get_handle(packet));
             if (!ctx)
                 break;
-            break;
-        case ATT_EVENT_CAN_SEND_NOW:
-            printf_hexdump(packet, size);
-            notify_client();
+            ctx->notification_mtu = btstack_max(mtu, NOTIFICATION_MTU);
+            logi("BLE Service: MTU exchanged, handle = %#x, notification mtu = %d\n", ctx->connection_handle,
+                 ctx->notification_mtu);
             break;
         case ATT_EVENT_DISCONNECTED:
             ctx = connection_for_conn_handle(att_event_disconnected_get_handle(packet));
@@ -421,6 +671,10 @@ static void att_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* p
 }
 
 void uni_bt_service_deinit(void) {
+    if (input_rate_timer_active) {
+        btstack_run_loop_remove_timer(&input_rate_timer);
+        input_rate_timer_active = false;
+    }
     att_server_deinit();
     gap_advertisements_enable(false);
 }
@@ -443,6 +697,7 @@ void uni_bt_service_init(void) {
 
     memset(null_addr, 0, 6);
     memset(compact_devices, 0, sizeof(compact_devices));
+    memset(input_reports, 0, sizeof(input_reports));
     memset(&client_connections, 0, sizeof(client_connections));
     for (int i = 0; i < MAX_NR_CLIENT_CONNECTIONS; i++)
         client_connections[i].connection_handle = HCI_CON_HANDLE_INVALID;
@@ -452,6 +707,9 @@ void uni_bt_service_init(void) {
     // register for ATT events
     att_server_register_packet_handler(att_packet_handler);
 
+    // Keep advertising until all the client slots are taken.
+    gap_set_max_number_peripheral_connections(MAX_NR_CLIENT_CONNECTIONS);
+
     gap_advertisements_set_params(adv_int_min, adv_int_max, adv_type, 0, null_addr, 0x07, 0x00);
     gap_advertisements_set_data(adv_data_len, (uint8_t*)adv_data);
     gap_advertisements_enable(true);
@@ -485,10 +743,10 @@ void uni_bt_service_on_device_ready(const uni_hid_device_t* d) {
         return;
 
     // Update the things that could have changed from "on_device_connected" callback.
-    compact_devices[idx].controller_subtype = d->controller_subtype;
-    compact_devices[idx].state = d->conn.connected;
-
-    maybe_notify_client();
+    compact_device_t cd = compact_devices[idx];
+    cd.controller_subtype = d->controller_subtype;
+    cd.state = d->conn.connected;
+    update_compact_device(idx, &cd);
 }
 
 void uni_bt_service_on_device_connected(const uni_hid_device_t* d) {
@@ -501,15 +759,15 @@ void uni_bt_service_on_device_connected(const uni_hid_device_t* d) {
     int idx = uni_hid_device_get_idx_for_instance(d);
     if (idx < 0)
         return;
-    compact_devices[idx].vendor_id = d->vendor_id;
-    compact_devices[idx].product_id = d->product_id;
-    compact_devices[idx].controller_type = d->controller_type;
-    compact_devices[idx].controller_subtype = d->controller_subtype;
-    memcpy(compact_devices[idx].addr, d->conn.btaddr, 6);
-    compact_devices[idx].state = d->conn.state;
-    compact_devices[idx].incoming = d->conn.incoming;
-
-    maybe_notify_client();
+    compact_device_t cd = compact_devices[idx];
+    cd.vendor_id = d->vendor_id;
+    cd.product_id = d->product_id;
+    cd.controller_type = d->controller_type;
+    cd.controller_subtype = d->controller_subtype;
+    memcpy(cd.addr, d->conn.btaddr, 6);
+    cd.state = d->conn.state;
+    cd.incoming = d->conn.incoming;
+    update_compact_device(idx, &cd);
 }
 
 void uni_bt_service_on_device_disconnected(const uni_hid_device_t* d) {
@@ -522,8 +780,44 @@ void uni_bt_service_on_device_disconnected(const uni_hid_device_t* d) {
     int idx = uni_hid_device_get_idx_for_instance(d);
     if (idx < 0)
         return;
-    memset(&compact_devices[idx], 0, sizeof(compact_devices[0]));
-    compact_devices[idx].idx = idx;
+    compact_device_t cd = {0};
+    cd.idx = idx;
+    update_compact_device(idx, &cd);
+}
 
+void uni_bt_service_on_controller_data(const uni_hid_device_t* d, const uni_controller_t* ctl) {
+    // Must be called from BTstack task
+    if (!d || !ctl)
+        return;
+    if (!service_enabled)
+        return;
+    if (ctl->klass != UNI_CONTROLLER_CLASS_GAMEPAD)
+        return;
+
+    int idx = uni_hid_device_get_idx_for_instance(d);
+    if (idx < 0)
+        return;
+
+    bool wanted = false;
+    for (int i = 0; i < MAX_NR_CLIENT_CONNECTIONS; i++) {
+        if (client_connections[i].connection_handle != HCI_CON_HANDLE_INVALID &&
+            client_connections[i].input_notification_enabled) {
+            wanted = true;
+            break;
+        }
+    }
+    if (!wanted)
+        return;
+
+    input_report_t report;
+    encode_input_report(idx, ctl, &report);
+    if (memcmp(&report, &input_reports[idx], sizeof(report)) == 0)
+        return;
+    input_reports[idx] = report;
+
+    for (int i = 0; i < MAX_NR_CLIENT_CONNECTIONS; i++) {
+        if (client_connections[i].input_notification_enabled)
+            client_connections[i].dirty_inputs |= BIT(idx);
+    }
     maybe_notify_client();
 }
@@ -13,6 +13,7 @@
 #include "bt/uni_bt_defines.h"
 #include "bt/uni_bt_hci_cmd.h"
 #include "bt/uni_bt_le.h"
+#include "bt/uni_bt_link_quality.h"
 #include "bt/uni_bt_service.h"
 #include "platform/uni_platform.h"
 #include "uni_common.h"
@@ -153,6 +154,8 @@ int uni_bt_setup(void) {
     if (IS_ENABLED(UNI_ENABLE_BLE) && ble_enabled)
         uni_bt_le_setup();
 
+    uni_bt_link_quality_setup();
+
     // Initialize HID Host
     // hid_host_init(hid_descriptor_storage, sizeof(hid_descriptor_storage));
     // hid_host_register_packet_handler(uni_bt_packet_handler);
@@ -0,0 +1,272 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#include "controller/uni_axis_shaping.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "uni_log.h"
+#include "uni_property.h"
+
+// Sticks go from -512 to 511. Pedals from 0 to 1023.
+_Static_assert(UNI_AXIS_SHAPING_LUT_SIZE == 1024, "Update the stick / pedal conversions");
+
+static uni_axis_shaping_t global_shaping;
+
+static uint32_t isqrt32(uint32_t v) {
+    uint32_t res = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > v)
+        bit >>= 2;
+    while (bit != 0) {
+        if (v >= res + bit) {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return res;
+}
+
+static bool is_curve_valid(const uni_axis_curve_t* curve) {
+    int prev_x = 0;
+
+    if (curve->deadzone >= UNI_AXIS_SHAPING_MAX || curve->anti_deadzone >= UNI_AXIS_SHAPING_MAX ||
+        curve->expo > UNI_AXIS_SHAPING_MAX || curve->num_points > UNI_AXIS_SHAPING_MAX_POINTS)
+        return false;
+
+    for (int i = 0; i < curve->num_points; i++) {
+        if (curve->points[i].x <= prev_x || curve->points[i].x >= UNI_AXIS_SHAPING_MAX ||
+            curve->points[i].y > UNI_AXIS_SHAPING_MAX)
+            return false;
+        prev_x = curve->points[i].x;
+    }
+    return true;
+}
+
+static int32_t eval_points(const uni_axis_curve_t* curve, int32_t t) {
+    uni_axis_point_t p0 = {0, 0};
+    uni_axis_point_t p1 = {UNI_AXIS_SHAPING_MAX, UNI_AXIS_SHAPING_MAX};
+
+    for (int i = 0; i < curve->num_points; i++) {
+        if (curve->points[i].x >= t) {
+            p1 = curve->points[i];
+            break;
+        }
+        p0 = curve->points[i];
+    }
+    return p0.y + (t - p0.x) * (p1.y - p0.y) / (p1.x - p0.x);
+}
+
+static int32_t eval_expo(const uni_axis_curve_t* curve, int32_t t) {
+    // Blend between linear and cubic: t + expo * (t^3 - t).
+    int64_t t3 = (int64_t)t * t * t / (UNI_AXIS_SHAPING_MAX * UNI_AXIS_SHAPING_MAX);
+    return t + (int32_t)((curve->expo * (t3 - t)) / UNI_AXIS_SHAPING_MAX);
+}
+
+// Returns true if the curve does nothing.
+static bool compile_curve(const uni_axis_curve_t* curve, int16_t* lut) {
+    static const uni_axis_curve_t linear = {0};
+
+    if (!is_curve_valid(curve)) {
+        loge("Axis shaping: invalid curve, using linear\n");
+        curve = &linear;
+    }
+
+    for (int32_t i = 0; i < UNI_AXIS_SHAPING_LUT_SIZE; i++) {
+        if (i == 0 || i <= curve->deadzone) {
+            lut[i] = 0;
+            continue;
+        }
+        // Stretch what is left after the deadzone to the whole range, and back to the anti-deadzone.
+        int32_t t = (i - curve->deadzone) * UNI_AXIS_SHAPING_MAX / (UNI_AXIS_SHAPING_MAX - curve->deadzone);
+        int32_t y = curve->num_points ? eval_points(curve, t) : eval_expo(curve, t);
+        lut[i] = curve->anti_deadzone + y * (UNI_AXIS_SHAPING_MAX - curve->anti_deadzone) / UNI_AXIS_SHAPING_MAX;
+    }
+
+    return curve->deadzone == 0 && curve->anti_deadzone == 0 && curve->expo == 0 && curve->num_points == 0;
+}
+
+// Sticks use the table from 0 to 511, so that 511 and -511 are full deflection. -512 saturates.
+// Rounded, so that a linear table gives back the same value.
+static int32_t stick_to_index(int32_t v) {
+    v = (abs(v) * UNI_AXIS_SHAPING_MAX + 255) / 511;
+    return (v > UNI_AXIS_SHAPING_MAX) ? UNI_AXIS_SHAPING_MAX : v;
+}
+
+static int32_t index_to_stick(int32_t v) {
+    return (v * 511 + UNI_AXIS_SHAPING_MAX / 2) / UNI_AXIS_SHAPING_MAX;
+}
+
+static int32_t clamp_stick(int32_t v) {
+    return (v < -512) ? -512 : (v > 511) ? 511 : v;
+}
+
+static void apply_stick(const uni_axis_shaping_t* shaping, int32_t* x, int32_t* y) {
+    if (shaping->stick_axial) {
+        int32_t new_x = index_to_stick(shaping->stick[stick_to_index(*x)]);
+        int32_t new_y = index_to_stick(shaping->stick[stick_to_index(*y)]);
+        *x = (*x < 0) ? -new_x : new_x;
+        *y = (*y < 0) ? -new_y : new_y;
+        return;
+    }
+
+    // Radial: scale the vector, so that the direction is preserved.
+    int32_t r = isqrt32((*x) * (*x) + (*y) * (*y));
+    if (r == 0)
+        return;
+    // Square gates go beyond the circle: the diagonals have r > 511. Scale them by the saturated radius
+    // instead of "r", and clamp each axis, so that the corners still reach full deflection.
+    int32_t idx = stick_to_index(r);
+    int32_t new_r = shaping->stick[idx];
+    *x = clamp_stick(*x * new_r / idx);
+    *y = clamp_stick(*y * new_r / idx);
+}
+
+static int32_t apply_pedal(const uni_axis_shaping_t* shaping, int32_t v) {
+    if (v <= 0)
+        return 0;
+    return shaping->pedal[(v > UNI_AXIS_SHAPING_MAX) ? UNI_AXIS_SHAPING_MAX : v];
+}
+
+// Properties are uint32. Validated before narrowing them, so that a big value doesn't wrap into a valid one.
+static uint16_t get_curve_value(uni_property_idx_t idx, uint32_t max) {
+    uint32_t v = uni_property_get(idx).u32;
+
+    if (v > max) {
+        loge("Axis shaping: invalid value for property %d: %u, using 0\n", idx, (unsigned)v);
+        return 0;
+    }
+    return v;
+}
+
+static void get_curve_from_properties(uni_axis_curve_t* curve,
+                                      uni_property_idx_t deadzone,
+                                      uni_property_idx_t anti_deadzone,
+                                      uni_property_idx_t expo,
+                                      uni_property_idx_t points) {
+    uni_property_value_t val;
+
+    curve->deadzone = get_curve_value(deadzone, UNI_AXIS_SHAPING_MAX - 1);
+    curve->anti_deadzone = get_curve_value(anti_deadzone, UNI_AXIS_SHAPING_MAX - 1);
+    curve->expo = get_curve_value(expo, UNI_AXIS_SHAPING_MAX);
+    curve->num_points = 0;
+
+    val = uni_property_get(points);
+    if (val.str != NULL && val.str[0] != 0 && !uni_axis_shaping_parse_points(val.str, curve))
+        loge("Axis shaping: failed to parse curve: '%s'\n", val.str);
+}
+
+static void set_curve_properties(const uni_axis_curve_t* curve,
+                                 uni_property_idx_t deadzone,
+                                 uni_property_idx_t anti_deadzone,
+                                 uni_property_idx_t expo,
+                                 uni_property_idx_t points) {
+    uni_property_value_t val;
+    char str[UNI_AXIS_SHAPING_POINTS_STR_LEN];
+
+    val.u32 = curve->deadzone;
+    uni_property_set(deadzone, val);
+    val.u32 = curve->anti_deadzone;
+    uni_property_set(anti_deadzone, val);
+    val.u32 = curve->expo;
+    uni_property_set(expo, val);
+
+    uni_axis_shaping_format_points(curve, str);
+    val.str = str;
+    uni_property_set(points, val);
+}
+
+//
+// Public functions
+//
+void uni_axis_shaping_init(void) {
+    uni_axis_shaping_config_t config;
+
+    uni_axis_shaping_get_config(&config);
+    uni_axis_shaping_compile(&config, &global_shaping);
+}
+
+void uni_axis_shaping_set_config(const uni_axis_shaping_config_t* config) {
+    uni_property_value_t val;
+
+    uni_axis_shaping_compile(config, &global_shaping);
+
+    set_curve_properties(&config->stick, UNI_PROPERTY_IDX_STICK_DEADZONE, UNI_PROPERTY_IDX_STICK_ANTI_DEADZONE,
+                         UNI_PROPERTY_IDX_STICK_EXPO, UNI_PROPERTY_IDX_STICK_CURVE);
+    set_curve_properties(&config->pedal, UNI_PROPERTY_IDX_PEDAL_DEADZONE, UNI_PROPERTY_IDX_PEDAL_ANTI_DEADZONE,
+                         UNI_PROPERTY_IDX_PEDAL_EXPO, UNI_PROPERTY_IDX_PEDAL_CURVE);
+    val.boolean = config->stick_axial;
+    uni_property_set(UNI_PROPERTY_IDX_STICK_AXIAL, val);
+}
+
+void uni_axis_shaping_get_config(uni_axis_shaping_config_t* config) {
+    get_curve_from_properties(&config->stick, UNI_PROPERTY_IDX_STICK_DEADZONE, UNI_PROPERTY_IDX_STICK_ANTI_DEADZONE,
+                              UNI_PROPERTY_IDX_STICK_EXPO, UNI_PROPERTY_IDX_STICK_CURVE);
+    get_curve_from_properties(&config->pedal, UNI_PROPERTY_IDX_PEDAL_DEADZONE, UNI_PROPERTY_IDX_PEDAL_ANTI_DEADZONE,
+                              UNI_PROPERTY_IDX_PEDAL_EXPO, UNI_PROPERTY_IDX_PEDAL_CURVE);
+    config->stick_axial = uni_property_get(UNI_PROPERTY_IDX_STICK_AXIAL).boolean;
+}
+
+void uni_axis_shaping_compile(const uni_axis_shaping_config_t* config, uni_axis_shaping_t* shaping) {
+    shaping->stick_linear = compile_curve(&config->stick, shaping->stick);
+    shaping->pedal_linear = compile_curve(&config->pedal, shaping->pedal);
+    shaping->stick_axial = config->stick_axial;
+}
+
+void uni_axis_shaping_apply(const uni_axis_shaping_t* shaping, uni_gamepad_t* gp) {
+    if (shaping == NULL)
+        shaping = &global_shaping;
+
+    if (!shaping->stick_linear) {
+        apply_stick(shaping, &gp->axis_x, &gp->axis_y);
+        apply_stick(shaping, &gp->axis_rx, &gp->axis_ry);
+    }
+    if (!shaping->pedal_linear) {
+        gp->brake = apply_pedal(shaping, gp->brake);
+        gp->throttle = apply_pedal(shaping, gp->throttle);
+    }
+}
+
+bool uni_axis_shaping_parse_points(const char* str, uni_axis_curve_t* curve) {
+    const char* p = str;
+    char* end;
+    long x, y;
+    int n = 0;
+
+    while (*p != 0) {
+        if (n == UNI_AXIS_SHAPING_MAX_POINTS)
+            return false;
+        x = strtol(p, &end, 10);
+        if (end == p || *end != ':')
+            return false;
+        p = end + 1;
+        y = strtol(p, &end, 10);
+        if (end == p || (*end != ',' && *end != 0))
+            return false;
+        p = (*end == ',') ? end + 1 : end;
+
+        if (x <= 0 || x >= UNI_AXIS_SHAPING_MAX || y < 0 || y > UNI_AXIS_SHAPING_MAX)
+            return false;
+        curve->points[n].x = x;
+        curve->points[n].y = y;
+        n++;
+    }
+    curve->num_points = n;
+    return true;
+}
+
+void uni_axis_shaping_format_points(const uni_axis_curve_t* curve, char* str) {
+    int len = 0;
+
+    str[0] = 0;
+    for (int i = 0; i < curve->num_points && i < UNI_AXIS_SHAPING_MAX_POINTS; i++)
+        len += snprintf(&str[len], UNI_AXIS_SHAPING_POINTS_STR_LEN - len, "%s%d:%d", i ? "," : "",
+                        curve->points[i].x, curve->points[i].y);
+}
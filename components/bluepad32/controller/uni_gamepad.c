@@ -12,7 +12,7 @@
 #include "uni_config.h"
 #include "uni_log.h"
 
-static uni_gamepad_mappings_t map;
+static uni_gamepad_mappings_lut_t custom_lut;
 static uni_gamepad_mappings_type_t mappings_type;
 
 static struct {
@@ -88,34 +88,18 @@ const uni_gamepad_mappings_t GAMEPAD_DEFAULT_MAPPINGS = {
 const int AXIS_NORMALIZE_RANGE = 1024;  // 10-bit resolution (1024)
 const int AXIS_THRESHOLD = (1024 / 8);
 
-static int32_t get_mappings_value_for_axis(uni_gamepad_mappings_axis_t axis_type, const uni_gamepad_t* gp) {
-    switch (axis_type) {
-        case UNI_GAMEPAD_MAPPINGS_AXIS_X:
-            return gp->axis_x;
-        case UNI_GAMEPAD_MAPPINGS_AXIS_Y:
-            return gp->axis_y;
-        case UNI_GAMEPAD_MAPPINGS_AXIS_RX:
-            return gp->axis_rx;
-        case UNI_GAMEPAD_MAPPINGS_AXIS_RY:
-            return gp->axis_ry;
-        default:
-            break;
-    }
-    loge("get_mappings_value_for_axis(): should not happen\n");
-    return -1;
-}
+_Static_assert(BUTTON_THUMB_R < BIT(8 + UNI_GAMEPAD_MAPPINGS_BUTTONS_HI_BITS), "Update BUTTONS_HI_BITS");
 
-static int32_t get_mappings_value_for_pedal(uni_gamepad_mappings_pedal_t pedal_type, const uni_gamepad_t* gp) {
-    switch (pedal_type) {
-        case UNI_GAMEPAD_MAPPINGS_PEDAL_THROTTLE:
-            return gp->throttle;
-        case UNI_GAMEPAD_MAPPINGS_PEDAL_BRAKE:
-            return gp->brake;
-        default:
-            break;
+// Returns the bits of "dst" that correspond to the bits set in "src".
+// "map" has the destination bit for each source bit, starting at "first_bit".
+static uint16_t compile_bits(uint32_t src, const uint8_t* map, int first_bit, int count) {
+    uint16_t dst = 0;
+
+    for (int i = 0; i < count; i++) {
+        if ((src & BIT(first_bit + i)) && map[first_bit + i] < 16)
+            dst |= BIT(map[first_bit + i]);
     }
-    loge("get_mappings_value_for_pedal(): should not happen\n");
-    return -1;
+    return dst;
 }
 
 uni_gamepad_t uni_gamepad_remap(const uni_gamepad_t* gp) {
@@ -144,68 +128,79 @@ uni_gamepad_t uni_gamepad_remap(const uni_gamepad_t* gp) {
     }
 
     // else UNI_GAMEPAD_MAPPINGS_TYPE_CUSTOM
+    return uni_gamepad_remap_with_lut(gp, &custom_lut);
+}
+
+uni_gamepad_t uni_gamepad_remap_with_lut(const uni_gamepad_t* gp, const uni_gamepad_mappings_lut_t* lut) {
+    // Gyro, accel and the rest are not remapped.
+    uni_gamepad_t new_gp = *gp;
+
+    // Same order as uni_gamepad_mappings_axis_t and uni_gamepad_mappings_pedal_t.
+    const int32_t axis[] = {gp->axis_x, gp->axis_y, gp->axis_rx, gp->axis_ry};
+    const int32_t pedal[] = {gp->brake, gp->throttle};
+
+    new_gp.buttons =
+        lut->buttons_lo[gp->buttons & 0xff] |
+        lut->buttons_hi[(gp->buttons >> 8) & (BIT(UNI_GAMEPAD_MAPPINGS_BUTTONS_HI_BITS) - 1)];
+    new_gp.dpad = lut->dpad[gp->dpad & 0x0f];
+    new_gp.misc_buttons = lut->misc_buttons[gp->misc_buttons & 0x0f];
 
-    if (gp->buttons & BUTTON_A)
-        new_gp.buttons |= BIT(map.button_a);
-    if (gp->buttons & BUTTON_B)
-        new_gp.buttons |= BIT(map.button_b);
-    if (gp->buttons & BUTTON_X)
-        new_gp.buttons |= BIT(map.button_x);
-    if (gp->buttons & BUTTON_Y)
-        new_gp.buttons |= BIT(map.button_y);
-    if (gp->buttons & BUTTON_SHOULDER_L)
-        new_gp.buttons |= BIT(map.button_shoulder_l);
-    if (gp->buttons & BUTTON_SHOULDER_R)
-        new_gp.buttons |= BIT(map.button_shoulder_r);
-    if (gp->buttons & BUTTON_TRIGGER_L)
-        new_gp.buttons |= BIT(map.button_trigger_l);
-    if (gp->buttons & BUTTON_TRIGGER_R)
-        new_gp.buttons |= BIT(map.button_trigger_r);
-    if (gp->buttons & BUTTON_THUMB_L)
-        new_gp.buttons |= BIT(map.button_thumb_l);
-    if (gp->buttons & BUTTON_THUMB_R)
-        new_gp.buttons |= BIT(map.button_thumb_r);
-
-    if (gp->dpad & DPAD_UP)
-        new_gp.dpad |= BIT(map.dpad_up);
-    if (gp->dpad & DPAD_DOWN)
-        new_gp.dpad |= BIT(map.dpad_down);
-    if (gp->dpad & DPAD_LEFT)
-        new_gp.dpad |= BIT(map.dpad_left);
-    if (gp->dpad & DPAD_RIGHT)
-        new_gp.dpad |= BIT(map.dpad_right);
-
-    if (gp->misc_buttons & MISC_BUTTON_SYSTEM)
-        new_gp.misc_buttons |= BIT(map.misc_button_system);
-    if (gp->misc_buttons & MISC_BUTTON_SELECT)
-        new_gp.misc_buttons |= BIT(map.misc_button_select);
-    if (gp->misc_buttons & MISC_BUTTON_START)
-        new_gp.misc_buttons |= BIT(map.misc_button_start);
-    if (gp->misc_buttons & MISC_BUTTON_CAPTURE)
-        new_gp.misc_buttons |= BIT(map.misc_button_capture);
-
-    new_gp.axis_x = get_mappings_value_for_axis(map.axis_x, gp);
-    if (map.axis_x_inverted)
-        new_gp.axis_x = -new_gp.axis_x;
-    new_gp.axis_y = get_mappings_value_for_axis(map.axis_y, gp);
-    if (map.axis_y_inverted)
-        new_gp.axis_y = -new_gp.axis_y;
-    new_gp.axis_rx = get_mappings_value_for_axis(map.axis_rx, gp);
-    if (map.axis_rx_inverted)
-        new_gp.axis_rx = -new_gp.axis_rx;
-    new_gp.axis_ry = get_mappings_value_for_axis(map.axis_ry, gp);
-    if (map.axis_ry_inverted)
-        new_gp.axis_ry = -new_gp.axis_ry;
-
-    new_gp.brake = get_mappings_value_for_pedal(map.brake, gp);
-    new_gp.throttle = get_mappings_value_for_pedal(map.throttle, gp);
+    new_gp.axis_x = axis[lut->axis[0]] * lut->axis_sign[0];
+    new_gp.axis_y = axis[lut->axis[1]] * lut->axis_sign[1];
+    new_gp.axis_rx = axis[lut->axis[2]] * lut->axis_sign[2];
+    new_gp.axis_ry = axis[lut->axis[3]] * lut->axis_sign[3];
+
+    new_gp.brake = pedal[lut->pedal[0]];
+    new_gp.throttle = pedal[lut->pedal[1]];
 
     return new_gp;
 }
 
+void uni_gamepad_mappings_compile(const uni_gamepad_mappings_t* mappings, uni_gamepad_mappings_lut_t* lut) {
+    // Destination bit for each source bit. Same order as the BUTTON_, DPAD_ and MISC_BUTTON_ bits.
+    const uint8_t buttons[] = {mappings->button_a,         mappings->button_b,         mappings->button_x,
+                               mappings->button_y,         mappings->button_shoulder_l, mappings->button_shoulder_r,
+                               mappings->button_trigger_l, mappings->button_trigger_r, mappings->button_thumb_l,
+                               mappings->button_thumb_r};
+    const uint8_t dpad[] = {mappings->dpad_up, mappings->dpad_down, mappings->dpad_right, mappings->dpad_left};
+    const uint8_t misc[] = {mappings->misc_button_system, mappings->misc_button_select, mappings->misc_button_start,
+                            mappings->misc_button_capture};
+    const uint8_t axis[] = {mappings->axis_x, mappings->axis_y, mappings->axis_rx, mappings->axis_ry};
+    const uint8_t inverted[] = {mappings->axis_x_inverted, mappings->axis_y_inverted, mappings->axis_rx_inverted,
+                                mappings->axis_ry_inverted};
+    const uint8_t pedal[] = {mappings->brake, mappings->throttle};
+
+    for (int i = 0; i < 256; i++)
+        lut->buttons_lo[i] = compile_bits(i, buttons, 0, 8);
+    for (int i = 0; i < (int)ARRAY_SIZE(lut->buttons_hi); i++)
+        lut->buttons_hi[i] = compile_bits(i << 8, buttons, 8, UNI_GAMEPAD_MAPPINGS_BUTTONS_HI_BITS);
+    for (int i = 0; i < 16; i++) {
+        lut->dpad[i] = compile_bits(i, dpad, 0, 4);
+        lut->misc_buttons[i] = compile_bits(i, misc, 0, 4);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (axis[i] > UNI_GAMEPAD_MAPPINGS_AXIS_RY) {
+            loge("Gamepad mappings: invalid axis %d, using default\n", axis[i]);
+            lut->axis[i] = i;
+        } else {
+            lut->axis[i] = axis[i];
+        }
+        lut->axis_sign[i] = inverted[i] ? -1 : 1;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (pedal[i] > UNI_GAMEPAD_MAPPINGS_PEDAL_THROTTLE) {
+            loge("Gamepad mappings: invalid pedal %d, using default\n", pedal[i]);
+            lut->pedal[i] = i;
+        } else {
+            lut->pedal[i] = pedal[i];
+        }
+    }
+}
+
 void uni_gamepad_set_mappings(const uni_gamepad_mappings_t* mappings) {
+    uni_gamepad_mappings_compile(mappings, &custom_lut);
     mappings_type = UNI_GAMEPAD_MAPPINGS_TYPE_CUSTOM;
-    map = *mappings;
 }
 
 void uni_gamepad_set_mappings_type(uni_gamepad_mappings_type_t type) {
@@ -4,9 +4,14 @@
 
 #include "controller/uni_keyboard.h"
 
+#include <string.h>
+
 #include "hid_usage.h"
 #include "uni_log.h"
 
+_Static_assert((UNI_KEYBOARD_RING_SIZE & (UNI_KEYBOARD_RING_SIZE - 1)) == 0, "Must be a power of two");
+_Static_assert(UNI_KEYBOARD_RING_SIZE <= UINT8_MAX, "Ring too big");
+
 void uni_keyboard_dump(const uni_keyboard_t* kb) {
     // Don't add "\n"
     logi("modifiers=%#x, pressed keys=[", kb->modifiers);
@@ -19,3 +24,70 @@ void uni_keyboard_dump(const uni_keyboard_t* kb) {
     }
     logi("]");
 }
+
+void uni_keyboard_set_key_pressed(uni_keyboard_t* kb, uint8_t key) {
+    kb->pressed_bitmap[key / 8] |= BIT(key % 8);
+}
+
+bool uni_keyboard_is_key_pressed(const uni_keyboard_t* kb, uint8_t key) {
+    return kb->pressed_bitmap[key / 8] & BIT(key % 8);
+}
+
+void uni_keyboard_ring_reset(uni_keyboard_ring_t* ring) {
+    uni_ring_reset(&ring->ring);
+    memset(ring->prev_bitmap, 0, sizeof(ring->prev_bitmap));
+}
+
+void uni_keyboard_ring_push(uni_keyboard_ring_t* ring, const uni_keyboard_event_t* event) {
+    uni_ring_push(&ring->ring, ring->events, sizeof(*event), UNI_KEYBOARD_RING_SIZE, event);
+}
+
+static void push_changes(uni_keyboard_ring_t* ring, const uni_keyboard_t* kb, uint32_t timestamp_ms, bool pressed) {
+    uni_keyboard_event_t event;
+
+    event.timestamp_ms = timestamp_ms;
+    event.modifiers = kb->modifiers;
+    event.pressed = pressed;
+
+    for (int i = 0; i < UNI_KEYBOARD_BITMAP_LEN; i++) {
+        uint8_t changed = kb->pressed_bitmap[i] ^ ring->prev_bitmap[i];
+        // Keep the ones that were pressed, or the ones that were released.
+        changed &= pressed ? kb->pressed_bitmap[i] : ring->prev_bitmap[i];
+        for (int bit = 0; changed != 0; bit++, changed >>= 1) {
+            if (!(changed & 1))
+                continue;
+            event.key = i * 8 + bit;
+            uni_keyboard_ring_push(ring, &event);
+        }
+    }
+}
+
+// Boot keyboards past their rollover limit fill every array slot with ErrorRollOver, and report no keys.
+static bool is_roll_over(const uni_keyboard_t* kb) {
+    for (int i = 0; i < UNI_KEYBOARD_PRESSED_KEYS_MAX; i++) {
+        if (kb->pressed_keys[i] == HID_USAGE_KB_ERROR_ROLL_OVER)
+            return true;
+    }
+    return false;
+}
+
+void uni_keyboard_ring_update(uni_keyboard_ring_t* ring, const uni_keyboard_t* kb, uint32_t timestamp_ms) {
+    // Keep the previous state. Otherwise the held keys would be released, and pressed again in the next report.
+    if (is_roll_over(kb))
+        return;
+
+    if (memcmp(kb->pressed_bitmap, ring->prev_bitmap, sizeof(ring->prev_bitmap)) == 0)
+        return;
+
+    push_changes(ring, kb, timestamp_ms, false);
+    push_changes(ring, kb, timestamp_ms, true);
+    memcpy(ring->prev_bitmap, kb->pressed_bitmap, sizeof(ring->prev_bitmap));
+}
+
+int uni_keyboard_ring_read(uni_keyboard_ring_t* ring, uni_keyboard_event_t* out, int max) {
+    return uni_ring_read(&ring->ring, ring->events, sizeof(*out), UNI_KEYBOARD_RING_SIZE, out, max);
+}
+
+int uni_keyboard_ring_peek(const uni_keyboard_ring_t* ring, uint32_t* cursor, uni_keyboard_event_t* out, int max) {
+    return uni_ring_peek(&ring->ring, cursor, ring->events, sizeof(*out), UNI_KEYBOARD_RING_SIZE, out, max);
+}
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#include "controller/uni_motion.h"
+
+_Static_assert((UNI_MOTION_RING_SIZE & (UNI_MOTION_RING_SIZE - 1)) == 0, "Must be a power of two");
+_Static_assert(UNI_MOTION_RING_SIZE <= UINT8_MAX, "Ring too big");
+
+void uni_motion_ring_reset(uni_motion_ring_t* ring) {
+    uni_ring_reset(&ring->ring);
+}
+
+void uni_motion_ring_push(uni_motion_ring_t* ring, const uni_motion_sample_t* sample) {
+    uni_ring_push(&ring->ring, ring->samples, sizeof(*sample), UNI_MOTION_RING_SIZE, sample);
+}
+
+void uni_motion_ring_push_gamepad(uni_motion_ring_t* ring, const uni_gamepad_t* gp, uint32_t timestamp_ms) {
+    uni_motion_sample_t sample;
+
+    sample.timestamp_ms = timestamp_ms;
+    for (int i = 0; i < 3; i++) {
+        sample.gyro[i] = gp->gyro[i];
+        sample.accel[i] = gp->accel[i];
+    }
+    uni_motion_ring_push(ring, &sample);
+}
+
+int uni_motion_ring_read(uni_motion_ring_t* ring, uni_motion_sample_t* out, int max) {
+    return uni_ring_read(&ring->ring, ring->samples, sizeof(*out), UNI_MOTION_RING_SIZE, out, max);
+}
+
+int uni_motion_ring_peek(const uni_motion_ring_t* ring, uint32_t* cursor, uni_motion_sample_t* out, int max) {
+    return uni_ring_peek(&ring->ring, cursor, ring->samples, sizeof(*out), UNI_MOTION_RING_SIZE, out, max);
+}
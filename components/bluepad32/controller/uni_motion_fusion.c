@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+// Mahony filter, based on:
+// https://x-io.co.uk/open-source-imu-and-ahrs-algorithms/
+// Everything is in fixed point, since it runs on the Bluetooth thread, once per sample.
+
+#include "controller/uni_motion_fusion.h"
+
+#include <stdlib.h>
+
+#include "uni_property.h"
+
+#define FUSION_ONE_SHIFT 30
+#define FUSION_ONE (1 << FUSION_ONE_SHIFT)
+
+// Proportional gain: 0.5 rad/s per unit of error. Error is Q30, gyro is rad/s in Q16.
+#define FUSION_KP_SHIFT (FUSION_ONE_SHIFT - 16 + 1)
+
+// Degrees to radians, Q24.
+#define FUSION_DEG_TO_RAD_Q24 292803
+
+// Longer gaps are not integrated, like when the controller stops sending reports.
+#define FUSION_MAX_DT_MS 50
+
+// At rest: gyro below 10 deg/s, and barely changing, for at least 300ms.
+#define FUSION_REST_GYRO_DPS 10
+#define FUSION_REST_GYRO_DELTA_DPS 2
+#define FUSION_REST_ACCEL_DELTA_SHIFT 5  // Accel change below 1/32 of its magnitude
+#define FUSION_REST_MIN_MS 300
+#define FUSION_BIAS_EWMA_SHIFT 5
+
+static bool fusion_enabled;
+
+static uint32_t isqrt64(uint64_t v) {
+    uint64_t res = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > v)
+        bit >>= 2;
+    while (bit != 0) {
+        if (v >= res + bit) {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)res;
+}
+
+static int32_t mul_q30(int32_t a, int32_t b) {
+    return (int32_t)(((int64_t)a * b) >> FUSION_ONE_SHIFT);
+}
+
+static void normalize_quaternion(int32_t q[4]) {
+    uint64_t norm2 = 0;
+    for (int i = 0; i < 4; i++)
+        norm2 += (int64_t)q[i] * q[i];
+
+    uint32_t norm = isqrt64(norm2);
+    if (norm == 0) {
+        q[0] = FUSION_ONE;
+        q[1] = q[2] = q[3] = 0;
+        return;
+    }
+    for (int i = 0; i < 4; i++)
+        q[i] = (int32_t)(((int64_t)q[i] << FUSION_ONE_SHIFT) / norm);
+}
+
+// Returns false if the vector is all zeros.
+static bool normalize_accel(const int32_t accel[3], int32_t out[3], uint32_t* magnitude) {
+    uint64_t norm2 = 0;
+    for (int i = 0; i < 3; i++)
+        norm2 += (int64_t)accel[i] * accel[i];
+
+    *magnitude = isqrt64(norm2);
+    if (*magnitude == 0)
+        return false;
+    for (int i = 0; i < 3; i++)
+        out[i] = (int32_t)(((int64_t)accel[i] << FUSION_ONE_SHIFT) / *magnitude);
+    return true;
+}
+
+// Earth's "up" axis, as seen from the controller. Q30.
+static void estimated_gravity(const int32_t q[4], int32_t v[3]) {
+    v[0] = 2 * (mul_q30(q[1], q[3]) - mul_q30(q[0], q[2]));
+    v[1] = 2 * (mul_q30(q[0], q[1]) + mul_q30(q[2], q[3]));
+    v[2] = mul_q30(q[0], q[0]) - mul_q30(q[1], q[1]) - mul_q30(q[2], q[2]) + mul_q30(q[3], q[3]);
+}
+
+// First orientation: the shortest rotation that takes the measured gravity to "up".
+static void init_from_accel(uni_motion_fusion_t* f, const int32_t a[3]) {
+    // Upside down: the shortest rotation is not defined. Any 180 degree rotation works.
+    if (a[2] < -FUSION_ONE + (FUSION_ONE >> 10)) {
+        f->q[0] = 0;
+        f->q[1] = FUSION_ONE;
+        f->q[2] = f->q[3] = 0;
+        return;
+    }
+    // Halved, to avoid overflows. It gets normalized anyway.
+    f->q[0] = (FUSION_ONE >> 1) + (a[2] >> 1);
+    f->q[1] = a[1] >> 1;
+    f->q[2] = -(a[0] >> 1);
+    f->q[3] = 0;
+    normalize_quaternion(f->q);
+}
+
+static void update_rest(uni_motion_fusion_t* f, const uni_motion_sample_t* s, uint32_t accel_magnitude, uint32_t dt) {
+    int64_t res = f->gyro_res_per_dps;
+    int32_t accel_delta = 0;
+    bool rest = true;
+
+    for (int i = 0; i < 3; i++) {
+        if (llabs(((int64_t)s->gyro[i] << 4) - f->gyro_bias[i]) > ((FUSION_REST_GYRO_DPS * res) << 4) ||
+            llabs((int64_t)s->gyro[i] - f->prev_gyro[i]) > FUSION_REST_GYRO_DELTA_DPS * res)
+            rest = false;
+        accel_delta += abs(s->accel[i] - f->prev_accel[i]);
+    }
+    if (accel_delta > (int32_t)(accel_magnitude >> FUSION_REST_ACCEL_DELTA_SHIFT))
+        rest = false;
+
+    if (!rest) {
+        f->rest_ms = 0;
+        return;
+    }
+    if (f->rest_ms < FUSION_REST_MIN_MS) {
+        f->rest_ms += dt;
+        return;
+    }
+
+    // At rest: whatever the gyro reports is bias.
+    for (int i = 0; i < 3; i++)
+        f->gyro_bias[i] += ((s->gyro[i] << 4) - f->gyro_bias[i]) >> FUSION_BIAS_EWMA_SHIFT;
+}
+
+static void save_previous_sample(uni_motion_fusion_t* f, const uni_motion_sample_t* s) {
+    for (int i = 0; i < 3; i++) {
+        f->prev_gyro[i] = s->gyro[i];
+        f->prev_accel[i] = s->accel[i];
+    }
+}
+
+static void process_sample(uni_motion_fusion_t* f, const uni_motion_sample_t* s) {
+    int32_t a[3];
+    int32_t v[3];
+    int32_t w[3] = {0};  // Angular rate, rad/s in Q16
+    uint32_t accel_magnitude;
+    uint32_t dt;
+    bool has_accel;
+
+    has_accel = normalize_accel(s->accel, a, &accel_magnitude);
+
+    if (!f->initialized) {
+        if (!has_accel)
+            return;
+        init_from_accel(f, a);
+        f->initialized = true;
+        f->last_timestamp_ms = s->timestamp_ms;
+        save_previous_sample(f, s);
+        return;
+    }
+
+    dt = s->timestamp_ms - f->last_timestamp_ms;
+    f->last_timestamp_ms = s->timestamp_ms;
+    if (dt > FUSION_MAX_DT_MS)
+        dt = 0;
+
+    if (f->gyro_res_per_dps != 0) {
+        if (has_accel)
+            update_rest(f, s, accel_magnitude, dt);
+        for (int i = 0; i < 3; i++)
+            w[i] = (int32_t)((((int64_t)s->gyro[i] << 4) - f->gyro_bias[i]) * FUSION_DEG_TO_RAD_Q24 /
+                             ((int64_t)f->gyro_res_per_dps << 12));
+    }
+
+    // Feedback: the error is the cross product between the measured and the estimated gravity.
+    if (has_accel) {
+        estimated_gravity(f->q, v);
+        w[0] += (mul_q30(a[1], v[2]) - mul_q30(a[2], v[1])) >> FUSION_KP_SHIFT;
+        w[1] += (mul_q30(a[2], v[0]) - mul_q30(a[0], v[2])) >> FUSION_KP_SHIFT;
+        w[2] += (mul_q30(a[0], v[1]) - mul_q30(a[1], v[0])) >> FUSION_KP_SHIFT;
+    }
+
+    if (dt != 0) {
+        // Half of the rotation during dt, in Q30: w (Q16) * dt (ms) / 1000 / 2 << 14.
+        int32_t h[3];
+        for (int i = 0; i < 3; i++)
+            h[i] = (int32_t)(((int64_t)w[i] * dt * (1 << 13)) / 1000);
+
+        int32_t q0 = f->q[0], q1 = f->q[1], q2 = f->q[2], q3 = f->q[3];
+        f->q[0] += -mul_q30(q1, h[0]) - mul_q30(q2, h[1]) - mul_q30(q3, h[2]);
+        f->q[1] += mul_q30(q0, h[0]) + mul_q30(q2, h[2]) - mul_q30(q3, h[1]);
+        f->q[2] += mul_q30(q0, h[1]) - mul_q30(q1, h[2]) + mul_q30(q3, h[0]);
+        f->q[3] += mul_q30(q0, h[2]) + mul_q30(q1, h[1]) - mul_q30(q2, h[0]);
+        normalize_quaternion(f->q);
+    }
+
+    save_previous_sample(f, s);
+}
+
+//
+// Public functions
+//
+void uni_motion_fusion_init(void) {
+    fusion_enabled = uni_property_get(UNI_PROPERTY_IDX_MOTION_FUSION_ENABLED).boolean;
+}
+
+void uni_motion_fusion_set_enabled(bool enabled) {
+    uni_property_value_t val;
+
+    if (enabled != fusion_enabled) {
+        fusion_enabled = enabled;
+
+        val.boolean = enabled;
+        uni_property_set(UNI_PROPERTY_IDX_MOTION_FUSION_ENABLED, val);
+    }
+}
+
+bool uni_motion_fusion_is_enabled(void) {
+    return fusion_enabled;
+}
+
+void uni_motion_fusion_update(uni_motion_fusion_t* fusion, const uni_motion_ring_t* ring, uni_gamepad_t* gp) {
+    uni_motion_sample_t sample;
+    int32_t v[3];
+
+    if (!fusion_enabled)
+        return;
+
+    while (uni_motion_ring_peek(ring, &fusion->cursor, &sample, 1) == 1)
+        process_sample(fusion, &sample);
+
+    if (!fusion->initialized)
+        return;
+
+    // From Q30 to the gamepad precision.
+    estimated_gravity(fusion->q, v);
+    for (int i = 0; i < 4; i++)
+        gp->orientation[i] = fusion->q[i] >> (FUSION_ONE_SHIFT - UNI_GAMEPAD_ORIENTATION_ONE_SHIFT);
+    for (int i = 0; i < 3; i++)
+        gp->gravity[i] = v[i] >> (FUSION_ONE_SHIFT - UNI_GAMEPAD_ORIENTATION_ONE_SHIFT);
+}
@@ -8,6 +8,6 @@
 
 void uni_mouse_dump(const uni_mouse_t* ms) {
     // Don't add "\n"
-    logi("delta_x=%4d, delta_y=%4d, buttons=%#x, misc_buttons=%#x, scroll_wheel=%#x", ms->delta_x, ms->delta_y,
-         ms->buttons, ms->misc_buttons, ms->scroll_wheel);
+    logi("delta_x=%4d, delta_y=%4d, buttons=%#x, misc_buttons=%#x, scroll_wheel=%d, pan=%d", ms->delta_x,
+         ms->delta_y, ms->buttons, ms->misc_buttons, ms->scroll_wheel, ms->pan);
 }
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#include "controller/uni_touch.h"
+
+#include "uni_common.h"
+
+_Static_assert((UNI_TOUCH_RING_SIZE & (UNI_TOUCH_RING_SIZE - 1)) == 0, "Must be a power of two");
+_Static_assert(UNI_TOUCH_RING_SIZE <= UINT8_MAX, "Ring too big");
+_Static_assert(UNI_TOUCH_MAX_POINTS <= 8, "active_points is too small");
+
+void uni_touch_ring_reset(uni_touch_ring_t* ring) {
+    uni_ring_reset(&ring->ring);
+    ring->active_points = 0;
+}
+
+void uni_touch_ring_push(uni_touch_ring_t* ring, const uni_touch_event_t* event) {
+    uni_ring_push(&ring->ring, ring->events, sizeof(*event), UNI_TOUCH_RING_SIZE, event);
+}
+
+void uni_touch_ring_push_point(uni_touch_ring_t* ring,
+                               uint8_t point,
+                               uint8_t frame,
+                               uint8_t finger_id,
+                               bool contact,
+                               uint16_t x,
+                               uint16_t y,
+                               uint32_t timestamp_ms) {
+    uni_touch_event_t event;
+
+    if (point >= UNI_TOUCH_MAX_POINTS)
+        return;
+
+    if (contact) {
+        ring->active_points |= BIT(point);
+    } else {
+        // Idle points are reported in every frame. Only the release is interesting.
+        if (!(ring->active_points & BIT(point)))
+            return;
+        ring->active_points &= ~BIT(point);
+    }
+
+    event.timestamp_ms = timestamp_ms;
+    event.x = x;
+    event.y = y;
+    event.finger_id = finger_id;
+    event.point = point;
+    event.frame = frame;
+    event.contact = contact;
+    uni_touch_ring_push(ring, &event);
+}
+
+int uni_touch_ring_read(uni_touch_ring_t* ring, uni_touch_event_t* out, int max) {
+    return uni_ring_read(&ring->ring, ring->events, sizeof(*out), UNI_TOUCH_RING_SIZE, out, max);
+}
+
+int uni_touch_ring_peek(const uni_touch_ring_t* ring, uint32_t* cursor, uni_touch_event_t* out, int max) {
+    return uni_ring_peek(&ring->ring, cursor, ring->events, sizeof(*out), UNI_TOUCH_RING_SIZE, out, max);
+}
+
+bool uni_touch_mouse_update(uni_touch_mouse_t* tm, const uni_touch_ring_t* ring, int32_t* delta_x, int32_t* delta_y) {
+    uni_touch_event_t e;
+
+    *delta_x = 0;
+    *delta_y = 0;
+
+    while (uni_touch_ring_peek(ring, &tm->cursor, &e, 1) == 1) {
+        if (!tm->tracking) {
+            // Follow the first finger that touches the pad. The first event has no movement.
+            if (!e.contact)
+                continue;
+            tm->tracking = true;
+            tm->finger_id = e.finger_id;
+        } else {
+            if (e.finger_id != tm->finger_id)
+                continue;
+            if (!e.contact) {
+                tm->tracking = false;
+                continue;
+            }
+            *delta_x += e.x - tm->x;
+            *delta_y += e.y - tm->y;
+        }
+        tm->x = e.x;
+        tm->y = e.y;
+    }
+    return tm->tracking;
+}
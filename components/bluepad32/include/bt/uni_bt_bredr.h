@@ -20,6 +20,8 @@ extern "C" {
 
 void uni_bt_bredr_scan_start(void);
 void uni_bt_bredr_scan_stop(void);
+// Percentage of time spent doing inquiry. Keeps the inquiry length, and increases the period.
+void uni_bt_bredr_scan_set_duty(uint8_t duty);
 
 // Called from uni_hid_device_disconnect()
 void uni_bt_bredr_disconnect(uni_hid_device_t* d);
@@ -39,11 +41,15 @@ void uni_bt_bredr_on_l2cap_channel_opened(uint16_t channel, const uint8_t* packe
 void uni_bt_bredr_on_l2cap_channel_closed(uint16_t channel, const uint8_t* packet, uint16_t size);
 void uni_bt_bredr_on_l2cap_data_packet(uint16_t channel, const uint8_t* packet, uint16_t size);
 void uni_bt_bredr_on_gap_inquiry_result(uint16_t channel, const uint8_t* packet, uint16_t size);
+void uni_bt_bredr_on_gap_inquiry_complete(uint16_t channel, const uint8_t* packet, uint16_t size);
 void uni_bt_bredr_on_hci_connection_request(uint16_t channel, const uint8_t* packet, uint16_t size);
 void uni_bt_bredr_on_hci_connection_complete(uint16_t channel, const uint8_t* packet, uint16_t size);
 void uni_bt_bredr_on_hci_disconnection_complete(uint16_t channel, const uint8_t* packet, uint16_t size);
 void uni_bt_bredr_on_hci_pin_code_request(uint16_t channel, const uint8_t* packet, uint16_t size);
 void uni_bt_bredr_on_hci_remote_name_request_complete(uint16_t channel, const uint8_t* packet, uint16_t size);
+void uni_bt_bredr_on_hci_mode_change(uint16_t channel, const uint8_t* packet, uint16_t size);
+void uni_bt_bredr_on_hci_command_complete(uint16_t channel, const uint8_t* packet, uint16_t size);
+void uni_bt_bredr_on_hci_command_status(uint16_t channel, const uint8_t* packet, uint16_t size);
 
 #ifdef __cplusplus
 }
@@ -51,12 +51,33 @@ typedef struct {
     // BR/EDR only
     uint8_t page_scan_repetition_mode;
     uint16_t clock_offset;
+    // Link policy, managed by uni_bt_bredr.c
+    uint8_t mode;               // As reported by HCI Mode Change: active, hold, sniff
+    uint16_t sniff_interval;    // In 0.625ms units. Only valid in sniff mode
+    bool sniff_allowed;         // Whether the link policy allows sniff mode
+    uint8_t link_policy_tasks;  // Pending HCI commands
+    uint32_t last_input_ms;     // When the last input report was received
+
+    // BLE only. Negotiated connection parameters, as reported by the controller.
+    uint16_t le_conn_interval;        // In 1.25ms units
+    uint16_t le_conn_latency;         // In number of connection events
+    uint16_t le_supervision_timeout;  // In 10ms units
 
     // BLE & BR/EDR
     uint8_t rssi;
+    // Link quality monitor, managed by uni_bt_link_quality.c. Smoothed values are in 1/16 units.
+    int16_t rssi_avg;               // In dBm
+    uint16_t link_quality_avg;      // BR/EDR only. 0-255, the higher the better
+    uint16_t failed_contacts;       // BR/EDR only. As reported by the last sample
+    uint8_t link_quality_tasks;     // Pending HCI commands
+    uint8_t link_quality_samples;   // Number of samples. Saturates at 255
+    uint32_t link_quality_last_ms;  // When the last sample was requested
+    bool link_quality_low;          // Whether the quality is below the threshold
 
     bool incoming;
     bool connected;
+    // When the device was created. Used to report the time it took to be ready.
+    uint32_t setup_start_ms;
 
     uni_bt_conn_state_t state;
     uni_bt_conn_protocol_t protocol;
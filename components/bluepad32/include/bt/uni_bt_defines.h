@@ -49,6 +49,19 @@
 #define UNI_BT_MIN_PERIODIC_LENGTH 4  // In 1.28s unit
 #define UNI_BT_INQUIRY_LENGTH 3       // In 1.28s unit
 
+// Scan scheduler defaults. Can be overridden with properties.
+#define UNI_BT_SCAN_BURST_MS 10000  // Full duty scanning after new connections are enabled
+#define UNI_BT_SCAN_MIN_DUTY 25     // In percentage. Used when only one seat is free
+
+// Link quality monitor defaults. Can be overridden with properties.
+#define UNI_BT_LINK_QUALITY_PERIOD_MS 2000  // How often each connection gets sampled. 0 to disable
+#define UNI_BT_LINK_QUALITY_MIN 200         // BR/EDR. Link quality below this value is considered low
+#define UNI_BT_LINK_QUALITY_RSSI_MIN 85     // BLE. RSSI below -85 dBm is considered low
+
+// BR/EDR link policy defaults. Can be overridden with properties.
+#define UNI_BT_SNIFF_IDLE_MS 30000  // Allow sniff mode after 30s without input. 0 to never force sniff
+#define UNI_BT_FLUSH_TIMEOUT_MS 0   // Automatic flush timeout. 0 means infinite (never flush)
+
 // Taken from 7.1.19 Remote Name Request Command
 #define UNI_BT_CLOCK_OFFSET_VALID BIT(15)
 
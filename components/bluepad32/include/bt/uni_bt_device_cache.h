@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#ifndef UNI_BT_DEVICE_CACHE_H
+#define UNI_BT_DEVICE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <btstack.h>
+
+// Per-device cache, persisted in BTstack TLV.
+// Used by the parsers to remember what was read from the controller in the previous connections,
+// like calibration data, and skip the requests on reconnect.
+// Entries are keyed by "kind" + Bluetooth address. Each kind has a few slots, and the slot is
+// chosen from the address. When two devices share the same slot, the newest one wins.
+
+// Max payload size, in bytes.
+#define UNI_BT_DEVICE_CACHE_MAX_LEN 96
+
+typedef enum {
+    UNI_BT_DEVICE_CACHE_KIND_SWITCH = 1,
+    UNI_BT_DEVICE_CACHE_KIND_WII = 2,
+} uni_bt_device_cache_kind_t;
+
+// Returns true if an entry for "addr" exists, and its size is "len".
+bool uni_bt_device_cache_get(uni_bt_device_cache_kind_t kind, const bd_addr_t addr, void* data, int len);
+void uni_bt_device_cache_set(uni_bt_device_cache_kind_t kind, const bd_addr_t addr, const void* data, int len);
+void uni_bt_device_cache_delete(uni_bt_device_cache_kind_t kind, const bd_addr_t addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // UNI_BT_DEVICE_CACHE_H
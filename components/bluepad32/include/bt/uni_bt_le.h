@@ -25,6 +25,8 @@ void uni_bt_le_on_hci_disconnection_complete(uint16_t channel, const uint8_t* pa
 
 void uni_bt_le_scan_start(void);
 void uni_bt_le_scan_stop(void);
+// Percentage of time spent scanning. Keeps the scan interval, and reduces the window.
+void uni_bt_le_scan_set_duty(uint8_t duty);
 
 // Called from uni_hid_device_disconnect()
 void uni_bt_le_disconnect(uni_hid_device_t* d);
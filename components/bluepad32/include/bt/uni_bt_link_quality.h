@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#ifndef UNI_BT_LINK_QUALITY_H
+#define UNI_BT_LINK_QUALITY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "uni_hid_device.h"
+
+// Link quality monitor.
+// Periodically samples RSSI (BR/EDR & BLE), Link Quality and Failed Contact Counter (BR/EDR only)
+// from each connection, one connection at the time.
+// When the quality drops below the threshold, UNI_PLATFORM_OOB_LINK_QUALITY_LOW is sent to the platform.
+
+typedef struct {
+    int8_t rssi;               // Smoothed RSSI in dBm. On BR/EDR it is relative to the golden receive power range
+    uint8_t link_quality;      // Smoothed. 0-255, the higher the better. BR/EDR only, 0 otherwise
+    uint16_t failed_contacts;  // BR/EDR only. As reported by the last sample
+    bool low;                  // Whether the link quality is considered low
+} uni_bt_link_quality_t;
+
+void uni_bt_link_quality_setup(void);
+
+// Returns false if there are no samples yet.
+bool uni_bt_link_quality_get(const uni_hid_device_t* d, uni_bt_link_quality_t* out);
+
+// Events
+void uni_bt_link_quality_on_device_ready(uni_hid_device_t* d);
+void uni_bt_link_quality_on_gap_rssi_measurement(const uint8_t* packet, uint16_t size);
+void uni_bt_link_quality_on_hci_command_complete(const uint8_t* packet, uint16_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // UNI_BT_LINK_QUALITY_H
@@ -13,6 +13,8 @@ extern "C" {
 
 void uni_bt_sdp_query_start(uni_hid_device_t* d);
 void uni_bt_sdp_query_end(uni_hid_device_t* d);
+// Removes the device from the SDP queue. Called when the device is deleted.
+void uni_bt_sdp_query_cancel(uni_hid_device_t* d);
 void uni_bt_sdp_query_start_vid_pid(uni_hid_device_t* d);
 void uni_bt_sdp_query_start_hid_descriptor(uni_hid_device_t* d);
 
@@ -35,7 +35,7 @@ const uint8_t profile_data[] =
     0x0d, 0x00, 0x02, 0x00, 0x05, 0x00, 0x03, 0x28, 0x02, 0x06, 0x00, 0x2a, 0x2b, 
     // 0x0006 VALUE CHARACTERISTIC-GATT_DATABASE_HASH - READ -''
     // READ_ANYBODY
-    0x18, 0x00, 0x02, 0x00, 0x06, 0x00, 0x2a, 0x2b, 0xed, 0x33, 0x4b, 0x1f, 0x7d, 0x96, 0xed, 0x57, 0xc0, 0x45, 0xbc, 0x39, 0xc9, 0x2e, 0x47, 0x4a, 
+    0x18, 0x00, 0x02, 0x00, 0x06, 0x00, 0x2a, 0x2b, 0x0b, 0xb2, 0xb5, 0xf3, 0x15, 0xe0, 0x5a, 0xa0, 0x8a, 0x42, 0x7f, 0x0b, 0x35, 0xb9, 0x2f, 0x79, 
     // Bluepad32 Service
     // 0x0007 PRIMARY_SERVICE-4627C4A4-AC00-46B9-B688-AFC5C1BF7F63
     0x18, 0x00, 0x02, 0x00, 0x07, 0x00, 0x00, 0x28, 0x63, 0x7f, 0xbf, 0xc1, 0xc5, 0xaf, 0x88, 0xb6, 0xb9, 0x46, 0x00, 0xac, 0xa4, 0xc4, 0x27, 0x46, 
@@ -70,9 +70,8 @@ const uint8_t profile_data[] =
     // 0x0011 VALUE CHARACTERISTIC-4627C4A4-AC05-46B9-B688-AFC5C1BF7F63 - READ | DYNAMIC
     // READ_ANYBODY
     0x16, 0x00, 0x02, 0x03, 0x11, 0x00, 0x63, 0x7f, 0xbf, 0xc1, 0xc5, 0xaf, 0x88, 0xb6, 0xb9, 0x46, 0x05, 0xac, 0xa4, 0xc4, 0x27, 0x46, 
-    // Notify all connected devices, only when there is a change, one at the time.
-    // Ideally it should be merged with the previous one, but don't know how to increase
-    // the MTU for the notify package.
+    // Notify the devices that changed. As many devices as the negotiated MTU allows
+    // are packed in the same notification.
     // 0x0012 CHARACTERISTIC-4627C4A4-AC06-46B9-B688-AFC5C1BF7F63 - NOTIFY | DYNAMIC
     0x1b, 0x00, 0x02, 0x00, 0x12, 0x00, 0x03, 0x28, 0x10, 0x13, 0x00, 0x63, 0x7f, 0xbf, 0xc1, 0xc5, 0xaf, 0x88, 0xb6, 0xb9, 0x46, 0x06, 0xac, 0xa4, 0xc4, 0x27, 0x46, 
     // 0x0013 VALUE CHARACTERISTIC-4627C4A4-AC06-46B9-B688-AFC5C1BF7F63 - NOTIFY | DYNAMIC
@@ -123,6 +122,22 @@ const uint8_t profile_data[] =
     // 0x0022 VALUE CHARACTERISTIC-4627C4A4-AC0D-46B9-B688-AFC5C1BF7F63 - WRITE | DYNAMIC
     // WRITE_ANYBODY
     0x16, 0x00, 0x08, 0x03, 0x22, 0x00, 0x63, 0x7f, 0xbf, 0xc1, 0xc5, 0xaf, 0x88, 0xb6, 0xb9, 0x46, 0x0d, 0xac, 0xa4, 0xc4, 0x27, 0x46, 
+    // Controller input stream: buttons, dpad, axes and, if available, gyro / accel.
+    // One controller per notification. First byte is the format version.
+    // 0x0023 CHARACTERISTIC-4627C4A4-AC0E-46B9-B688-AFC5C1BF7F63 - NOTIFY | DYNAMIC
+    0x1b, 0x00, 0x02, 0x00, 0x23, 0x00, 0x03, 0x28, 0x10, 0x24, 0x00, 0x63, 0x7f, 0xbf, 0xc1, 0xc5, 0xaf, 0x88, 0xb6, 0xb9, 0x46, 0x0e, 0xac, 0xa4, 0xc4, 0x27, 0x46, 
+    // 0x0024 VALUE CHARACTERISTIC-4627C4A4-AC0E-46B9-B688-AFC5C1BF7F63 - NOTIFY | DYNAMIC
+    // 
+    0x16, 0x00, 0x00, 0x03, 0x24, 0x00, 0x63, 0x7f, 0xbf, 0xc1, 0xc5, 0xaf, 0x88, 0xb6, 0xb9, 0x46, 0x0e, 0xac, 0xa4, 0xc4, 0x27, 0x46, 
+    // 0x0025 CLIENT_CHARACTERISTIC_CONFIGURATION
+    // READ_ANYBODY, WRITE_ANYBODY
+    0x0a, 0x00, 0x0e, 0x01, 0x25, 0x00, 0x02, 0x29, 0x00, 0x00, 
+    // Min interval in ms between input notifications of the same controller. Per client.
+    // 0x0026 CHARACTERISTIC-4627C4A4-AC0F-46B9-B688-AFC5C1BF7F63 - READ | WRITE | DYNAMIC
+    0x1b, 0x00, 0x02, 0x00, 0x26, 0x00, 0x03, 0x28, 0x0a, 0x27, 0x00, 0x63, 0x7f, 0xbf, 0xc1, 0xc5, 0xaf, 0x88, 0xb6, 0xb9, 0x46, 0x0f, 0xac, 0xa4, 0xc4, 0x27, 0x46, 
+    // 0x0027 VALUE CHARACTERISTIC-4627C4A4-AC0F-46B9-B688-AFC5C1BF7F63 - READ | WRITE | DYNAMIC
+    // READ_ANYBODY, WRITE_ANYBODY
+    0x16, 0x00, 0x0a, 0x03, 0x27, 0x00, 0x63, 0x7f, 0xbf, 0xc1, 0xc5, 0xaf, 0x88, 0xb6, 0xb9, 0x46, 0x0f, 0xac, 0xa4, 0xc4, 0x27, 0x46, 
     // add Battery Service
 
 
@@ -130,16 +145,16 @@ const uint8_t profile_data[] =
     // Specification Type org.bluetooth.service.battery_service
     // https://www.bluetooth.com/api/gatt/xmlfile?xmlFileName=org.bluetooth.service.battery_service.xml
     // Battery Service 180F
-    // 0x0023 PRIMARY_SERVICE-ORG_BLUETOOTH_SERVICE_BATTERY_SERVICE
-    0x0a, 0x00, 0x02, 0x00, 0x23, 0x00, 0x00, 0x28, 0x0f, 0x18, 
-    // 0x0024 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_BATTERY_LEVEL - DYNAMIC | READ | NOTIFY
-    0x0d, 0x00, 0x02, 0x00, 0x24, 0x00, 0x03, 0x28, 0x12, 0x25, 0x00, 0x19, 0x2a, 
-    // 0x0025 VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_BATTERY_LEVEL - DYNAMIC | READ | NOTIFY
+    // 0x0028 PRIMARY_SERVICE-ORG_BLUETOOTH_SERVICE_BATTERY_SERVICE
+    0x0a, 0x00, 0x02, 0x00, 0x28, 0x00, 0x00, 0x28, 0x0f, 0x18, 
+    // 0x0029 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_BATTERY_LEVEL - DYNAMIC | READ | NOTIFY
+    0x0d, 0x00, 0x02, 0x00, 0x29, 0x00, 0x03, 0x28, 0x12, 0x2a, 0x00, 0x19, 0x2a, 
+    // 0x002a VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_BATTERY_LEVEL - DYNAMIC | READ | NOTIFY
     // READ_ANYBODY
-    0x08, 0x00, 0x02, 0x01, 0x25, 0x00, 0x19, 0x2a, 
-    // 0x0026 CLIENT_CHARACTERISTIC_CONFIGURATION
+    0x08, 0x00, 0x02, 0x01, 0x2a, 0x00, 0x19, 0x2a, 
+    // 0x002b CLIENT_CHARACTERISTIC_CONFIGURATION
     // READ_ANYBODY, WRITE_ANYBODY
-    0x0a, 0x00, 0x0e, 0x01, 0x26, 0x00, 0x02, 0x29, 0x00, 0x00, 
+    0x0a, 0x00, 0x0e, 0x01, 0x2b, 0x00, 0x02, 0x29, 0x00, 0x00, 
     // #import <battery_service.gatt> -- END
     // add Device ID Service
 
@@ -148,57 +163,57 @@ const uint8_t profile_data[] =
     // Specification Type org.bluetooth.service.device_information
     // https://www.bluetooth.com/api/gatt/xmlfile?xmlFileName=org.bluetooth.service.device_information.xml
     // Device Information 180A
-    // 0x0027 PRIMARY_SERVICE-ORG_BLUETOOTH_SERVICE_DEVICE_INFORMATION
-    0x0a, 0x00, 0x02, 0x00, 0x27, 0x00, 0x00, 0x28, 0x0a, 0x18, 
-    // 0x0028 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_MANUFACTURER_NAME_STRING - DYNAMIC | READ
-    0x0d, 0x00, 0x02, 0x00, 0x28, 0x00, 0x03, 0x28, 0x02, 0x29, 0x00, 0x29, 0x2a, 
-    // 0x0029 VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_MANUFACTURER_NAME_STRING - DYNAMIC | READ
+    // 0x002c PRIMARY_SERVICE-ORG_BLUETOOTH_SERVICE_DEVICE_INFORMATION
+    0x0a, 0x00, 0x02, 0x00, 0x2c, 0x00, 0x00, 0x28, 0x0a, 0x18, 
+    // 0x002d CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_MANUFACTURER_NAME_STRING - DYNAMIC | READ
+    0x0d, 0x00, 0x02, 0x00, 0x2d, 0x00, 0x03, 0x28, 0x02, 0x2e, 0x00, 0x29, 0x2a, 
+    // 0x002e VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_MANUFACTURER_NAME_STRING - DYNAMIC | READ
     // READ_ANYBODY
-    0x08, 0x00, 0x02, 0x01, 0x29, 0x00, 0x29, 0x2a, 
-    // 0x002a CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_MODEL_NUMBER_STRING - DYNAMIC | READ
-    0x0d, 0x00, 0x02, 0x00, 0x2a, 0x00, 0x03, 0x28, 0x02, 0x2b, 0x00, 0x24, 0x2a, 
-    // 0x002b VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_MODEL_NUMBER_STRING - DYNAMIC | READ
+    0x08, 0x00, 0x02, 0x01, 0x2e, 0x00, 0x29, 0x2a, 
+    // 0x002f CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_MODEL_NUMBER_STRING - DYNAMIC | READ
+    0x0d, 0x00, 0x02, 0x00, 0x2f, 0x00, 0x03, 0x28, 0x02, 0x30, 0x00, 0x24, 0x2a, 
+    // 0x0030 VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_MODEL_NUMBER_STRING - DYNAMIC | READ
     // READ_ANYBODY
-    0x08, 0x00, 0x02, 0x01, 0x2b, 0x00, 0x24, 0x2a, 
-    // 0x002c CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_SERIAL_NUMBER_STRING - DYNAMIC | READ
-    0x0d, 0x00, 0x02, 0x00, 0x2c, 0x00, 0x03, 0x28, 0x02, 0x2d, 0x00, 0x25, 0x2a, 
-    // 0x002d VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_SERIAL_NUMBER_STRING - DYNAMIC | READ
+    0x08, 0x00, 0x02, 0x01, 0x30, 0x00, 0x24, 0x2a, 
+    // 0x0031 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_SERIAL_NUMBER_STRING - DYNAMIC | READ
+    0x0d, 0x00, 0x02, 0x00, 0x31, 0x00, 0x03, 0x28, 0x02, 0x32, 0x00, 0x25, 0x2a, 
+    // 0x0032 VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_SERIAL_NUMBER_STRING - DYNAMIC | READ
     // READ_ANYBODY
-    0x08, 0x00, 0x02, 0x01, 0x2d, 0x00, 0x25, 0x2a, 
-    // 0x002e CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_HARDWARE_REVISION_STRING - DYNAMIC | READ
-    0x0d, 0x00, 0x02, 0x00, 0x2e, 0x00, 0x03, 0x28, 0x02, 0x2f, 0x00, 0x27, 0x2a, 
-    // 0x002f VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_HARDWARE_REVISION_STRING - DYNAMIC | READ
+    0x08, 0x00, 0x02, 0x01, 0x32, 0x00, 0x25, 0x2a, 
+    // 0x0033 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_HARDWARE_REVISION_STRING - DYNAMIC | READ
+    0x0d, 0x00, 0x02, 0x00, 0x33, 0x00, 0x03, 0x28, 0x02, 0x34, 0x00, 0x27, 0x2a, 
+    // 0x0034 VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_HARDWARE_REVISION_STRING - DYNAMIC | READ
     // READ_ANYBODY
-    0x08, 0x00, 0x02, 0x01, 0x2f, 0x00, 0x27, 0x2a, 
-    // 0x0030 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_FIRMWARE_REVISION_STRING - DYNAMIC | READ
-    0x0d, 0x00, 0x02, 0x00, 0x30, 0x00, 0x03, 0x28, 0x02, 0x31, 0x00, 0x26, 0x2a, 
-    // 0x0031 VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_FIRMWARE_REVISION_STRING - DYNAMIC | READ
+    0x08, 0x00, 0x02, 0x01, 0x34, 0x00, 0x27, 0x2a, 
+    // 0x0035 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_FIRMWARE_REVISION_STRING - DYNAMIC | READ
+    0x0d, 0x00, 0x02, 0x00, 0x35, 0x00, 0x03, 0x28, 0x02, 0x36, 0x00, 0x26, 0x2a, 
+    // 0x0036 VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_FIRMWARE_REVISION_STRING - DYNAMIC | READ
     // READ_ANYBODY
-    0x08, 0x00, 0x02, 0x01, 0x31, 0x00, 0x26, 0x2a, 
-    // 0x0032 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_SOFTWARE_REVISION_STRING - DYNAMIC | READ
-    0x0d, 0x00, 0x02, 0x00, 0x32, 0x00, 0x03, 0x28, 0x02, 0x33, 0x00, 0x28, 0x2a, 
-    // 0x0033 VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_SOFTWARE_REVISION_STRING - DYNAMIC | READ
+    0x08, 0x00, 0x02, 0x01, 0x36, 0x00, 0x26, 0x2a, 
+    // 0x0037 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_SOFTWARE_REVISION_STRING - DYNAMIC | READ
+    0x0d, 0x00, 0x02, 0x00, 0x37, 0x00, 0x03, 0x28, 0x02, 0x38, 0x00, 0x28, 0x2a, 
+    // 0x0038 VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_SOFTWARE_REVISION_STRING - DYNAMIC | READ
     // READ_ANYBODY
-    0x08, 0x00, 0x02, 0x01, 0x33, 0x00, 0x28, 0x2a, 
-    // 0x0034 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_SYSTEM_ID - DYNAMIC | READ
-    0x0d, 0x00, 0x02, 0x00, 0x34, 0x00, 0x03, 0x28, 0x02, 0x35, 0x00, 0x23, 0x2a, 
-    // 0x0035 VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_SYSTEM_ID - DYNAMIC | READ
+    0x08, 0x00, 0x02, 0x01, 0x38, 0x00, 0x28, 0x2a, 
+    // 0x0039 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_SYSTEM_ID - DYNAMIC | READ
+    0x0d, 0x00, 0x02, 0x00, 0x39, 0x00, 0x03, 0x28, 0x02, 0x3a, 0x00, 0x23, 0x2a, 
+    // 0x003a VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_SYSTEM_ID - DYNAMIC | READ
     // READ_ANYBODY
-    0x08, 0x00, 0x02, 0x01, 0x35, 0x00, 0x23, 0x2a, 
-    // 0x0036 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_IEEE_11073_20601_REGULATORY_CERTIFICATION_DATA_LIST - DYNAMIC | READ
-    0x0d, 0x00, 0x02, 0x00, 0x36, 0x00, 0x03, 0x28, 0x02, 0x37, 0x00, 0x2a, 0x2a, 
-    // 0x0037 VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_IEEE_11073_20601_REGULATORY_CERTIFICATION_DATA_LIST - DYNAMIC | READ
+    0x08, 0x00, 0x02, 0x01, 0x3a, 0x00, 0x23, 0x2a, 
+    // 0x003b CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_IEEE_11073_20601_REGULATORY_CERTIFICATION_DATA_LIST - DYNAMIC | READ
+    0x0d, 0x00, 0x02, 0x00, 0x3b, 0x00, 0x03, 0x28, 0x02, 0x3c, 0x00, 0x2a, 0x2a, 
+    // 0x003c VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_IEEE_11073_20601_REGULATORY_CERTIFICATION_DATA_LIST - DYNAMIC | READ
     // READ_ANYBODY
-    0x08, 0x00, 0x02, 0x01, 0x37, 0x00, 0x2a, 0x2a, 
-    // 0x0038 CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_PNP_ID - DYNAMIC | READ
-    0x0d, 0x00, 0x02, 0x00, 0x38, 0x00, 0x03, 0x28, 0x02, 0x39, 0x00, 0x50, 0x2a, 
-    // 0x0039 VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_PNP_ID - DYNAMIC | READ
+    0x08, 0x00, 0x02, 0x01, 0x3c, 0x00, 0x2a, 0x2a, 
+    // 0x003d CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_PNP_ID - DYNAMIC | READ
+    0x0d, 0x00, 0x02, 0x00, 0x3d, 0x00, 0x03, 0x28, 0x02, 0x3e, 0x00, 0x50, 0x2a, 
+    // 0x003e VALUE CHARACTERISTIC-ORG_BLUETOOTH_CHARACTERISTIC_PNP_ID - DYNAMIC | READ
     // READ_ANYBODY
-    0x08, 0x00, 0x02, 0x01, 0x39, 0x00, 0x50, 0x2a, 
+    0x08, 0x00, 0x02, 0x01, 0x3e, 0x00, 0x50, 0x2a, 
     // #import <device_information_service.gatt> -- END
     // END
     0x00, 0x00, 
-}; // total size 573 bytes 
+}; // total size 627 bytes 
 
 
 //
@@ -213,17 +228,17 @@ const uint8_t profile_data[] =
 #define ATT_SERVICE_GATT_SERVICE_01_START_HANDLE 0x0004
 #define ATT_SERVICE_GATT_SERVICE_01_END_HANDLE 0x0006
 #define ATT_SERVICE_4627C4A4_AC00_46B9_B688_AFC5C1BF7F63_START_HANDLE 0x0007
-#define ATT_SERVICE_4627C4A4_AC00_46B9_B688_AFC5C1BF7F63_END_HANDLE 0x0022
+#define ATT_SERVICE_4627C4A4_AC00_46B9_B688_AFC5C1BF7F63_END_HANDLE 0x0027
 #define ATT_SERVICE_4627C4A4_AC00_46B9_B688_AFC5C1BF7F63_01_START_HANDLE 0x0007
-#define ATT_SERVICE_4627C4A4_AC00_46B9_B688_AFC5C1BF7F63_01_END_HANDLE 0x0022
-#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_BATTERY_SERVICE_START_HANDLE 0x0023
-#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_BATTERY_SERVICE_END_HANDLE 0x0026
-#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_BATTERY_SERVICE_01_START_HANDLE 0x0023
-#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_BATTERY_SERVICE_01_END_HANDLE 0x0026
-#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_DEVICE_INFORMATION_START_HANDLE 0x0027
-#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_DEVICE_INFORMATION_END_HANDLE 0x0039
-#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_DEVICE_INFORMATION_01_START_HANDLE 0x0027
-#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_DEVICE_INFORMATION_01_END_HANDLE 0x0039
+#define ATT_SERVICE_4627C4A4_AC00_46B9_B688_AFC5C1BF7F63_01_END_HANDLE 0x0027
+#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_BATTERY_SERVICE_START_HANDLE 0x0028
+#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_BATTERY_SERVICE_END_HANDLE 0x002b
+#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_BATTERY_SERVICE_01_START_HANDLE 0x0028
+#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_BATTERY_SERVICE_01_END_HANDLE 0x002b
+#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_DEVICE_INFORMATION_START_HANDLE 0x002c
+#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_DEVICE_INFORMATION_END_HANDLE 0x003e
+#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_DEVICE_INFORMATION_01_START_HANDLE 0x002c
+#define ATT_SERVICE_ORG_BLUETOOTH_SERVICE_DEVICE_INFORMATION_01_END_HANDLE 0x003e
 
 //
 // list mapping between characteristics and handles
@@ -244,14 +259,17 @@ const uint8_t profile_data[] =
 #define ATT_CHARACTERISTIC_4627C4A4_AC0B_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE 0x001e
 #define ATT_CHARACTERISTIC_4627C4A4_AC0C_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE 0x0020
 #define ATT_CHARACTERISTIC_4627C4A4_AC0D_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE 0x0022
-#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_BATTERY_LEVEL_01_VALUE_HANDLE 0x0025
-#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_BATTERY_LEVEL_01_CLIENT_CONFIGURATION_HANDLE 0x0026
-#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_MANUFACTURER_NAME_STRING_01_VALUE_HANDLE 0x0029
-#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_MODEL_NUMBER_STRING_01_VALUE_HANDLE 0x002b
-#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_SERIAL_NUMBER_STRING_01_VALUE_HANDLE 0x002d
-#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_HARDWARE_REVISION_STRING_01_VALUE_HANDLE 0x002f
-#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_FIRMWARE_REVISION_STRING_01_VALUE_HANDLE 0x0031
-#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_SOFTWARE_REVISION_STRING_01_VALUE_HANDLE 0x0033
-#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_SYSTEM_ID_01_VALUE_HANDLE 0x0035
-#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_IEEE_11073_20601_REGULATORY_CERTIFICATION_DATA_LIST_01_VALUE_HANDLE 0x0037
-#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_PNP_ID_01_VALUE_HANDLE 0x0039
+#define ATT_CHARACTERISTIC_4627C4A4_AC0E_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE 0x0024
+#define ATT_CHARACTERISTIC_4627C4A4_AC0E_46B9_B688_AFC5C1BF7F63_01_CLIENT_CONFIGURATION_HANDLE 0x0025
+#define ATT_CHARACTERISTIC_4627C4A4_AC0F_46B9_B688_AFC5C1BF7F63_01_VALUE_HANDLE 0x0027
+#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_BATTERY_LEVEL_01_VALUE_HANDLE 0x002a
+#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_BATTERY_LEVEL_01_CLIENT_CONFIGURATION_HANDLE 0x002b
+#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_MANUFACTURER_NAME_STRING_01_VALUE_HANDLE 0x002e
+#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_MODEL_NUMBER_STRING_01_VALUE_HANDLE 0x0030
+#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_SERIAL_NUMBER_STRING_01_VALUE_HANDLE 0x0032
+#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_HARDWARE_REVISION_STRING_01_VALUE_HANDLE 0x0034
+#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_FIRMWARE_REVISION_STRING_01_VALUE_HANDLE 0x0036
+#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_SOFTWARE_REVISION_STRING_01_VALUE_HANDLE 0x0038
+#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_SYSTEM_ID_01_VALUE_HANDLE 0x003a
+#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_IEEE_11073_20601_REGULATORY_CERTIFICATION_DATA_LIST_01_VALUE_HANDLE 0x003c
+#define ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_PNP_ID_01_VALUE_HANDLE 0x003e
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#ifndef UNI_AXIS_SHAPING_H
+#define UNI_AXIS_SHAPING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "controller/uni_gamepad.h"
+
+// Deadzone, anti-deadzone and response curve for sticks and pedals.
+// Applied after the mappings to the copy of the gamepad that the platform gets. The device
+// state is left unshaped, so re-reported values are never shaped twice.
+// Each curve gets compiled into a lookup table, so applying it is a table load per axis.
+// The global configuration is stored in uni_property. Devices might use their own, see
+// uni_hid_device_set_axis_shaping().
+
+// Curve values go from 0 to UNI_AXIS_SHAPING_MAX: the whole range of a pedal, or half the range of a stick.
+#define UNI_AXIS_SHAPING_LUT_SIZE 1024
+#define UNI_AXIS_SHAPING_MAX (UNI_AXIS_SHAPING_LUT_SIZE - 1)
+// Max points of a custom curve. (0,0) and (MAX,MAX) are implicit.
+#define UNI_AXIS_SHAPING_MAX_POINTS 8
+
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+} uni_axis_point_t;
+
+typedef struct {
+    uint16_t deadzone;       // Inputs up to this value are reported as 0
+    uint16_t anti_deadzone;  // Smallest output after the deadzone. Compensates the deadzone of the game
+    uint16_t expo;           // 0: linear. UNI_AXIS_SHAPING_MAX: cubic. Ignored if it has points
+    uint8_t num_points;
+    uni_axis_point_t points[UNI_AXIS_SHAPING_MAX_POINTS];  // Custom curve, sorted by "x"
+} uni_axis_curve_t;
+
+typedef struct {
+    uni_axis_curve_t stick;
+    uni_axis_curve_t pedal;
+    bool stick_axial;  // Deadzone per axis instead of on the stick distance from the center
+} uni_axis_shaping_config_t;
+
+typedef struct {
+    int16_t stick[UNI_AXIS_SHAPING_LUT_SIZE];  // Indexed by the stick distance from the center
+    int16_t pedal[UNI_AXIS_SHAPING_LUT_SIZE];
+    bool stick_axial;
+    bool stick_linear;  // No deadzone and linear: nothing to do
+    bool pedal_linear;
+} uni_axis_shaping_t;
+
+void uni_axis_shaping_init(void);
+
+// Global configuration. Stored in uni_property.
+void uni_axis_shaping_set_config(const uni_axis_shaping_config_t* config);
+void uni_axis_shaping_get_config(uni_axis_shaping_config_t* config);
+
+// Compiles "config" into "shaping". Invalid values are logged and ignored.
+void uni_axis_shaping_compile(const uni_axis_shaping_config_t* config, uni_axis_shaping_t* shaping);
+// Applies "shaping" to the gamepad sticks and pedals. NULL uses the global configuration.
+void uni_axis_shaping_apply(const uni_axis_shaping_t* shaping, uni_gamepad_t* gp);
+
+// Custom curves, as stored in uni_property: "x:y,x:y,...". Returns false if invalid.
+bool uni_axis_shaping_parse_points(const char* str, uni_axis_curve_t* curve);
+// "str" should have room for UNI_AXIS_SHAPING_POINTS_STR_LEN bytes.
+#define UNI_AXIS_SHAPING_POINTS_STR_LEN (UNI_AXIS_SHAPING_MAX_POINTS * 10)
+void uni_axis_shaping_format_points(const uni_axis_curve_t* curve, char* str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // UNI_AXIS_SHAPING_H
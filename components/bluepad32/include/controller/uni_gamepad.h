@@ -58,6 +58,10 @@ typedef enum {
     UNI_GAMEPAD_MAPPINGS_AXIS_RY,
 } uni_gamepad_mappings_axis_t;
 
+// Fixed point scale for the orientation and gravity: Q14.
+#define UNI_GAMEPAD_ORIENTATION_ONE_SHIFT 14
+#define UNI_GAMEPAD_ORIENTATION_ONE (1 << UNI_GAMEPAD_ORIENTATION_ONE_SHIFT)
+
 typedef enum {
     UNI_GAMEPAD_MAPPINGS_PEDAL_BRAKE,
     UNI_GAMEPAD_MAPPINGS_PEDAL_THROTTLE,
@@ -138,6 +142,7 @@ typedef enum {
 //  axis-L button                      axis-R button
 //  Gyro: is measured in degress/second
 //  Accelerometer: is measured in "G"s
+//  Orientation & gravity: fixed point, see UNI_GAMEPAD_ORIENTATION_ONE
 
 typedef struct {
     // Usage Page: 0x01 (Generic Desktop Controls)
@@ -159,6 +164,10 @@ typedef struct {
 
     int32_t gyro[3];
     int32_t accel[3];
+
+    // Only when motion fusion is enabled. All zeros otherwise.
+    int32_t orientation[4];  // Unit quaternion: w, x, y, z. UNI_GAMEPAD_ORIENTATION_ONE is 1.0
+    int32_t gravity[3];      // Unit vector, "up" as seen from the controller. Same scale as orientation
 } uni_gamepad_t;
 
 // Represents the mapping. Each entry contains the new button to be used,
@@ -206,11 +215,29 @@ typedef struct {
     uint8_t throttle;
 } uni_gamepad_mappings_t;
 
+// Buttons that live in the high byte of "buttons": BUTTON_THUMB_L and BUTTON_THUMB_R.
+#define UNI_GAMEPAD_MAPPINGS_BUTTONS_HI_BITS 2
+
+// Mappings compiled into lookup tables, so that remapping a report is just a few table loads.
+// Built by uni_gamepad_mappings_compile().
+typedef struct {
+    uint16_t buttons_lo[256];                                        // Indexed by "buttons" bits 0-7
+    uint16_t buttons_hi[BIT(UNI_GAMEPAD_MAPPINGS_BUTTONS_HI_BITS)];  // Indexed by "buttons" bits 8 and up
+    uint8_t dpad[16];
+    uint8_t misc_buttons[16];
+    uint8_t axis[4];      // Source for x, y, rx, ry. See uni_gamepad_mappings_axis_t
+    int8_t axis_sign[4];  // -1 if inverted
+    uint8_t pedal[2];     // Source for brake, throttle. See uni_gamepad_mappings_pedal_t
+} uni_gamepad_mappings_lut_t;
+
 extern const uni_gamepad_mappings_t GAMEPAD_DEFAULT_MAPPINGS;
 
 void uni_gamepad_dump(const uni_gamepad_t* gp);
 
 uni_gamepad_t uni_gamepad_remap(const uni_gamepad_t* gp);
+// Remaps "gp" with the given tables. Used for per-device mappings.
+uni_gamepad_t uni_gamepad_remap_with_lut(const uni_gamepad_t* gp, const uni_gamepad_mappings_lut_t* lut);
+void uni_gamepad_mappings_compile(const uni_gamepad_mappings_t* mappings, uni_gamepad_mappings_lut_t* lut);
 void uni_gamepad_set_mappings(const uni_gamepad_mappings_t* mapping);
 void uni_gamepad_set_mappings_type(uni_gamepad_mappings_type_t type);
 uni_gamepad_mappings_type_t uni_gamepad_get_mappings_type(void);
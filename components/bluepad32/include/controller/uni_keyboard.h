@@ -9,14 +9,21 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "uni_common.h"
+#include "uni_ring.h"
 
 // Array of pressed keys. Hardcode it at 10.
 // We expect that keyboards won't support more than 10 press keys at the same time,
 // since we have a max of 10 fingers.
+// N-key rollover keyboards might report more. All of them are in "pressed_bitmap".
 #define UNI_KEYBOARD_PRESSED_KEYS_MAX 10
+// One bit per usage of the "Keyboard/Keypad" page, modifiers included.
+#define UNI_KEYBOARD_BITMAP_LEN (256 / 8)
+// Must be a power of two.
+#define UNI_KEYBOARD_RING_SIZE 32
 
 // Instead of using the HID_USAGE values, we use a special field for them.
 // Easier to parse.
@@ -37,10 +44,44 @@ typedef struct {
     uint8_t pressed_keys[UNI_KEYBOARD_PRESSED_KEYS_MAX];
     // Reserved for future use, like "Consumer page": eject, play, pause keyboard buttons.
     uint8_t reserved[16];
+    // All the pressed keys, indexed by usage. Not limited to UNI_KEYBOARD_PRESSED_KEYS_MAX.
+    uint8_t pressed_bitmap[UNI_KEYBOARD_BITMAP_LEN];
 } uni_keyboard_t;
 
+typedef struct {
+    uint32_t timestamp_ms;  // When the report was received. Same time base as btstack_run_loop_get_time_ms()
+    uint8_t key;            // Usage of the "Keyboard/Keypad" page. Modifiers are reported as keys too
+    uint8_t modifiers;      // Modifiers after the event
+    bool pressed;           // False when released
+} uni_keyboard_event_t;
+
+// Key events, generated by comparing each report with the previous one.
+// Typed wrapper of uni_ring_t.
+// Single producer, single consumer. Not thread safe.
+// When full, the oldest event gets overwritten.
+typedef struct {
+    uni_keyboard_event_t events[UNI_KEYBOARD_RING_SIZE];
+    uni_ring_t ring;
+    uint8_t prev_bitmap[UNI_KEYBOARD_BITMAP_LEN];  // Keys pressed in the previous report
+} uni_keyboard_ring_t;
+
 void uni_keyboard_dump(const uni_keyboard_t* kb);
 
+void uni_keyboard_set_key_pressed(uni_keyboard_t* kb, uint8_t key);
+bool uni_keyboard_is_key_pressed(const uni_keyboard_t* kb, uint8_t key);
+
+void uni_keyboard_ring_reset(uni_keyboard_ring_t* ring);
+void uni_keyboard_ring_push(uni_keyboard_ring_t* ring, const uni_keyboard_event_t* event);
+// Compares "kb" with the previous report, and pushes an event for each key that changed:
+// releases first, then presses. Within each group, in usage order.
+// Reports with ErrorRollOver are ignored: the keys pressed in the previous report are still held.
+void uni_keyboard_ring_update(uni_keyboard_ring_t* ring, const uni_keyboard_t* kb, uint32_t timestamp_ms);
+// Removes up to "max" events, oldest first. Returns the number of events copied to "out".
+int uni_keyboard_ring_read(uni_keyboard_ring_t* ring, uni_keyboard_event_t* out, int max);
+// Like uni_keyboard_ring_read(), but without removing them. Copies up to "max" events pushed after "cursor",
+// and advances "cursor". Events that are no longer available are skipped.
+int uni_keyboard_ring_peek(const uni_keyboard_ring_t* ring, uint32_t* cursor, uni_keyboard_event_t* out, int max);
+
 #ifdef __cplusplus
 }
 #endif
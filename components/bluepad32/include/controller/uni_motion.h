@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#ifndef UNI_MOTION_H
+#define UNI_MOTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "controller/uni_gamepad.h"
+#include "uni_ring.h"
+
+// Motion samples (gyro / accel) at the rate the controller samples them.
+// Some controllers pack more than one sample per report, like Switch, which reports
+// 3 samples at 200Hz. uni_gamepad_t only has the latest one.
+
+// Must be a power of two. Enough for ~80ms of Switch samples.
+#define UNI_MOTION_RING_SIZE 16
+
+typedef struct {
+    uint32_t timestamp_ms;  // When it was sampled. Same time base as btstack_run_loop_get_time_ms()
+    int32_t gyro[3];        // Same units as uni_gamepad_t. Zero when the controller has no gyro
+    int32_t accel[3];       // Same units as uni_gamepad_t
+} uni_motion_sample_t;
+
+// Typed wrapper of uni_ring_t.
+// Single producer, single consumer. Not thread safe.
+// When full, the oldest sample gets overwritten.
+typedef struct {
+    uni_motion_sample_t samples[UNI_MOTION_RING_SIZE];
+    uni_ring_t ring;
+} uni_motion_ring_t;
+
+void uni_motion_ring_reset(uni_motion_ring_t* ring);
+void uni_motion_ring_push(uni_motion_ring_t* ring, const uni_motion_sample_t* sample);
+// Pushes the gyro / accel values from "gp". For controllers that have one sample per report.
+void uni_motion_ring_push_gamepad(uni_motion_ring_t* ring, const uni_gamepad_t* gp, uint32_t timestamp_ms);
+// Removes up to "max" samples, oldest first. Returns the number of samples copied to "out".
+int uni_motion_ring_read(uni_motion_ring_t* ring, uni_motion_sample_t* out, int max);
+// Like uni_motion_ring_read(), but without removing them. Copies up to "max" samples pushed after "cursor",
+// and advances "cursor". Samples that are no longer available are skipped.
+int uni_motion_ring_peek(const uni_motion_ring_t* ring, uint32_t* cursor, uni_motion_sample_t* out, int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // UNI_MOTION_H
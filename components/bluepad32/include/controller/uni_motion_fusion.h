@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#ifndef UNI_MOTION_FUSION_H
+#define UNI_MOTION_FUSION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "controller/uni_gamepad.h"
+#include "controller/uni_motion.h"
+
+// Optional sensor fusion: a fixed-point Mahony filter that turns the gyro / accel samples
+// into an orientation quaternion and a gravity vector.
+// Gyro bias gets estimated while the controller is at rest.
+// Controllers without gyro, like the Wiimote, only get tilt (no yaw) from the accelerometer.
+
+typedef struct {
+    int32_t q[4];               // Orientation: w, x, y, z. Q30
+    int32_t gyro_bias[3];       // Gyro units, Q4
+    int32_t prev_gyro[3];       // Used to detect whether the controller is at rest
+    int32_t prev_accel[3];      // Same
+    uint32_t gyro_res_per_dps;  // Set by the parser. Gyro units per degree/second. 0 if it has no gyro
+    uint32_t cursor;            // Last sample processed from the motion ring
+    uint32_t last_timestamp_ms;
+    uint16_t rest_ms;  // For how long the controller has been at rest
+    bool initialized;
+} uni_motion_fusion_t;
+
+void uni_motion_fusion_init(void);
+void uni_motion_fusion_set_enabled(bool enabled);
+bool uni_motion_fusion_is_enabled(void);
+
+// Processes the samples pushed to "ring" since the last call, and updates the gamepad
+// orientation and gravity. Does nothing if the fusion is disabled.
+void uni_motion_fusion_update(uni_motion_fusion_t* fusion, const uni_motion_ring_t* ring, uni_gamepad_t* gp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // UNI_MOTION_FUSION_H
@@ -26,12 +26,20 @@ enum {
     UNI_MOUSE_BUTTON_AUX_5 = BIT(8),
 };
 
+// High-resolution wheel units per detent. Same as Windows' WHEEL_DELTA.
+#define UNI_MOUSE_WHEEL_HIRES_UNITS 120
+
 typedef struct {
     int32_t delta_x;
     int32_t delta_y;
     uint16_t buttons;
     int8_t scroll_wheel;
     uint8_t misc_buttons;
+    int8_t pan;  // Horizontal wheel (AC Pan). Negative: left, positive: right
+    // Same as "scroll_wheel" and "pan", in 1/UNI_MOUSE_WHEEL_HIRES_UNITS of a detent.
+    // Only finer than a detent on mice with a Resolution Multiplier.
+    int16_t scroll_wheel_hires;
+    int16_t pan_hires;
 } uni_mouse_t;
 
 void uni_mouse_dump(const uni_mouse_t* ms);
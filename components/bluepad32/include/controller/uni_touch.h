@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#ifndef UNI_TOUCH_H
+#define UNI_TOUCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "uni_ring.h"
+
+// Touchpad events, like the ones from DualShock 4 and DualSense.
+// Each touch frame has up to two points. DualShock 4 buffers up to four frames per report.
+
+// Must be a power of two. Enough for two full DualShock 4 reports.
+#define UNI_TOUCH_RING_SIZE 16
+// Points per touch frame.
+#define UNI_TOUCH_MAX_POINTS 2
+
+typedef struct {
+    uint32_t timestamp_ms;  // When it was received. Same time base as btstack_run_loop_get_time_ms()
+    uint16_t x;             // Absolute coordinates, in touchpad units
+    uint16_t y;
+    uint8_t finger_id;  // Assigned by the controller when the finger touches the pad
+    uint8_t point;      // Point within the frame: 0 or 1
+    uint8_t frame;      // Frame counter, as reported by the controller. Points of the same frame share it
+    bool contact;       // False when the finger was released. Reported once per release
+} uni_touch_event_t;
+
+// Typed wrapper of uni_ring_t.
+// Single producer, single consumer. Not thread safe.
+// When full, the oldest event gets overwritten.
+typedef struct {
+    uni_touch_event_t events[UNI_TOUCH_RING_SIZE];
+    uni_ring_t ring;
+    uint8_t active_points;  // Bitmask of points in contact. Used to report the release only once
+} uni_touch_ring_t;
+
+// Converts the touch events into relative movement, following one finger. Used by the virtual mouse.
+typedef struct {
+    uint32_t cursor;  // Last event processed from the touch ring
+    uint16_t x;       // Latest position of the tracked finger
+    uint16_t y;
+    uint8_t finger_id;
+    bool tracking;
+} uni_touch_mouse_t;
+
+void uni_touch_ring_reset(uni_touch_ring_t* ring);
+void uni_touch_ring_push(uni_touch_ring_t* ring, const uni_touch_event_t* event);
+// Pushes a point, as parsed from a touch frame. Points without contact are pushed only
+// if they were in contact in the previous frame.
+void uni_touch_ring_push_point(uni_touch_ring_t* ring,
+                               uint8_t point,
+                               uint8_t frame,
+                               uint8_t finger_id,
+                               bool contact,
+                               uint16_t x,
+                               uint16_t y,
+                               uint32_t timestamp_ms);
+// Removes up to "max" events, oldest first. Returns the number of events copied to "out".
+int uni_touch_ring_read(uni_touch_ring_t* ring, uni_touch_event_t* out, int max);
+// Like uni_touch_ring_read(), but without removing them. Copies up to "max" events pushed after "cursor",
+// and advances "cursor". Events that are no longer available are skipped.
+int uni_touch_ring_peek(const uni_touch_ring_t* ring, uint32_t* cursor, uni_touch_event_t* out, int max);
+
+// Processes the events pushed since the last call, and returns the movement of the tracked finger.
+// Returns true if a finger is being tracked.
+bool uni_touch_mouse_update(uni_touch_mouse_t* tm, const uni_touch_ring_t* ring, int32_t* delta_x, int32_t* delta_y);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // UNI_TOUCH_H
@@ -32,6 +32,7 @@ extern "C" {
 #define HID_USAGE_AXIS_RZ                       0x35
 #define HID_USAGE_WHEEL                         0x38
 #define HID_USAGE_HAT                           0x39
+#define HID_USAGE_RESOLUTION_MULTIPLIER         0x48
 #define HID_USAGE_SYSTEM_MAIN_MENU              0x85
 #define HID_USAGE_DPAD_UP                       0x90
 #define HID_USAGE_DPAD_DOWN                     0x91
@@ -5,6 +5,7 @@
 #ifndef UNI_HID_PARSER_H
 #define UNI_HID_PARSER_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 // Forward declarations
@@ -49,6 +50,8 @@ typedef void (*report_play_dual_rumble_fn_t)(struct uni_hid_device_s* d,
                                              uint8_t weak_magnitude,
                                              uint8_t strong_magnitude);
 typedef void (*report_device_dump_t)(struct uni_hid_device_s* d);
+// success: whether the device accepted the report.
+typedef void (*report_set_report_result_fn_t)(struct uni_hid_device_s* d, bool success);
 
 // Parsers should implement these optional functions:
 typedef struct {
@@ -70,6 +73,9 @@ typedef struct {
     report_play_dual_rumble_fn_t play_dual_rumble;
     // If implemented, it dumps device info
     report_device_dump_t device_dump;
+    // Called when the device answers a report sent on the control channel (BR/EDR HANDSHAKE),
+    // or when a report write completes (BLE GATT write response)
+    report_set_report_result_fn_t set_report_result;
 } uni_report_parser_t;
 
 void uni_hid_parse_input_report(struct uni_hid_device_s* d, const uint8_t* report, uint16_t report_len);
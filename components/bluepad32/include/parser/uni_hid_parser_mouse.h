@@ -19,5 +19,14 @@ void uni_hid_parser_mouse_parse_usage(struct uni_hid_device_s* d,
                                       uint16_t usage,
                                       int32_t value);
 void uni_hid_parser_mouse_device_dump(struct uni_hid_device_s* d);
+void uni_hid_parser_mouse_set_report_result(struct uni_hid_device_s* d, bool success);
+
+// Overrides the per-mouse scale. Values lower than 1 make the mouse slower.
+void uni_hid_parser_mouse_set_scale(struct uni_hid_device_s* d, float scale_x, float scale_y);
+// Scale applied to all mice, on top of the per-mouse one. Stored in uni_property ("bp.mouse.scale").
+// Takes effect immediately. It changes the deltas that every platform gets, like Arduino and NINA,
+// not only the quadrature output of Unijoysticle.
+void uni_hid_parser_mouse_set_global_scale(float scale);
+float uni_hid_parser_mouse_get_global_scale(void);
 
 #endif  // UNI_HID_PARSER_MOUSE_H
\ No newline at end of file
@@ -16,6 +16,16 @@ typedef enum wii_flags {
     WII_MODE_ACCEL = 2,
 } wii_mode_t;
 
+// Data that the platform consumes from the Wii Remote. The driver requests the smallest
+// data reporting mode (DRM) that covers it: less data per report means less airtime per Wii Remote.
+// Devices whose data comes only from the extension (Classic, Wii U Pro, Balance Board) are not affected.
+typedef enum {
+    WII_DATA_BUTTONS = 0,        // Buttons only. Accelerometer is still reported in "accel mode"
+    WII_DATA_ACCEL = BIT(0),     // Accelerometer, regardless of the mode
+    WII_DATA_NUNCHUK = BIT(1),   // Nunchuk, when attached
+    WII_DATA_DEFAULT = WII_DATA_NUNCHUK,
+} wii_data_t;
+
 void uni_hid_parser_wii_setup(struct uni_hid_device_s* d);
 void uni_hid_parser_wii_init_report(struct uni_hid_device_s* d);
 void uni_hid_parser_wii_parse_input_report(struct uni_hid_device_s* d, const uint8_t* report, uint16_t len);
@@ -29,5 +39,8 @@ void uni_hid_parser_wii_device_dump(struct uni_hid_device_s* d);
 
 // Unique to Wii. Not part of the "hid_parser" interface
 void uni_hid_parser_wii_set_mode(struct uni_hid_device_s* d, wii_mode_t mode);
+// "data" is a combination of wii_data_t. Applies to the devices that connect afterwards.
+void uni_hid_parser_wii_set_data_policy(uint8_t data);
+uint8_t uni_hid_parser_wii_get_data_policy(void);
 
 #endif  // UNI_HID_PARSER_WII_H
@@ -19,6 +19,7 @@ extern "C" {
 typedef enum {
     UNI_PLATFORM_OOB_GAMEPAD_SYSTEM_BUTTON,  // When the gamepad "system" button was pressed
     UNI_PLATFORM_OOB_BLUETOOTH_ENABLED,      // When Bluetooth is "scanning"
+    UNI_PLATFORM_OOB_LINK_QUALITY_LOW,       // When the link quality drops below the threshold. data: the device
 } uni_platform_oob_event_t;
 
 // uni_platform must be defined for each new platform that is implemented.
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2020 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#ifndef UNI_PLATFORM_NINA_PROTOCOL_H
+#define UNI_PLATFORM_NINA_PROTOCOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// NINA / AirLift protocol layer.
+// Parses the requests and generates the responses, but knows nothing about
+// the transport (SPI-slave on ESP32). Anything that is target specific, like
+// GPIOs and locks, is provided by the transport with uni_nina_protocol_ops_t.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "controller/uni_controller.h"
+#include "uni_hid_device.h"
+
+// Max size of a request / response.
+// Must be modulo 4 and word aligned.
+#define UNI_NINA_PROTOCOL_BUFFER_LEN 256
+
+// Handlers read their arguments from fixed offsets. Bytes past the received
+// length, up to this value, must be cleared by the transport so that short
+// commands don't pick up stale values from a previous request.
+#define UNI_NINA_PROTOCOL_COMMAND_MIN_LEN 16
+
+// Requests that must be processed from the Bluetooth thread.
+enum {
+    UNI_NINA_PENDING_REQUEST_CMD_NONE = 0,
+    UNI_NINA_PENDING_REQUEST_CMD_LIGHTBAR_COLOR = 1,
+    UNI_NINA_PENDING_REQUEST_CMD_PLAYER_LEDS = 2,
+    UNI_NINA_PENDING_REQUEST_CMD_RUMBLE = 3,
+    UNI_NINA_PENDING_REQUEST_CMD_DISCONNECT = 4,
+};
+
+typedef struct {
+    uint8_t controller_idx;
+    uint8_t cmd;
+    uint8_t args[8];
+} uni_nina_pending_request_t;
+
+// Arduino pinMode() values.
+enum {
+    UNI_NINA_PIN_MODE_INPUT = 0,
+    UNI_NINA_PIN_MODE_OUTPUT = 1,
+    UNI_NINA_PIN_MODE_INPUT_PULLUP = 2,
+};
+
+typedef struct {
+    // Protects the controller data, shared by the transport and Bluetooth threads.
+    void (*lock)(void);
+    void (*unlock)(void);
+
+    // Queues a request to be processed from the Bluetooth thread.
+    void (*queue_pending_request)(const uni_nina_pending_request_t* request);
+
+    // GPIO related. Return false if the pin is not valid.
+    bool (*set_pin_mode)(uint8_t pin, uint8_t mode);
+    bool (*digital_write)(uint8_t pin, uint8_t value);
+    bool (*analog_write)(uint8_t pin, uint8_t value);
+    uint8_t (*digital_read)(uint8_t pin);
+    uint16_t (*analog_read)(uint8_t pin);
+
+    // Configures "pin" as the "data available" output.
+    // Returns false if the pin cannot be used, like the ones used by the transport.
+    bool (*reserve_data_available_gpio)(uint8_t pin);
+} uni_nina_protocol_ops_t;
+
+void uni_nina_protocol_init(const uni_nina_protocol_ops_t* ops);
+
+// Processes one request, and puts the answer in "response". Returns the response length.
+// "response" must be at least UNI_NINA_PROTOCOL_BUFFER_LEN bytes.
+int uni_nina_protocol_process_request(const uint8_t command[], int command_len, uint8_t response[]);
+
+// Controller state, called from the Bluetooth thread.
+uint8_t uni_nina_protocol_get_seats(void);
+void uni_nina_protocol_on_controller_ready(int idx, uni_hid_device_t* d);
+void uni_nina_protocol_on_controller_disconnected(int idx);
+void uni_nina_protocol_on_controller_data(int idx, const uni_controller_t* ctl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // UNI_PLATFORM_NINA_PROTOCOL_H
@@ -99,8 +99,10 @@ typedef struct uni_platform_unijoysticle_instance_s {
     // Used by Balance Board to determine joystick movements/fire
     uni_balance_board_state_t bb_state;
 
-    // Debouncer for buttons and keys
+    // Debouncer for buttons
     uint32_t debouncer;
+    // Last event processed from the key event ring
+    uint32_t key_events_cursor;
 } uni_platform_unijoysticle_instance_t;
 _Static_assert(sizeof(uni_platform_unijoysticle_instance_t) < HID_DEVICE_MAX_PLATFORM_DATA,
                "Unijoysticle intance too big");
@@ -10,8 +10,13 @@
 #include <stdint.h>
 
 #include "bt/uni_bt_conn.h"
+#include "controller/uni_axis_shaping.h"
 #include "controller/uni_controller.h"
 #include "controller/uni_controller_type.h"
+#include "controller/uni_keyboard.h"
+#include "controller/uni_motion.h"
+#include "controller/uni_motion_fusion.h"
+#include "controller/uni_touch.h"
 #include "parser/uni_hid_parser.h"
 #include "uni_circular_buffer.h"
 #include "uni_error.h"
@@ -22,6 +27,8 @@
 #define HID_DEVICE_MAX_PLATFORM_DATA 256
 // HID_DEVICE_CONNECTION_TIMEOUT_MS includes the time from when the device is created until it is ready.
 #define HID_DEVICE_CONNECTION_TIMEOUT_MS 20000
+// Discovered devices with a lower RSSI are considered too far away.
+#define HID_DEVICE_MIN_RSSI (255 - 100)
 
 typedef enum {
     SDP_QUERY_AFTER_CONNECT,   // If not set, this is the default one.
@@ -42,6 +49,8 @@ struct uni_hid_device_s {
     btstack_timer_source_t connection_timer;
     // Max amount of time to wait to get the device name.
     btstack_timer_source_t inquiry_remote_name_timer;
+    // Max amount of time to wait for the SDP query, once it was started.
+    btstack_timer_source_t sdp_query_timer;
 
     // SDP
     uint8_t hid_descriptor[HID_MAX_DESCRIPTOR_LEN];
@@ -65,6 +74,17 @@ struct uni_hid_device_s {
     uni_controller_type_t controller_type;        // type of controller. E.g: DualShock4, Switch, etc.
     uni_controller_subtype_t controller_subtype;  // sub-type of controller attached, used for Wii mostly
     uni_controller_t controller;                  // Data
+    // Motion samples, at the controller sampling rate. Filled by the parsers that support gyro / accel.
+    uni_motion_ring_t motion;
+    uni_motion_fusion_t motion_fusion;
+    // Touchpad events. Filled by the parsers that support multitouch.
+    uni_touch_ring_t touch;
+    // Key press / release events. Filled from the keyboard reports.
+    uni_keyboard_ring_t key_events;
+    // Mappings for this device only. NULL uses the global ones. Owned by the caller.
+    const uni_gamepad_mappings_lut_t* mappings;
+    // Deadzone and response curve for this device only. NULL uses the global ones. Owned by the caller.
+    const uni_axis_shaping_t* axis_shaping;
 
     // Functions used to parse the usage page/usage.
     uni_report_parser_t report_parser;
@@ -111,6 +131,8 @@ uni_hid_device_t* uni_hid_device_create(bd_addr_t address);
 // Used for controllers that implement two input devices like DualShock4, which is a gamepad and a mouse
 // at the same time. The mouse will be the "virtual" device in this case.
 uni_hid_device_t* uni_hid_device_create_virtual(uni_hid_device_t* parent);
+// Number of device slots not in use, including the ones being connected.
+int uni_hid_device_get_free_slots_count(void);
 
 // Don't add any other get_instance_for_XXX function.
 // Instead use: get_instance_with_predicate()
@@ -171,6 +193,13 @@ void uni_hid_device_guess_controller_type_from_pid_vid(uni_hid_device_t* d);
 bool uni_hid_device_has_controller_type(uni_hid_device_t* d);
 
 void uni_hid_device_process_controller(uni_hid_device_t* d);
+// Overrides the global gamepad mappings for this device. NULL restores the global ones.
+// Meant to be called by the platforms, like from on_device_ready(). "lut" is built with
+// uni_gamepad_mappings_compile(), and must remain valid while in use. Cleared when the device disconnects.
+void uni_hid_device_set_mappings(uni_hid_device_t* d, const uni_gamepad_mappings_lut_t* lut);
+// Overrides the global deadzone and response curve for this device. NULL restores the global ones.
+// "shaping" must remain valid while in use. Cleared when the device disconnects.
+void uni_hid_device_set_axis_shaping(uni_hid_device_t* d, const uni_axis_shaping_t* shaping);
 
 void uni_hid_device_set_connection_handle(uni_hid_device_t* d, hci_con_handle_t handle);
 
@@ -15,11 +15,30 @@
 #define UNI_PROPERTY_NAME_ALLOWLIST_ENABLED "bp.bt.allow_en"
 #define UNI_PROPERTY_NAME_ALLOWLIST_LIST "bp.bt.allowlist"
 #define UNI_PROPERTY_NAME_BLE_ENABLED "bp.ble.enabled"
+#define UNI_PROPERTY_NAME_BREDR_FLUSH_TIMEOUT "bp.br.flush_ms"
+#define UNI_PROPERTY_NAME_BREDR_QOS_ENABLED "bp.br.qos"
+#define UNI_PROPERTY_NAME_BREDR_SNIFF_IDLE "bp.br.sniff_ms"
 #define UNI_PROPERTY_NAME_GAP_INQ_LEN "bp.gap.inq_len"
 #define UNI_PROPERTY_NAME_GAP_LEVEL "bp.gap.level"
 #define UNI_PROPERTY_NAME_GAP_MAX_PERIODIC_LEN "bp.gap.max_len"
 #define UNI_PROPERTY_NAME_GAP_MIN_PERIODIC_LEN "bp.gap.min_len"
+#define UNI_PROPERTY_NAME_LINK_QUALITY_MIN "bp.lq.min"
+#define UNI_PROPERTY_NAME_LINK_QUALITY_PERIOD "bp.lq.period"
+#define UNI_PROPERTY_NAME_LINK_QUALITY_RSSI_MIN "bp.lq.rssi_min"
+#define UNI_PROPERTY_NAME_MOTION_FUSION_ENABLED "bp.imu.fusion"
 #define UNI_PROPERTY_NAME_MOUSE_SCALE "bp.mouse.scale"
+#define UNI_PROPERTY_NAME_PEDAL_ANTI_DEADZONE "bp.pedal.adz"
+#define UNI_PROPERTY_NAME_PEDAL_CURVE "bp.pedal.curve"
+#define UNI_PROPERTY_NAME_PEDAL_DEADZONE "bp.pedal.dz"
+#define UNI_PROPERTY_NAME_PEDAL_EXPO "bp.pedal.expo"
+#define UNI_PROPERTY_NAME_SCAN_ADAPTIVE "bp.scan.adapt"
+#define UNI_PROPERTY_NAME_SCAN_BURST "bp.scan.burst"
+#define UNI_PROPERTY_NAME_SCAN_MIN_DUTY "bp.scan.duty"
+#define UNI_PROPERTY_NAME_STICK_ANTI_DEADZONE "bp.stick.adz"
+#define UNI_PROPERTY_NAME_STICK_AXIAL "bp.stick.axial"
+#define UNI_PROPERTY_NAME_STICK_CURVE "bp.stick.curve"
+#define UNI_PROPERTY_NAME_STICK_DEADZONE "bp.stick.dz"
+#define UNI_PROPERTY_NAME_STICK_EXPO "bp.stick.expo"
 #define UNI_PROPERTY_NAME_VERSION "bp.version"
 #define UNI_PROPERTY_NAME_VIRTUAL_DEVICE_ENABLED "bp.virt_dev_en"
 
@@ -27,11 +46,30 @@ typedef enum {
     UNI_PROPERTY_IDX_ALLOWLIST_ENABLED,
     UNI_PROPERTY_IDX_ALLOWLIST_LIST,
     UNI_PROPERTY_IDX_BLE_ENABLED,
+    UNI_PROPERTY_IDX_BREDR_FLUSH_TIMEOUT,
+    UNI_PROPERTY_IDX_BREDR_QOS_ENABLED,
+    UNI_PROPERTY_IDX_BREDR_SNIFF_IDLE,
     UNI_PROPERTY_IDX_GAP_INQ_LEN,
     UNI_PROPERTY_IDX_GAP_LEVEL,
     UNI_PROPERTY_IDX_GAP_MAX_PERIODIC_LEN,
     UNI_PROPERTY_IDX_GAP_MIN_PERIODIC_LEN,
+    UNI_PROPERTY_IDX_LINK_QUALITY_MIN,
+    UNI_PROPERTY_IDX_LINK_QUALITY_PERIOD,
+    UNI_PROPERTY_IDX_LINK_QUALITY_RSSI_MIN,
+    UNI_PROPERTY_IDX_MOTION_FUSION_ENABLED,
     UNI_PROPERTY_IDX_MOUSE_SCALE,
+    UNI_PROPERTY_IDX_PEDAL_ANTI_DEADZONE,
+    UNI_PROPERTY_IDX_PEDAL_CURVE,
+    UNI_PROPERTY_IDX_PEDAL_DEADZONE,
+    UNI_PROPERTY_IDX_PEDAL_EXPO,
+    UNI_PROPERTY_IDX_SCAN_ADAPTIVE,
+    UNI_PROPERTY_IDX_SCAN_BURST,
+    UNI_PROPERTY_IDX_SCAN_MIN_DUTY,
+    UNI_PROPERTY_IDX_STICK_ANTI_DEADZONE,
+    UNI_PROPERTY_IDX_STICK_AXIAL,
+    UNI_PROPERTY_IDX_STICK_CURVE,
+    UNI_PROPERTY_IDX_STICK_DEADZONE,
+    UNI_PROPERTY_IDX_STICK_EXPO,
     UNI_PROPERTY_IDX_VERSION,
     UNI_PROPERTY_IDX_VIRTUAL_DEVICE_ENABLED,
     UNI_PROPERTY_IDX_LAST,
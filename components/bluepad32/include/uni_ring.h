@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#ifndef UNI_RING_H
+#define UNI_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Generic ring of fixed-size elements. Used by the typed rings, like uni_motion_ring_t, which
+// own the elements array and call these functions with its element size and capacity.
+// The capacity must be a power of two, and not bigger than UINT8_MAX.
+// Single producer, single consumer. Not thread safe.
+// When full, the oldest element gets overwritten.
+typedef struct {
+    uint8_t head;     // Where the next element goes
+    uint8_t count;    // Number of elements available
+    uint32_t pushed;  // Total elements pushed. Used by the readers that don't remove elements
+} uni_ring_t;
+
+void uni_ring_reset(uni_ring_t* ring);
+void uni_ring_push(uni_ring_t* ring, void* elements, size_t element_size, uint8_t capacity, const void* element);
+// Removes up to "max" elements, oldest first. Returns the number of elements copied to "out".
+int uni_ring_read(uni_ring_t* ring, const void* elements, size_t element_size, uint8_t capacity, void* out, int max);
+// Like uni_ring_read(), but without removing them. Copies up to "max" elements pushed after "cursor",
+// and advances "cursor". Elements that are no longer available are skipped.
+int uni_ring_peek(const uni_ring_t* ring,
+                  uint32_t* cursor,
+                  const void* elements,
+                  size_t element_size,
+                  uint8_t capacity,
+                  void* out,
+                  int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // UNI_RING_H
@@ -11,6 +11,12 @@
 // Little-endian CRC32.
 // ESP32 has its own crc32_le as well, but they don't return the same values (?).
 // It is important to use ours with the "uni_" prefix.
+// It is incremental: start with crc = 0xffffffff, feed the returned value to the next call, and invert the
+// final value.
 uint32_t uni_crc32_le(uint32_t crc, const uint8_t* data, size_t len);
 
+// Running CRC32 after the 0xa2 byte, the HID transaction header (DATA | OUTPUT) that prefixes DualShock4
+// and DualSense output reports. Use it as the "crc" argument to skip the header.
+#define UNI_CRC32_LE_SEED_HID_OUTPUT 0x1525d2b6
+
 #endif  // UNI_UTILS_H
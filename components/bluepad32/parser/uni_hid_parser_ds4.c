@@ -14,6 +14,8 @@
 #include <assert.h>
 
 #include "bt/uni_bt_defines.h"
+#include "controller/uni_motion.h"
+#include "controller/uni_touch.h"
 #include "hid_usage.h"
 #include "uni_config.h"
 #include "uni_hid_device.h"
@@ -70,11 +72,9 @@ typedef struct {
     struct ds4_calibration_data gyro_calib_data[3];
     struct ds4_calibration_data accel_calib_data[3];
 
-    // Prev Touchpad values, to convert them from absolute
-    // coordinates into relative ones.
-    int x_prev;
-    int y_prev;
-    bool prev_touch_active;
+    // Converts the touchpad absolute coordinates into relative ones.
+    // Used by the virtual mouse.
+    uni_touch_mouse_t touch_mouse;
 
     // Prev LED color and rumble values.
     uint8_t prev_color_red;
@@ -215,7 +215,8 @@ static void ds4_play_dual_rumble_now(uni_hid_device_t* d,
                                      uint16_t duration_ms,
                                      uint8_t weak_magnitude,
                                      uint8_t strong_magnitude);
-static void ds4_parse_mouse(uni_hid_device_t* d, const ds4_input_report_11_t* r);
+static void ds4_parse_touch(uni_hid_device_t* d, const ds4_input_report_11_t* r);
+static void ds4_parse_mouse(uni_hid_device_t* d, uni_hid_device_t* parent, const ds4_input_report_11_t* r);
 
 void uni_hid_parser_ds4_setup(struct uni_hid_device_s* d) {
     ds4_instance_t* ins = get_ds4_instance(d);
@@ -231,6 +232,7 @@ void uni_hid_parser_ds4_setup(struct uni_hid_device_s* d) {
         ins->accel_calib_data[i].sens_numer = DS4_ACC_RANGE;
         ins->accel_calib_data[i].sens_denom = INT16_MAX;
     }
+    d->motion_fusion.gyro_res_per_dps = DS4_GYRO_RES_PER_DEG_S;
 
     // Send in order:
     // - enable lightbar: enables light and enables report 0x11 on most devices
@@ -489,13 +491,17 @@ static void ds4_parse_input_report_11(uni_hid_device_t* d, const ds4_input_repor
             mult_frac(ins->accel_calib_data[i].sens_numer, raw_data, ins->accel_calib_data[i].sens_denom);
         ctl->gamepad.accel[i] = calib_data;
     }
+    uni_motion_ring_push_gamepad(&d->motion, &ctl->gamepad, btstack_run_loop_get_time_ms());
 
     // Value goes from 0 to 10. Make it from 0 to 250.
     // The +1 is to avoid having a value of 0, which means "battery unavailable".
     ctl->battery = (r->status[0] & DS4_STATUS_BATTERY_CAPACITY) * 25 + 1;
 
+    ds4_parse_touch(d, r);
+
+    // The virtual mouse is just another consumer of the touch events.
     if (d->child) {
-        ds4_parse_mouse(d->child, r);
+        ds4_parse_mouse(d->child, d, r);
     }
 }
 
@@ -592,7 +598,8 @@ static void ds4_send_output_report(uni_hid_device_t* d, ds4_output_report_t* out
     out->transaction_type = (HID_MESSAGE_TYPE_DATA << 4) | HID_REPORT_TYPE_OUTPUT;
     out->report_id = 0x11;  // taken from HID descriptor
     out->unk0[0] = 0xc4;    // HID alone + poll interval
-    out->crc32 = ~uni_crc32_le(0xffffffff, (uint8_t*)out, sizeof(*out) - 4);
+    // transaction_type (0xa2) is already part of the seed.
+    out->crc32 = ~uni_crc32_le(UNI_CRC32_LE_SEED_HID_OUTPUT, (uint8_t*)out + 1, sizeof(*out) - 1 - 4);
 
     uni_hid_device_send_intr_report(d, (uint8_t*)out, sizeof(*out));
 }
@@ -714,30 +721,34 @@ static void ds4_send_enable_lightbar_report(uni_hid_device_t* d) {
     ds4_send_output_report(d, &out);
 }
 
-static void ds4_parse_mouse(uni_hid_device_t* d, const ds4_input_report_11_t* r) {
+static void ds4_parse_touch(uni_hid_device_t* d, const ds4_input_report_11_t* r) {
+    uint32_t now = btstack_run_loop_get_time_ms();
+    int frames = btstack_min(r->num_touch_reports, ARRAY_SIZE(r->touches));
+
+    // All the buffered frames, oldest first.
+    for (int i = 0; i < frames; i++) {
+        const ds4_touch_report_t* t = &r->touches[i];
+        for (int j = 0; j < UNI_TOUCH_MAX_POINTS; j++) {
+            const ds4_touch_point_t* point = &t->points[j];
+            uni_touch_ring_push_point(&d->touch, j, t->timestamp, point->contact & 0x7f, !(point->contact & BIT(7)),
+                                      (point->x_hi << 8) + point->x_lo, (point->y_hi << 4) + point->y_lo, now);
+        }
+    }
+}
+
+static void ds4_parse_mouse(uni_hid_device_t* d, uni_hid_device_t* parent, const ds4_input_report_11_t* r) {
     ds4_instance_t* ins = get_ds4_instance(d);
 
     // We can safely assume that device is connected and report is valid; otherwise
     // this function should have not been called.
 
-    if (r->num_touch_reports < 1) {
-        ins->prev_touch_active = false;
+    if (r->num_touch_reports < 1)
         return;
-    }
 
     uni_controller_t* ctl = &d->controller;
-    const ds4_touch_point_t* point = &r->touches[0].points[0];
 
-    int x = (point->x_hi << 8) + point->x_lo;
-    int y = (point->y_hi << 4) + point->y_lo;
-
-    if (ins->prev_touch_active) {
-        ctl->mouse.delta_x = x - ins->x_prev;
-        ctl->mouse.delta_y = y - ins->y_prev;
-    } else {
-        ctl->mouse.delta_x = 0;
-        ctl->mouse.delta_y = 0;
-    }
+    uni_touch_mouse_update(&ins->touch_mouse, &parent->touch, &ctl->mouse.delta_x, &ctl->mouse.delta_y);
+    int x = ins->touch_mouse.x;
 
     // "Click" on Touchpad
     if (r->buttons[2] & 0x02) {
@@ -750,12 +761,5 @@ static void ds4_parse_mouse(uni_hid_device_t* d, const ds4_input_report_11_t* r)
         // TODO: Support middle button.
     }
 
-    // Previous delta only if we are touching the touchpad.
-    ins->prev_touch_active = !(point->contact & BIT(7));
-
-    // Update prev regardless of whether it is valid.
-    ins->x_prev = x;
-    ins->y_prev = y;
-
     uni_hid_device_process_controller(d);
 }
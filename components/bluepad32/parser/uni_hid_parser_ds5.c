@@ -13,6 +13,8 @@
 #include <assert.h>
 
 #include "bt/uni_bt_defines.h"
+#include "controller/uni_motion.h"
+#include "controller/uni_touch.h"
 #include "uni_config.h"
 #include "uni_hid_device.h"
 #include "uni_log.h"
@@ -110,12 +112,9 @@ typedef struct {
     struct ds5_calibration_data gyro_calib_data[3];
     struct ds5_calibration_data accel_calib_data[3];
 
-    // Prev Touchpad values, to convert them from absolute
-    // coordinates into relative ones.
-    int x_prev;
-    int y_prev;
-    bool prev_touch_active;
-
+    // Converts the touchpad absolute coordinates into relative ones.
+    // Used by the virtual mouse.
+    uni_touch_mouse_t touch_mouse;
 } ds5_instance_t;
 _Static_assert(sizeof(ds5_instance_t) < HID_DEVICE_MAX_PARSER_DATA, "DS5 instance too big");
 
@@ -158,7 +157,7 @@ typedef struct __attribute((packed)) {
     uint32_t crc32;
 } ds5_output_report_t;
 
-/* Touchpad. Not used, added for completeness. */
+/* Touchpad */
 typedef struct __attribute((packed)) {
     uint8_t contact;
     uint8_t x_lo;
@@ -240,7 +239,8 @@ static void ds5_play_dual_rumble_now(uni_hid_device_t* d,
                                      uint16_t duration_ms,
                                      uint8_t weak_magnitude,
                                      uint8_t strong_magnitude);
-static void ds5_parse_mouse(uni_hid_device_t* d, const uint8_t* report, uint16_t len);
+static void ds5_parse_touch(uni_hid_device_t* d, const ds5_input_report_t* r);
+static void ds5_parse_mouse(uni_hid_device_t* d, uni_hid_device_t* parent, const uint8_t* report, uint16_t len);
 
 ds5_adaptive_trigger_effect_t ds5_new_adaptive_trigger_effect_off(void) {
     ds5_adaptive_trigger_effect_t out;
@@ -417,6 +417,7 @@ void uni_hid_parser_ds5_setup(uni_hid_device_t* d) {
         ins->accel_calib_data[i].sens_numer = DS5_ACC_RANGE;
         ins->accel_calib_data[i].sens_denom = INT16_MAX;
     }
+    d->motion_fusion.gyro_res_per_dps = DS5_GYRO_RES_PER_DEG_S;
 
     ds5_request_pairing_info_report(d);
 }
@@ -635,13 +636,17 @@ void uni_hid_parser_ds5_parse_input_report(uni_hid_device_t* d, const uint8_t* r
             mult_frac(ins->accel_calib_data[i].sens_numer, raw_data, ins->accel_calib_data[i].sens_denom);
         ctl->gamepad.accel[i] = calib_data;
     }
+    uni_motion_ring_push_gamepad(&d->motion, &ctl->gamepad, btstack_run_loop_get_time_ms());
 
     // Value goes from 0 to 10. Make it from 0 to 250.
     // The +1 is to avoid having a value of 0, which means "battery unavailable".
     ctl->battery = (r->status & DS5_STATUS_BATTERY_CAPACITY) * 25 + 1;
 
+    ds5_parse_touch(d, r);
+
+    // The virtual mouse is just another consumer of the touch events.
     if (d->child) {
-        ds5_parse_mouse(d->child, report, len);
+        ds5_parse_mouse(d->child, d, report, len);
     }
 }
 
@@ -747,7 +752,8 @@ static void ds5_send_output_report(uni_hid_device_t* d, ds5_output_report_t* out
     if (++ins->output_seq == 15)
         ins->output_seq = 0;
 
-    out->crc32 = ~uni_crc32_le(0xffffffff, (uint8_t*)out, sizeof(*out) - 4);
+    // transaction_type (0xa2) is already part of the seed.
+    out->crc32 = ~uni_crc32_le(UNI_CRC32_LE_SEED_HID_OUTPUT, (uint8_t*)out + 1, sizeof(*out) - 1 - 4);
 
     uni_hid_device_send_intr_report(d, (uint8_t*)out, sizeof(*out));
 }
@@ -891,7 +897,18 @@ static void ds5_send_enable_lightbar_report(uni_hid_device_t* d) {
     }
 }
 
-static void ds5_parse_mouse(uni_hid_device_t* d, const uint8_t* report, uint16_t len) {
+static void ds5_parse_touch(uni_hid_device_t* d, const ds5_input_report_t* r) {
+    uint32_t now = btstack_run_loop_get_time_ms();
+
+    // Only one frame per report. The report sequence number is used as frame counter.
+    for (int i = 0; i < UNI_TOUCH_MAX_POINTS; i++) {
+        const ds5_touch_point_t* point = &r->points[i];
+        uni_touch_ring_push_point(&d->touch, i, r->seq_number, point->contact & 0x7f, !(point->contact & BIT(7)),
+                                  (point->x_hi << 8) + point->x_lo, (point->y_hi << 4) + point->y_lo, now);
+    }
+}
+
+static void ds5_parse_mouse(uni_hid_device_t* d, uni_hid_device_t* parent, const uint8_t* report, uint16_t len) {
     ARG_UNUSED(len);
 
     ds5_instance_t* ins = get_ds5_instance(d);
@@ -902,16 +919,8 @@ static void ds5_parse_mouse(uni_hid_device_t* d, const uint8_t* report, uint16_t
     uni_controller_t* ctl = &d->controller;
     const ds5_input_report_t* r = (ds5_input_report_t*)&report[2];
 
-    int x = (r->points[0].x_hi << 8) + r->points[0].x_lo;
-    int y = (r->points[0].y_hi << 4) + r->points[0].y_lo;
-
-    if (ins->prev_touch_active) {
-        ctl->mouse.delta_x = x - ins->x_prev;
-        ctl->mouse.delta_y = y - ins->y_prev;
-    } else {
-        ctl->mouse.delta_x = 0;
-        ctl->mouse.delta_y = 0;
-    }
+    uni_touch_mouse_update(&ins->touch_mouse, &parent->touch, &ctl->mouse.delta_x, &ctl->mouse.delta_y);
+    int x = ins->touch_mouse.x;
 
     // "Click" on Touchpad
     if (r->buttons[2] & 0x02) {
@@ -924,12 +933,5 @@ static void ds5_parse_mouse(uni_hid_device_t* d, const uint8_t* report, uint16_t
         // TODO: Support middle button.
     }
 
-    // Previous delta only if we are touching the touchpad.
-    ins->prev_touch_active = !(r->points[0].contact & BIT(7));
-
-    // Update prev regardless of whether it is valid.
-    ins->x_prev = x;
-    ins->y_prev = y;
-
     uni_hid_device_process_controller(d);
 }
@@ -36,13 +36,25 @@ typedef struct {
 
 static keyboard_instance_t* get_keyboard_instance(uni_hid_device_t* d);
 
+static void add_pressed_key(uni_hid_device_t* d, uint8_t key) {
+    keyboard_instance_t* ins = get_keyboard_instance(d);
+
+    // 0-3 are error codes, not keys. They are still stored in "pressed_keys", since
+    // uni_keyboard_ring_update() needs ErrorRollOver to keep the previous state.
+    if (key > HID_USAGE_KB_ERROR_UNDEFINED)
+        uni_keyboard_set_key_pressed(&d->controller.keyboard, key);
+
+    // Only the first ones fit. N-key rollover keyboards might report more, but they are in the bitmap.
+    if (ins->pressed_key_index < UNI_KEYBOARD_PRESSED_KEYS_MAX)
+        d->controller.keyboard.pressed_keys[ins->pressed_key_index++] = key;
+}
+
 static void jx_05_parse_usage(uni_hid_device_t* d,
                               hid_globals_t* globals,
                               uint16_t usage_page,
                               uint16_t usage,
                               int32_t value) {
     keyboard_instance_t* ins = get_keyboard_instance(d);
-    int idx = ins->pressed_key_index;
 
     switch (usage_page) {
         case HID_USAGE_PAGE_GENERIC_DESKTOP:
@@ -88,9 +100,9 @@ static void jx_05_parse_usage(uni_hid_device_t* d,
 
                         // Button repeats the first and last (second) report coordinates
                         if (x == -260 && y == 145)
-                            d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_SPACEBAR;
+                            add_pressed_key(d, HID_USAGE_KB_SPACEBAR);
                         else
-                            d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_DOWN_ARROW;
+                            add_pressed_key(d, HID_USAGE_KB_DOWN_ARROW);
                     }
                     if (ins->jx_05.ready_to_process) {
                         // This is the last usage in the JX05 report.
@@ -102,17 +114,16 @@ static void jx_05_parse_usage(uni_hid_device_t* d,
                         //  x=-48,  y=251  / ... / x=-467, y=251, and tip_switch=false, "scroll right"
                         //  x=-260, y=145  / x=-260, y=145, and tip_switch=false, "button"
                         if (x == -260 && y == -222)
-                            d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_UP_ARROW;
+                            add_pressed_key(d, HID_USAGE_KB_UP_ARROW);
                         else if (x == -260 && y == 145)
                             // Could either be "down" or "press". The next packet decides
                             ins->jx_05.is_down_or_button = true;
                         else if (x == -387 && y == 251)
-                            d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_LEFT_ARROW;
+                            add_pressed_key(d, HID_USAGE_KB_LEFT_ARROW);
                         else if (x == -48 && y == 251)
-                            d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_RIGHT_ARROW;
+                            add_pressed_key(d, HID_USAGE_KB_RIGHT_ARROW);
                         else
                             break;
-                        ins->pressed_key_index = idx;
                         ins->jx_05.ready_to_process = false;
                     }
                     break;
@@ -168,25 +179,19 @@ void uni_hid_parser_keyboard_parse_usage(uni_hid_device_t* d,
 
     logd("usage page=%#x, usage=%#x, value=%d\n", usage_page, usage, value);
 
-    int idx = ins->pressed_key_index;
     switch (usage_page) {
         case HID_USAGE_PAGE_KEYBOARD_KEYPAD:
             if (value) {
                 if (usage < HID_USAGE_KB_LEFT_CONTROL) {
-                    if (idx >= UNI_KEYBOARD_PRESSED_KEYS_MAX) {
-                        loge("Keyboard: Reached max keyboard keys, skipping page: %d, usage: %d, value: %d\n",
-                             usage_page, usage, value);
-                        return;
-                    }
                     // "usage" represents the pressed key.
                     // See: USB HID Usage Tables, Section 10 (page 53).
-                    d->controller.keyboard.pressed_keys[idx++] = usage;
-                    ins->pressed_key_index = idx;
+                    add_pressed_key(d, usage);
                 } else if (usage <= HID_USAGE_KB_RIGHT_GUI) {
                     // Value is between 0xe0 and 0xe7: the modifiers
                     // Modifier is between 0 - 7
                     uint8_t modifier = usage - HID_USAGE_KB_LEFT_CONTROL;
                     d->controller.keyboard.modifiers |= BIT(modifier);
+                    uni_keyboard_set_key_pressed(&d->controller.keyboard, usage);
                 } else {
                     // Usage >= 0xe8, unsupported value.
                     logi("Keyboard: unsupported page:%d, usage:%d, value:%d\n", usage_page, usage, value);
@@ -206,41 +211,32 @@ void uni_hid_parser_keyboard_parse_usage(uni_hid_device_t* d,
                     break;
                 // Used by "TikTog Ring Controller"
                 case HID_USAGE_POWER:
-                    d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_POWER;
-                    ins->pressed_key_index = idx;
+                    add_pressed_key(d, HID_USAGE_KB_POWER);
                     break;
                 case HID_USAGE_VOLUME_UP:
-                    d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_VOLUME_UP;
-                    ins->pressed_key_index = idx;
+                    add_pressed_key(d, HID_USAGE_KB_VOLUME_UP);
                     break;
                 case HID_USAGE_VOLUME_DOWN:
-                    d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_VOLUME_DOWN;
-                    ins->pressed_key_index = idx;
+                    add_pressed_key(d, HID_USAGE_KB_VOLUME_DOWN);
                     break;
                 case HID_USAGE_AC_HOME:
-                    d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_HOME;
-                    ins->pressed_key_index = idx;
+                    add_pressed_key(d, HID_USAGE_KB_HOME);
                     break;
                 case HID_USAGE_AC_SCROLL_UP:
-                    d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_PAGE_UP;
-                    ins->pressed_key_index = idx;
+                    add_pressed_key(d, HID_USAGE_KB_PAGE_UP);
                     break;
                 case HID_USAGE_AC_SCROLL_DOWN:
-                    d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_PAGE_DOWN;
-                    ins->pressed_key_index = idx;
+                    add_pressed_key(d, HID_USAGE_KB_PAGE_DOWN);
                     break;
                 // Used by "5-button keyboard"
                 case HID_USAGE_SCAN_NEXT_TRACK:
-                    d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_RIGHT_ARROW;
-                    ins->pressed_key_index = idx;
+                    add_pressed_key(d, HID_USAGE_KB_RIGHT_ARROW);
                     break;
                 case HID_USAGE_SCAN_PREVIOUS_TRACK:
-                    d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_LEFT_ARROW;
-                    ins->pressed_key_index = idx;
+                    add_pressed_key(d, HID_USAGE_KB_LEFT_ARROW);
                     break;
                 case HID_USAGE_PLAY_PAUSE:
-                    d->controller.keyboard.pressed_keys[idx++] = HID_USAGE_KB_PAUSE;
-                    ins->pressed_key_index = idx;
+                    add_pressed_key(d, HID_USAGE_KB_PAUSE);
                     break;
                 default:
                     logi("Keyboard: Unsupported page: 0x%04x, usage: 0x%04x, value=0x%x\n", usage_page, usage, value);
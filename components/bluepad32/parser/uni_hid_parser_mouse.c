@@ -4,7 +4,6 @@
 
 #include "parser/uni_hid_parser_mouse.h"
 
-#include <math.h>
 #include <time.h>
 
 #include "controller/uni_controller.h"
@@ -12,10 +11,18 @@
 #include "uni_common.h"
 #include "uni_hid_device.h"
 #include "uni_log.h"
+#include "uni_property.h"
 
 #define TANK_MOUSE_VID 0x248a
 #define TANK_MOUSE_PID 0x8266
 
+// Scale and motion remainders are in Q16.16 fixed point.
+#define MOUSE_SCALE_ONE (1 << 16)
+// Resolution Multiplier feature report: max data length, and max feature reports to track while looking for it.
+#define MOUSE_MULTIPLIER_REPORT_MAX_LEN 16
+#define MOUSE_MAX_FEATURE_REPORTS 8
+#define MOUSE_MAX_USAGES 8
+
 typedef struct __attribute((packed)) tank_mouse_input_report {
     uint8_t report_id;  // Should be 0x03
     uint8_t buttons;
@@ -25,7 +32,20 @@ typedef struct __attribute((packed)) tank_mouse_input_report {
 } tank_mouse_input_report_t;
 
 typedef struct {
-    float scale;
+    int32_t scale_x;  // Q16.16
+    int32_t scale_y;
+    // Fraction of a count that was not reported yet. Q16.16
+    int32_t remainder_x;
+    int32_t remainder_y;
+    // Wheel units that were not reported yet as a detent.
+    int32_t wheel_remainder;
+    int32_t pan_remainder;
+    // Wheel units per detent. 1 until the mouse acknowledges the Resolution Multiplier report.
+    uint8_t wheel_multiplier;
+    // Multiplier sent to the mouse, waiting for the acknowledgment. 0 if none.
+    uint8_t pending_wheel_multiplier;
+    // Header + report ID + data. BLE sends it asynchronously, so it must outlive the setup.
+    uint8_t multiplier_report[MOUSE_MULTIPLIER_REPORT_MAX_LEN + 2];
 } mouse_instance_t;
 _Static_assert(sizeof(mouse_instance_t) < HID_DEVICE_MAX_PARSER_DATA, "Mouse intance too big");
 
@@ -37,6 +57,13 @@ struct mouse_resolution {
     float scale;
 };
 
+// Applied to all mice, on top of the per-mouse scale. Q16.16. Loaded from uni_property when a mouse connects.
+static int32_t global_scale = MOUSE_SCALE_ONE;
+
+static void load_global_scale(void) {
+    global_scale = (int32_t)(uni_hid_parser_mouse_get_global_scale() * MOUSE_SCALE_ONE);
+}
+
 static mouse_instance_t* get_mouse_instance(uni_hid_device_t* d) {
     return (mouse_instance_t*)&d->parser_data[0];
 }
@@ -85,33 +112,254 @@ static const struct mouse_resolution resolutions[] = {
     // No need to add entries where scale is 1
 };
 
-static int32_t process_mouse_delta(uni_hid_device_t* d, int32_t value) {
+static int32_t process_mouse_delta(int32_t value, int32_t scale, int32_t* remainder) {
+    int64_t acc, ret;
+
     if (value == 0)
         return 0;
 
-    mouse_instance_t* ins = get_mouse_instance(d);
-    float ret = value;
+    scale = (int32_t)(((int64_t)scale * global_scale) / MOUSE_SCALE_ONE);
 
-    ret *= ins->scale;
+    // Changing direction discards the pending fraction. Otherwise the first count in the
+    // new direction might get "eaten" by the remainder.
+    if ((value < 0) != (*remainder < 0))
+        *remainder = 0;
+
+    // Keep the fraction that was not reported, so that slow movements are not lost and
+    // don't get rounded up to one count per report.
+    acc = (int64_t)value * scale + *remainder;
+    ret = acc / MOUSE_SCALE_ONE;
 
     // Quadrature-driver expect values between -127 and 127.
-    if (ret < -127)
-        ret = -127;
-    if (ret > 127)
-        ret = 127;
-
-    int ret_i = roundf(ret);
-    // Don't return 0 when there is any kind of movement... feels "janky".
-    if (ret_i == 0)
-        ret_i = (value < 0) ? -1 : 1;
-    return ret_i;
+    if (ret < -127 || ret > 127) {
+        *remainder = 0;
+        return (ret < 0) ? -127 : 127;
+    }
+    *remainder = (int32_t)(acc - ret * MOUSE_SCALE_ONE);
+    return (int32_t)ret;
+}
+
+static void process_wheel(mouse_instance_t* ins, int32_t value, int32_t* remainder, int8_t* detents, int16_t* hires) {
+    int32_t hr, out;
+
+    if (value == 0)
+        return;
+
+    hr = value * UNI_MOUSE_WHEEL_HIRES_UNITS / ins->wheel_multiplier;
+    *hires = (hr < INT16_MIN) ? INT16_MIN : (hr > INT16_MAX) ? INT16_MAX : hr;
+
+    if ((value < 0) != (*remainder < 0))
+        *remainder = 0;
+    *remainder += value;
+    out = *remainder / ins->wheel_multiplier;
+    *remainder -= out * ins->wheel_multiplier;
+    *detents = (out < INT8_MIN) ? INT8_MIN : (out > INT8_MAX) ? INT8_MAX : out;
+}
+
+static void set_report_bits(uint8_t* data, int len, int bit_offset, int bit_size, uint32_t value) {
+    for (int i = 0; i < bit_size && i < 32; i++) {
+        int bit = bit_offset + i;
+        if (bit / 8 >= len)
+            return;
+        if (value & BIT(i))
+            data[bit / 8] |= BIT(bit % 8);
+    }
+}
+
+// Usage page in the upper 16 bits. 4-byte usages already include it.
+static uint32_t get_extended_usage(const hid_descriptor_item_t* item, uint16_t usage_page) {
+    return (item->data_size == 4) ? (uint32_t)item->item_value : ((uint32_t)usage_page << 16) | item->item_value;
+}
+
+// Looks for the Resolution Multiplier in the HID descriptor, and fills "data" with the feature report
+// that sets it to its maximum. Only the multipliers that are in the first report that has one are set.
+// Returns the report ID, or -1 if there is no Resolution Multiplier.
+static int build_multiplier_report(uni_hid_device_t* d, uint8_t* data, int max_len, uint8_t* multiplier) {
+    hid_descriptor_item_t item;
+    const uint8_t* desc = d->hid_descriptor;
+    int remaining = d->hid_descriptor_len;
+
+    // Global items. Push / Pop are not supported.
+    uint16_t usage_page = 0;
+    uint8_t report_id = 0;
+    uint32_t report_size = 0;
+    uint32_t report_count = 0;
+    int32_t logical_max = 0;
+    int32_t physical_min = 0;
+    int32_t physical_max = 0;
+    // Local items. Reset after each Main item.
+    uint32_t usages[MOUSE_MAX_USAGES];
+    int num_usages = 0;
+    uint32_t usage_min = 0;
+    uint32_t usage_max = 0;
+
+    // Bit offset of the next field, per feature report ID.
+    struct {
+        uint8_t id;
+        uint16_t bit_offset;
+    } reports[MOUSE_MAX_FEATURE_REPORTS];
+    int num_reports = 0;
+    int target_id = -1;
+    int len = 0;
+
+    while (remaining > 0 && btstack_hid_parse_descriptor_item(&item, desc, remaining)) {
+        desc += item.item_size;
+        remaining -= item.item_size;
+
+        switch (item.item_type) {
+            case Global:
+                switch (item.item_tag) {
+                    case UsagePage:
+                        usage_page = item.item_value;
+                        break;
+                    case LogicalMaximum:
+                        logical_max = item.item_value;
+                        break;
+                    case PhysicalMinimum:
+                        physical_min = item.item_value;
+                        break;
+                    case PhysicalMaximum:
+                        physical_max = item.item_value;
+                        break;
+                    case ReportSize:
+                        report_size = item.item_value;
+                        break;
+                    case ReportID:
+                        report_id = item.item_value;
+                        break;
+                    case ReportCount:
+                        report_count = item.item_value;
+                        break;
+                    default:
+                        break;
+                }
+                break;
+
+            case Local:
+                if (item.item_tag == Usage && num_usages < MOUSE_MAX_USAGES)
+                    usages[num_usages++] = get_extended_usage(&item, usage_page);
+                else if (item.item_tag == UsageMinimum)
+                    usage_min = get_extended_usage(&item, usage_page);
+                else if (item.item_tag == UsageMaximum)
+                    usage_max = get_extended_usage(&item, usage_page);
+                break;
+
+            case Main:
+                if (item.item_tag == Feature) {
+                    int r;
+                    for (r = 0; r < num_reports; r++) {
+                        if (reports[r].id == report_id)
+                            break;
+                    }
+                    if (r == MOUSE_MAX_FEATURE_REPORTS) {
+                        loge("Mouse: Too many feature reports\n");
+                        return target_id;
+                    }
+                    if (r == num_reports) {
+                        reports[r].id = report_id;
+                        reports[r].bit_offset = 0;
+                        num_reports++;
+                    }
+
+                    // Constant fields are padding.
+                    for (uint32_t i = 0; i < report_count && !(item.item_value & 1); i++) {
+                        uint32_t usage;
+                        if (num_usages > 0)
+                            usage = usages[(i < (uint32_t)num_usages) ? i : (uint32_t)num_usages - 1];
+                        else
+                            usage = (usage_min + i < usage_max) ? usage_min + i : usage_max;
+
+                        if (usage != ((HID_USAGE_PAGE_GENERIC_DESKTOP << 16) | HID_USAGE_RESOLUTION_MULTIPLIER))
+                            continue;
+                        if (target_id == -1) {
+                            len = btstack_hid_get_report_size_for_id(report_id, HID_REPORT_TYPE_FEATURE,
+                                                                     d->hid_descriptor_len, d->hid_descriptor);
+                            if (len <= 0 || len > max_len) {
+                                logi("Mouse: Resolution Multiplier report too big: %d\n", len);
+                                return -1;
+                            }
+                            target_id = report_id;
+                            memset(data, 0, len);
+                            // If "physical" is not defined, it is the same as "logical".
+                            int32_t m = (physical_max > physical_min) ? physical_max : logical_max;
+                            *multiplier = (m < 1) ? 1 : (m > UINT8_MAX) ? UINT8_MAX : m;
+                        }
+                        if (report_id == target_id)
+                            set_report_bits(data, len, reports[r].bit_offset + i * report_size, report_size,
+                                            logical_max);
+                    }
+                    reports[r].bit_offset += report_size * report_count;
+                }
+                num_usages = 0;
+                usage_min = 0;
+                usage_max = 0;
+                break;
+
+            default:
+                break;
+        }
+    }
+    return target_id;
+}
+
+static void set_resolution_multiplier(uni_hid_device_t* d) {
+    mouse_instance_t* ins = get_mouse_instance(d);
+    uint8_t* report = ins->multiplier_report;
+    uint8_t multiplier = 1;
+    int report_id;
+    int len;
+
+    ins->wheel_multiplier = 1;
+    ins->pending_wheel_multiplier = 0;
+
+    report_id = build_multiplier_report(d, &report[2], MOUSE_MULTIPLIER_REPORT_MAX_LEN, &multiplier);
+    if (report_id < 0)
+        return;
+    len = btstack_hid_get_report_size_for_id(report_id, HID_REPORT_TYPE_FEATURE, d->hid_descriptor_len,
+                                             d->hid_descriptor);
+
+    if (gap_get_connection_type(d->conn.handle) == GAP_CONNECTION_LE) {
+        uint8_t status =
+            hids_client_send_write_report(d->hids_cid, report_id, HID_REPORT_TYPE_FEATURE, &report[2], len);
+        if (status != ERROR_CODE_SUCCESS) {
+            logi("Mouse: Failed to set Resolution Multiplier, error=%#x\n", status);
+            return;
+        }
+    } else if (report_id == 0) {
+        report[1] = (HID_MESSAGE_TYPE_SET_REPORT << 4) | HID_REPORT_TYPE_FEATURE;
+        uni_hid_device_send_ctrl_report(d, &report[1], len + 1);
+    } else {
+        report[0] = (HID_MESSAGE_TYPE_SET_REPORT << 4) | HID_REPORT_TYPE_FEATURE;
+        report[1] = report_id;
+        uni_hid_device_send_ctrl_report(d, report, len + 2);
+    }
+
+    // Until the mouse accepts it, it keeps reporting one unit per detent.
+    ins->pending_wheel_multiplier = multiplier;
+    logi("Mouse: Resolution Multiplier %d requested, report ID=%#x\n", multiplier, report_id);
+}
+
+void uni_hid_parser_mouse_set_report_result(struct uni_hid_device_s* d, bool success) {
+    mouse_instance_t* ins = get_mouse_instance(d);
+
+    // The multiplier report is the only one that the mouse parser sends.
+    if (ins->pending_wheel_multiplier == 0)
+        return;
+
+    if (success) {
+        ins->wheel_multiplier = ins->pending_wheel_multiplier;
+        ins->wheel_remainder = 0;
+        ins->pan_remainder = 0;
+        logi("Mouse: Resolution Multiplier set to %d\n", ins->wheel_multiplier);
+    } else {
+        logi("Mouse: Resolution Multiplier rejected, using 1\n");
+    }
+    ins->pending_wheel_multiplier = 0;
 }
 
 void uni_hid_parser_mouse_setup(uni_hid_device_t* d) {
-    char buf[64];
     // At setup time, fetch the "scale" for the mouse.
     float scale = 1;
-    mouse_instance_t* ins = get_mouse_instance(d);
 
     for (unsigned int i = 0; i < ARRAY_SIZE(resolutions); i++) {
         if (resolutions[i].vid == d->vendor_id && resolutions[i].pid == d->product_id &&
@@ -121,14 +369,44 @@ void uni_hid_parser_mouse_setup(uni_hid_device_t* d) {
         }
     }
 
-    ins->scale = scale;
+    logi("mouse: vid=0x%04x, pid=0x%04x, name='%s'\n", d->vendor_id, d->product_id, d->name);
+    uni_hid_parser_mouse_set_scale(d, scale, scale);
+    // Might have been changed from the console.
+    load_global_scale();
+
+    // High-resolution scrolling. The wheel reports are converted back to detents.
+    set_resolution_multiplier(d);
+
+    uni_hid_device_set_ready_complete(d);
+}
+
+void uni_hid_parser_mouse_set_scale(struct uni_hid_device_s* d, float scale_x, float scale_y) {
+    char buf[64];
+    mouse_instance_t* ins = get_mouse_instance(d);
+
+    ins->scale_x = (int32_t)(scale_x * MOUSE_SCALE_ONE);
+    ins->scale_y = (int32_t)(scale_y * MOUSE_SCALE_ONE);
+    ins->remainder_x = 0;
+    ins->remainder_y = 0;
 
-    logi("mouse: vid=0x%04x, pid=0x%04x, name='%s' uses scale:", d->vendor_id, d->product_id, d->name);
     // ets_printf() doesn't support "%f"
-    sprintf(buf, "%f\n", ins->scale);
+    sprintf(buf, "mouse: scale x=%f, y=%f\n", scale_x, scale_y);
     logi(buf);
+}
 
-    uni_hid_device_set_ready_complete(d);
+void uni_hid_parser_mouse_set_global_scale(float scale) {
+    uni_property_value_t value;
+
+    value.f32 = scale;
+    uni_property_set(UNI_PROPERTY_IDX_MOUSE_SCALE, value);
+    global_scale = (int32_t)(scale * MOUSE_SCALE_ONE);
+}
+
+float uni_hid_parser_mouse_get_global_scale(void) {
+    uni_property_value_t value;
+
+    value = uni_property_get(UNI_PROPERTY_IDX_MOUSE_SCALE);
+    return value.f32;
 }
 
 void uni_hid_parser_mouse_parse_input_report(struct uni_hid_device_s* d, const uint8_t* report, uint16_t len) {
@@ -153,24 +431,26 @@ void uni_hid_parser_mouse_parse_usage(uni_hid_device_t* d,
 
     // TODO: should be a union of gamepad/mouse/keyboard
     uni_controller_t* ctl = &d->controller;
+    mouse_instance_t* ins = get_mouse_instance(d);
     switch (usage_page) {
         case HID_USAGE_PAGE_GENERIC_DESKTOP: {
             switch (usage) {
                 case HID_USAGE_AXIS_X:
                     // Mouse delta X
                     // Negative: left, positive: right.
-                    ctl->mouse.delta_x = process_mouse_delta(d, value);
+                    ctl->mouse.delta_x = process_mouse_delta(value, ins->scale_x, &ins->remainder_x);
                     // printf("min: %d, max: %d\n", globals->logical_minimum, globals->logical_maximum);
                     // printf("delta x old value: %d -> new value: %d\n", value, ctl->mouse.delta_x);
                     break;
                 case HID_USAGE_AXIS_Y:
                     // Mouse delta Y
                     // Negative: up, positive: down.
-                    ctl->mouse.delta_y = process_mouse_delta(d, value);
+                    ctl->mouse.delta_y = process_mouse_delta(value, ins->scale_y, &ins->remainder_y);
                     // printf("delta y old value: %d -> new value: %d\n", value, ctl->mouse.delta_y);
                     break;
                 case HID_USAGE_WHEEL:
-                    ctl->mouse.scroll_wheel = value;
+                    process_wheel(ins, value, &ins->wheel_remainder, &ctl->mouse.scroll_wheel,
+                                  &ctl->mouse.scroll_wheel_hires);
                     break;
                 default:
                     logi("Mouse: Unsupported page: 0x%04x, usage: 0x%04x, value=0x%x\n", usage_page, usage, value);
@@ -252,7 +532,8 @@ void uni_hid_parser_mouse_parse_usage(uni_hid_device_t* d,
                     break;
                 case HID_USAGE_AC_SEARCH:  // Logitech M-RCL124
                     break;
-                case HID_USAGE_AC_PAN:  // Logitech M535
+                case HID_USAGE_AC_PAN:  // Horizontal wheel. Logitech M535
+                    process_wheel(ins, value, &ins->pan_remainder, &ctl->mouse.pan, &ctl->mouse.pan_hires);
                     break;
                 default:
                     logi("Mouse: Unsupported page: 0x%04x, usage: 0x%04x, value=0x%x\n", usage_page, usage, value);
@@ -277,10 +558,11 @@ void uni_hid_parser_mouse_parse_usage(uni_hid_device_t* d,
 }
 
 void uni_hid_parser_mouse_device_dump(struct uni_hid_device_s* d) {
-    char buf[48];
+    char buf[64];
 
     mouse_instance_t* ins = get_mouse_instance(d);
     // ets_printf() doesn't support "%f"
-    sprintf(buf, "\tmouse: scale=%f\n", ins->scale);
+    sprintf(buf, "\tmouse: scale x=%f, y=%f, wheel multiplier=%d\n", (float)ins->scale_x / MOUSE_SCALE_ONE,
+            (float)ins->scale_y / MOUSE_SCALE_ONE, ins->wheel_multiplier);
     logi(buf);
 }
@@ -21,7 +21,9 @@
 #endif  // ENABLE_SPI_FLASH_DUMP
 
 #include "bt/uni_bt_conn.h"
+#include "bt/uni_bt_device_cache.h"
 #include "controller/uni_controller.h"
+#include "controller/uni_motion.h"
 #include "hid_usage.h"
 #include "uni_common.h"
 #include "uni_hid_device.h"
@@ -40,8 +42,11 @@ static const uint16_t SWITCH_ONLINE_SNES_CONTROLLER_PID = 0x2017;
 #define SWITCH_FACTORY_STICK_CAL_DATA_SIZE 9
 static const uint16_t SWITCH_FACTORY_STICK_CAL_DATA_ADDR_LEFT = 0x603d;
 static const uint16_t SWITCH_FACTORY_STICK_CAL_DATA_ADDR_RIGHT = 0x6046;
-#define SWITCH_USER_STICK_CAL_DATA_SIZE 2
+// Left magic (2) + left stick (9) + right magic (2) + right stick (9).
+#define SWITCH_USER_STICK_CAL_DATA_SIZE 22
 static const uint16_t SWITCH_USER_STICK_CAL_DATA_ADDR = 0x8010;
+// Present at the beginning of each stick calibration, if the user calibrated it.
+static const uint8_t SWITCH_USER_STICK_CAL_MAGIC[] = {0xb2, 0xa1};
 
 // Constants taken from Linux kernel / Nintendo Rev.Eng doc
 static const int16_t DEFAULT_ACCEL_OFFSET = 0;
@@ -49,8 +54,10 @@ static const int16_t DEFAULT_ACCEL_SCALE = 16384;
 static const int16_t DEFAULT_GYRO_OFFSET = 0;
 static const int16_t DEFAULT_GYRO_SCALE = 13371;
 #define SWITCH_IMU_PREC_RANGE_SCALE 1000
+#define SWITCH_IMU_GYRO_RES_PER_DPS 14247  // Once scaled by SWITCH_IMU_PREC_RANGE_SCALE
 
 #define SWITCH_FACTORY_IMU_CAL_DATA_SIZE 24
+#define SWITCH_IMU_SAMPLE_PERIOD_MS 5  // Each 0x30 report has 3 samples
 static const uint16_t SWITCH_FACTORY_IMU_CAL_DATA_ADDR = 0x6020;
 
 #define SWITCH_DUMP_ROM_DATA_SIZE 24  // Max size is 24
@@ -74,6 +81,25 @@ enum switch_state {
     STATE_READY,                           // Gamepad setup ready!
 };
 
+// What was read from the controller. Used to decide whether the calibration can be cached.
+enum {
+    SWITCH_READ_DEV_INFO = BIT(0),
+    SWITCH_READ_FACTORY_STICK_CALIBRATION = BIT(1),
+    SWITCH_READ_FACTORY_IMU_CALIBRATION = BIT(2),
+    SWITCH_READ_USER_STICK_CALIBRATION = BIT(3),
+    SWITCH_READ_ALL = SWITCH_READ_DEV_INFO | SWITCH_READ_FACTORY_STICK_CALIBRATION |
+                      SWITCH_READ_FACTORY_IMU_CALIBRATION | SWITCH_READ_USER_STICK_CALIBRATION,
+};
+
+// Which sticks use the user calibration instead of the factory one.
+enum {
+    SWITCH_USER_STICK_CAL_LEFT = BIT(0),
+    SWITCH_USER_STICK_CAL_RIGHT = BIT(1),
+};
+
+// Bump it when switch_cache_t changes.
+#define SWITCH_CACHE_VERSION 2
+
 enum switch_flags {
     SWITCH_MODE_NONE,    // Mode not set yet
     SWITCH_MODE_NORMAL,  // Gamepad using regular buttons
@@ -162,12 +188,33 @@ typedef struct switch_instance_s {
     int32_t imu_cal_accel_divisor[3];
     int32_t imu_cal_gyro_divisor[3];
 
+    // Calibration cache
+    bool cache_hit;          // Setup used the cached calibration. Validated in the background once ready
+    uint8_t read_mask;       // What was read from the controller, see SWITCH_READ_
+    uint8_t user_stick_cal;  // Sticks using the user calibration, see SWITCH_USER_STICK_CAL_
+
     // Debug only
     int debug_fd;         // File descriptor where dump is saved
     uint32_t debug_addr;  // Current dump address
 } switch_instance_t;
 _Static_assert(sizeof(switch_instance_t) < HID_DEVICE_MAX_PARSER_DATA, "Switch instance too big");
 
+// What gets stored in the device cache, to skip the calibration requests on reconnect.
+typedef struct {
+    uint8_t version;
+    uint8_t firmware_version_hi;
+    uint8_t firmware_version_lo;
+    uint8_t controller_type;
+    uint8_t user_stick_cal;
+    switch_cal_stick_t cal_x;
+    switch_cal_stick_t cal_y;
+    switch_cal_stick_t cal_rx;
+    switch_cal_stick_t cal_ry;
+    switch_cal_imu_t cal_accel;
+    switch_cal_imu_t cal_gyro;
+} switch_cache_t;
+_Static_assert(sizeof(switch_cache_t) <= UNI_BT_DEVICE_CACHE_MAX_LEN, "Switch cache too big");
+
 struct switch_subcmd_request {
     // Report related
     uint8_t transaction_type;  // type of transaction
@@ -325,6 +372,7 @@ static void process_reply_read_spi_dump(struct uni_hid_device_s* d, const uint8_
 static void process_reply_read_spi_factory_stick_calibration(struct uni_hid_device_s* d, const uint8_t* data, int len);
 static void process_reply_read_spi_user_stick_calibration(struct uni_hid_device_s* d, const uint8_t* data, int len);
 static void process_reply_read_spi_factory_imu_calibration(struct uni_hid_device_s* d, const uint8_t* data, int len);
+static void revalidate_user_stick_calibration(struct uni_hid_device_s* d, const uint8_t* data, int len);
 static void process_reply_req_dev_info(struct uni_hid_device_s* d, const struct switch_report_21_s* r, int len);
 static void process_reply_set_report_mode(struct uni_hid_device_s* d, const struct switch_report_21_s* r, int len);
 static void process_reply_spi_flash_read(struct uni_hid_device_s* d, const struct switch_report_21_s* r, int len);
@@ -340,6 +388,13 @@ static void switch_play_dual_rumble_now(uni_hid_device_t* d,
                                         uint8_t weak_magnitude,
                                         uint8_t strong_magnitude);
 static void switch_setup_timeout_callback(btstack_timer_source_t* ts);
+static void update_imu_divisors(switch_instance_t* ins);
+static void load_calibration_from_cache(uni_hid_device_t* d);
+static void store_calibration_in_cache(uni_hid_device_t* d);
+static void send_request_device_info(uni_hid_device_t* d);
+static void send_read_user_stick_calibration(uni_hid_device_t* d);
+static void update_mode(uni_hid_device_t* d, const struct switch_report_21_s* r);
+static uint8_t parse_user_stick_calibration(switch_instance_t* ins, const uint8_t* data);
 static void parse_stick_calibration(switch_cal_stick_t* x, switch_cal_stick_t* y, const uint8_t* data, bool is_left);
 
 void uni_hid_parser_switch_setup(struct uni_hid_device_s* d) {
@@ -363,11 +418,11 @@ void uni_hid_parser_switch_setup(struct uni_hid_device_s* d) {
         ins->cal_accel.scale[i] = DEFAULT_ACCEL_SCALE;
         ins->cal_gyro.offset[i] = DEFAULT_GYRO_OFFSET;
         ins->cal_gyro.scale[i] = DEFAULT_GYRO_SCALE;
-
-        // Divisors that must be updated after calibration data is updated.
-        ins->imu_cal_accel_divisor[i] = ins->cal_accel.scale[i] - ins->cal_accel.offset[i];
-        ins->imu_cal_gyro_divisor[i] = ins->cal_gyro.scale[i] - ins->cal_gyro.offset[i];
     }
+    update_imu_divisors(ins);
+    d->motion_fusion.gyro_res_per_dps = SWITCH_IMU_GYRO_RES_PER_DPS;
+
+    load_calibration_from_cache(d);
 
     // Dump SPI flash
 #if ENABLE_SPI_FLASH_DUMP
@@ -424,7 +479,11 @@ static void process_fsm(struct uni_hid_device_s* d) {
             btstack_run_loop_set_timer(&ins->setup_timer, SWITCH_SETUP_TIMEOUT_MS);
             btstack_run_loop_add_timer(&ins->setup_timer);
 
-            fsm_request_device_info(d);
+            // Calibration and device info are already known, skip them.
+            if (ins->cache_hit)
+                fsm_set_full_report(d);
+            else
+                fsm_request_device_info(d);
             break;
         case STATE_REQ_DEV_INFO:
             logd("STATE_REQ_DEV_INFO\n");
@@ -440,6 +499,7 @@ static void process_fsm(struct uni_hid_device_s* d) {
             break;
         case STATE_READ_FACTORY_IMU_CALIBRATION:
             logd("STATE_READ_FACTORY_IMU_CALIBRATION\n");
+            store_calibration_in_cache(d);
             fsm_set_full_report(d);
             break;
         case STATE_SET_FULL_REPORT:
@@ -536,17 +596,54 @@ static void process_reply_read_spi_factory_stick_calibration(struct uni_hid_devi
              ins->cal_ry.min, ins->cal_ry.center,
              ins->cal_ry.max  // ry
         );
+    ins->read_mask |= SWITCH_READ_FACTORY_STICK_CALIBRATION;
 }
 
 static void process_reply_read_spi_user_stick_calibration(struct uni_hid_device_s* d, const uint8_t* data, int len) {
-    ARG_UNUSED(d);
-    ARG_UNUSED(data);
-    ARG_UNUSED(len);
+    switch_instance_t* ins = get_switch_instance(d);
+
+    if (len < SWITCH_USER_STICK_CAL_DATA_SIZE) {
+        loge("Switch: invalid spi user stick calibration len; got %d, wanted >= %d\n", len,
+             SWITCH_USER_STICK_CAL_DATA_SIZE);
+        printf_hexdump(data, len);
+        return;
+    }
+
+    // Overrides the factory calibration, which was read before.
+    ins->user_stick_cal = parse_user_stick_calibration(ins, data);
+    ins->read_mask |= SWITCH_READ_USER_STICK_CALIBRATION;
+    if (ins->user_stick_cal)
+        logi("Switch: using user stick calibration (mask=0x%02x)\n", ins->user_stick_cal);
+}
+
+// Reply to the user stick calibration read issued once ready, when the setup used the cached calibration.
+// The user calibration can change at any time from the console settings, unlike the factory one.
+static void revalidate_user_stick_calibration(struct uni_hid_device_s* d, const uint8_t* data, int len) {
+    switch_instance_t* ins = get_switch_instance(d);
+    switch_cal_stick_t cal[] = {ins->cal_x, ins->cal_y, ins->cal_rx, ins->cal_ry};
+    uint8_t cached_user_stick_cal = ins->user_stick_cal;
 
-    // FIXME: Implement me
+    if (len < SWITCH_USER_STICK_CAL_DATA_SIZE) {
+        loge("Switch: invalid spi user stick calibration len; got %d, wanted >= %d\n", len,
+             SWITCH_USER_STICK_CAL_DATA_SIZE);
+        return;
+    }
+
+    ins->user_stick_cal = parse_user_stick_calibration(ins, data);
+
+    // The factory calibration is not read on a cache hit, so it cannot be restored now.
+    if (cached_user_stick_cal & ~ins->user_stick_cal) {
+        logi("Switch: user stick calibration was removed. Calibration will be read on next connection\n");
+        uni_bt_device_cache_delete(UNI_BT_DEVICE_CACHE_KIND_SWITCH, d->conn.btaddr);
+        return;
+    }
 
-    logd("process_reply_read_spi_user_stick_calibration\n");
-    // printf_hexdump(data, len);
+    // Already applied. Only the cache needs to be updated.
+    switch_cal_stick_t new_cal[] = {ins->cal_x, ins->cal_y, ins->cal_rx, ins->cal_ry};
+    if (cached_user_stick_cal != ins->user_stick_cal || memcmp(cal, new_cal, sizeof(cal)) != 0) {
+        logi("Switch: user stick calibration changed (mask=0x%02x). Updating cache\n", ins->user_stick_cal);
+        store_calibration_in_cache(d);
+    }
 }
 
 static void process_reply_read_spi_factory_imu_calibration(struct uni_hid_device_s* d, const uint8_t* data, int len) {
@@ -568,12 +665,8 @@ static void process_reply_read_spi_factory_imu_calibration(struct uni_hid_device
         ins->cal_gyro.scale[i] = data[j + 18] | data[j + 19] << 8;
     }
 
-    for (int i = 0; i < 3; i++) {
-        // Divisors that must be updated after calibration data is updated.
-        // FIXME: move to its own function
-        ins->imu_cal_accel_divisor[i] = ins->cal_accel.scale[i] - ins->cal_accel.offset[i];
-        ins->imu_cal_gyro_divisor[i] = ins->cal_gyro.scale[i] - ins->cal_gyro.offset[i];
-    }
+    update_imu_divisors(ins);
+    ins->read_mask |= SWITCH_READ_FACTORY_IMU_CALIBRATION;
 
     logi(
         "Switch: IMU calibration info: accel.offset=%d,%d,%d, accel.scale=%d,%d,%d, gyro.offset=%d,%d,%d, gyro."
@@ -588,25 +681,26 @@ static void process_reply_read_spi_factory_imu_calibration(struct uni_hid_device
 static void process_reply_req_dev_info(struct uni_hid_device_s* d, const struct switch_report_21_s* r, int len) {
     ARG_UNUSED(len);
     switch_instance_t* ins = get_switch_instance(d);
-    if (ins->state > STATE_SETUP && ins->mode == SWITCH_MODE_NONE) {
-        bool enable_imu;
-#if ENABLE_IMU_REPORT
-        enable_imu = true;
-#else
-        // Button "A" must be pressed in orther to enable IMU.
-        enable_imu = (r->status.buttons_right & 0x08);
-#endif
-        if (enable_imu) {
-            logi("Switch: IMU report enabled\n");
-            ins->mode = SWITCH_MODE_IMU;
-        } else {
-            logi("Switch: IMU report disabled\n");
-            ins->mode = SWITCH_MODE_NORMAL;
+
+    // Background validation of the cached calibration.
+    if (ins->state == STATE_READY && ins->cache_hit) {
+        ins->cache_hit = false;
+        if (r->data[0] != ins->firmware_version_hi || r->data[1] != ins->firmware_version_lo ||
+            r->data[2] != ins->controller_type) {
+            logi("Switch: cached calibration is stale (firmware %d.%d, type=%d). Will be read on next connection\n",
+                 r->data[0], r->data[1], r->data[2]);
+            uni_bt_device_cache_delete(UNI_BT_DEVICE_CACHE_KIND_SWITCH, d->conn.btaddr);
+            return;
         }
+        // Same controller. Only the user stick calibration might have changed since it was cached.
+        send_read_user_stick_calibration(d);
+        return;
     }
+
     ins->firmware_version_hi = r->data[0];
     ins->firmware_version_lo = r->data[1];
     ins->controller_type = r->data[2];
+    ins->read_mask |= SWITCH_READ_DEV_INFO;
     logi("Switch: Firmware version: %d.%d. Controller type=%d\n", r->data[0], r->data[1], r->data[2]);
 }
 
@@ -631,6 +725,12 @@ static void process_reply_spi_flash_read(struct uni_hid_device_s* d, const struc
 
     switch_instance_t* ins = get_switch_instance(d);
 
+    // Background validation of the cached calibration, see process_reply_req_dev_info().
+    if (ins->state == STATE_READY && addr == SWITCH_USER_STICK_CAL_DATA_ADDR) {
+        revalidate_user_stick_calibration(d, &r->data[5], mem_len);
+        return;
+    }
+
     switch (ins->state) {
         case STATE_READ_FACTORY_STICK_CALIBRATION:
             process_reply_read_spi_factory_stick_calibration(d, &r->data[5], mem_len);
@@ -674,6 +774,7 @@ static void process_input_subcmd_reply(struct uni_hid_device_s* d, const uint8_t
     if ((r->ack & 0b10000000) == 0) {
         loge("Switch: Error, subcommand id=0x%02x was not successful.\n", r->subcmd_id);
     }
+    update_mode(d, r);
     switch (r->subcmd_id) {
         case SUBCMD_REQ_DEV_INFO:
             process_reply_req_dev_info(d, r, len);
@@ -719,6 +820,55 @@ static void process_input_subcmd_reply(struct uni_hid_device_s* d, const uint8_t
     process_fsm(d);
 }
 
+// Selects the report mode from the first subcommand reply received during the setup. It must happen before
+// STATE_ENABLE_IMU, regardless of whether the setup used the cached calibration.
+static void update_mode(uni_hid_device_t* d, const struct switch_report_21_s* r) {
+    switch_instance_t* ins = get_switch_instance(d);
+    if (ins->state > STATE_SETUP && ins->mode == SWITCH_MODE_NONE) {
+        bool enable_imu;
+#if ENABLE_IMU_REPORT
+        ARG_UNUSED(r);
+        enable_imu = true;
+#else
+        // Button "A" must be pressed in orther to enable IMU.
+        enable_imu = (r->status.buttons_right & 0x08);
+#endif
+        if (enable_imu) {
+            logi("Switch: IMU report enabled\n");
+            ins->mode = SWITCH_MODE_IMU;
+        } else {
+            logi("Switch: IMU report disabled\n");
+            ins->mode = SWITCH_MODE_NORMAL;
+        }
+    }
+}
+
+// Applies the user calibration of the sticks that have one, and returns them as SWITCH_USER_STICK_CAL_ mask.
+// Guaranteed that data has at least SWITCH_USER_STICK_CAL_DATA_SIZE elements.
+static uint8_t parse_user_stick_calibration(switch_instance_t* ins, const uint8_t* data) {
+    const uint8_t* left = &data[0];
+    const uint8_t* right = &data[2 + SWITCH_FACTORY_STICK_CAL_DATA_SIZE];
+    uint8_t mask = 0;
+
+    if ((ins->controller_type == SWITCH_CONTROLLER_TYPE_PRO || ins->controller_type == SWITCH_CONTROLLER_TYPE_JCL) &&
+        memcmp(left, SWITCH_USER_STICK_CAL_MAGIC, sizeof(SWITCH_USER_STICK_CAL_MAGIC)) == 0) {
+        parse_stick_calibration(&ins->cal_x, &ins->cal_y, &left[2], true);
+        mask |= SWITCH_USER_STICK_CAL_LEFT;
+    }
+
+    if ((ins->controller_type == SWITCH_CONTROLLER_TYPE_PRO || ins->controller_type == SWITCH_CONTROLLER_TYPE_JCR) &&
+        memcmp(right, SWITCH_USER_STICK_CAL_MAGIC, sizeof(SWITCH_USER_STICK_CAL_MAGIC)) == 0) {
+        // Same as the factory calibration: the right Joy-Con uses cal_x and cal_y.
+        if (ins->controller_type == SWITCH_CONTROLLER_TYPE_JCR)
+            parse_stick_calibration(&ins->cal_x, &ins->cal_y, &right[2], false);
+        else
+            parse_stick_calibration(&ins->cal_rx, &ins->cal_ry, &right[2], false);
+        mask |= SWITCH_USER_STICK_CAL_RIGHT;
+    }
+
+    return mask;
+}
+
 static void parse_stick_calibration(switch_cal_stick_t* x, switch_cal_stick_t* y, const uint8_t* data, bool is_left) {
     int32_t cal_x_max;
     int32_t cal_y_max;
@@ -757,9 +907,8 @@ static void parse_stick_calibration(switch_cal_stick_t* x, switch_cal_stick_t* y
     y->max = y->center + cal_y_max;
 }
 
-static void parse_imu(uni_hid_device_t* d, const struct switch_imu_data_s* r) {
+static void parse_imu(uni_hid_device_t* d, const struct switch_imu_data_s* r, uni_motion_sample_t* sample) {
     switch_instance_t* ins = get_switch_instance(d);
-    uni_controller_t* ctl = &d->controller;
 
     int accel[3];
     int gyro[3];
@@ -782,8 +931,8 @@ static void parse_imu(uni_hid_device_t* d, const struct switch_imu_data_s* r) {
     }
 
     for (int i = 0; i < 3; i++) {
-        ctl->gamepad.accel[i] = accel[i];
-        ctl->gamepad.gyro[i] = gyro[i];
+        sample->accel[i] = accel[i];
+        sample->gyro[i] = gyro[i];
     }
 }
 
@@ -820,11 +969,23 @@ static void parse_report_30(struct uni_hid_device_s* d, const uint8_t* report, i
 
     // IMU is valid for all 3 types of controllers.
 
-    // 3 gyro/accel frames are reported.
-    // Different approaches: take the latest one, or average them.
-    // We just take the latest one. If it is not accurate enough, we can average them.
-    if (ins->mode == SWITCH_MODE_IMU)
-        parse_imu(d, &r->imu[2]);
+    // 3 gyro/accel frames are reported, oldest first, sampled every 5ms.
+    // All of them go to the motion ring, and the gamepad gets the latest one.
+    if (ins->mode == SWITCH_MODE_IMU) {
+        uint32_t now = btstack_run_loop_get_time_ms();
+        const int total = ARRAY_SIZE(r->imu);
+        uni_motion_sample_t sample;
+
+        for (int i = 0; i < total; i++) {
+            parse_imu(d, &r->imu[i], &sample);
+            sample.timestamp_ms = now - (total - 1 - i) * SWITCH_IMU_SAMPLE_PERIOD_MS;
+            uni_motion_ring_push(&d->motion, &sample);
+        }
+        for (int i = 0; i < 3; i++) {
+            ctl->gamepad.accel[i] = sample.accel[i];
+            ctl->gamepad.gyro[i] = sample.gyro[i];
+        }
+    }
 }
 
 // Shared both by Switch Pro Controller and Switch SNES.
@@ -1007,11 +1168,7 @@ static void fsm_request_device_info(struct uni_hid_device_s* d) {
     switch_instance_t* ins = get_switch_instance(d);
     ins->state = STATE_REQ_DEV_INFO;
 
-    struct switch_subcmd_request req = {
-        .report_id = 0x01,  // 0x01 for sub commands
-        .subcmd_id = SUBCMD_REQ_DEV_INFO,
-    };
-    send_subcmd(d, &req, sizeof(req));
+    send_request_device_info(d);
 }
 
 static void fsm_read_factory_stick_calibration(struct uni_hid_device_s* d) {
@@ -1046,6 +1203,10 @@ static void fsm_read_user_stick_calibration(struct uni_hid_device_s* d) {
     switch_instance_t* ins = get_switch_instance(d);
     ins->state = STATE_READ_USER_STICK_CALIBRATION;
 
+    send_read_user_stick_calibration(d);
+}
+
+static void send_read_user_stick_calibration(uni_hid_device_t* d) {
     uint8_t out[sizeof(struct switch_subcmd_request) + 5] = {0};
     struct switch_subcmd_request* req = (struct switch_subcmd_request*)&out[0];
     req->report_id = 0x01;  // 0x01 for sub commands
@@ -1116,6 +1277,79 @@ static void fsm_ready(struct uni_hid_device_s* d) {
 
     // So that it can end gracefully, disabling the timer
     process_fsm(d);
+
+    // The cached calibration is validated in the background, without delaying the setup: first the device info,
+    // then the user stick calibration.
+    if (ins->cache_hit)
+        send_request_device_info(d);
+}
+
+static void send_request_device_info(uni_hid_device_t* d) {
+    struct switch_subcmd_request req = {
+        .report_id = 0x01,  // 0x01 for sub commands
+        .subcmd_id = SUBCMD_REQ_DEV_INFO,
+    };
+    send_subcmd(d, &req, sizeof(req));
+}
+
+static void update_imu_divisors(switch_instance_t* ins) {
+    // Divisors that must be updated after calibration data is updated.
+    for (int i = 0; i < 3; i++) {
+        ins->imu_cal_accel_divisor[i] = ins->cal_accel.scale[i] - ins->cal_accel.offset[i];
+        ins->imu_cal_gyro_divisor[i] = ins->cal_gyro.scale[i] - ins->cal_gyro.offset[i];
+    }
+}
+
+static void load_calibration_from_cache(uni_hid_device_t* d) {
+    switch_instance_t* ins = get_switch_instance(d);
+    switch_cache_t cache;
+
+    if (!uni_bt_device_cache_get(UNI_BT_DEVICE_CACHE_KIND_SWITCH, d->conn.btaddr, &cache, sizeof(cache)))
+        return;
+    if (cache.version != SWITCH_CACHE_VERSION)
+        return;
+
+    ins->firmware_version_hi = cache.firmware_version_hi;
+    ins->firmware_version_lo = cache.firmware_version_lo;
+    ins->controller_type = cache.controller_type;
+    ins->cal_x = cache.cal_x;
+    ins->cal_y = cache.cal_y;
+    ins->cal_rx = cache.cal_rx;
+    ins->cal_ry = cache.cal_ry;
+    ins->cal_accel = cache.cal_accel;
+    ins->cal_gyro = cache.cal_gyro;
+    ins->user_stick_cal = cache.user_stick_cal;
+    update_imu_divisors(ins);
+
+    // Everything in the cache was read from the controller. Allows updating it after the revalidation.
+    ins->read_mask = SWITCH_READ_ALL;
+    ins->cache_hit = true;
+
+    logi("Switch: using cached calibration. Firmware version: %d.%d. Controller type=%d\n", ins->firmware_version_hi,
+         ins->firmware_version_lo, ins->controller_type);
+}
+
+static void store_calibration_in_cache(uni_hid_device_t* d) {
+    switch_instance_t* ins = get_switch_instance(d);
+    switch_cache_t cache;
+
+    // Don't cache the defaults, like when one of the requests timed out.
+    if ((ins->read_mask & SWITCH_READ_ALL) != SWITCH_READ_ALL)
+        return;
+
+    memset(&cache, 0, sizeof(cache));
+    cache.version = SWITCH_CACHE_VERSION;
+    cache.firmware_version_hi = ins->firmware_version_hi;
+    cache.firmware_version_lo = ins->firmware_version_lo;
+    cache.controller_type = ins->controller_type;
+    cache.user_stick_cal = ins->user_stick_cal;
+    cache.cal_x = ins->cal_x;
+    cache.cal_y = ins->cal_y;
+    cache.cal_rx = ins->cal_rx;
+    cache.cal_ry = ins->cal_ry;
+    cache.cal_accel = ins->cal_accel;
+    cache.cal_gyro = ins->cal_gyro;
+    uni_bt_device_cache_set(UNI_BT_DEVICE_CACHE_KIND_SWITCH, d->conn.btaddr, &cache, sizeof(cache));
 }
 
 static struct switch_rumble_freq_data find_rumble_freq(uint16_t freq) {
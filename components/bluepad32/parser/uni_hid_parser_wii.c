@@ -19,7 +19,9 @@
 
 #include "parser/uni_hid_parser_wii.h"
 
+#include "bt/uni_bt_device_cache.h"
 #include "controller/uni_controller.h"
+#include "controller/uni_motion.h"
 #include "hid_usage.h"
 #include "uni_common.h"
 #include "uni_hid_device.h"
@@ -33,6 +35,9 @@ static const uint32_t WII_DUMP_ROM_DATA_ADDR_END = 0x1700;
 
 #define DRM_KEE_BATTERY_MASK GENMASK(6, 4)
 
+// Bump it when wii_cache_t changes.
+#define WII_CACHE_VERSION 1
+
 // Taken from Linux kernel: hid-wiimote.h
 enum wiiproto_reqs {
     WIIPROTO_REQ_NULL = 0x0,
@@ -100,6 +105,7 @@ enum wii_fsm {
     WII_FSM_DEV_ASSIGNED,  // Device type assigned
     WII_FSM_LED_UPDATED,   // After a device was assigned, update LEDs.
                            // Gamepad ready to be used
+    WII_FSM_CACHE_DID_READ_REGISTER,  // Ready. Validating the cached extension type in the background
 };
 
 typedef enum {
@@ -162,12 +168,28 @@ typedef struct wii_instance_s {
 
     balance_board_calibration_t balance_board_calibration;
 
+    // Extension cache. Used only if the status report says that an extension is attached,
+    // and validated against the extension register once the device is ready.
+    bool cache_hit;
+    uint8_t cached_dev_type;
+    uint8_t cached_ext_type;
+
     // Debug only
     int debug_fd;         // File descriptor where dump is saved
     uint32_t debug_addr;  // Current dump address
 } wii_instance_t;
 _Static_assert(sizeof(wii_instance_t) < HID_DEVICE_MAX_PARSER_DATA, "Wii instance too big");
 
+// What gets stored in the device cache, to skip the extension and calibration reads on reconnect.
+typedef struct {
+    uint8_t version;
+    uint8_t dev_type;
+    uint8_t ext_type;
+    uint8_t register_address;
+    uint16_t balance_board_calibration[3][4];  // kg0, kg17, kg34. Each one: tr, br, tl, bl
+} wii_cache_t;
+_Static_assert(sizeof(wii_cache_t) <= UNI_BT_DEVICE_CACHE_MAX_LEN, "Wii cache too big");
+
 static void process_req_status(uni_hid_device_t* d, const uint8_t* report, uint16_t len);
 static void process_req_data(uni_hid_device_t* d, const uint8_t* report, uint16_t len);
 static void process_req_return(uni_hid_device_t* d, const uint8_t* report, uint16_t len);
@@ -179,6 +201,8 @@ static void process_drm_ke(uni_hid_device_t* d, const uint8_t* report, uint16_t
 static void process_drm_kae(uni_hid_device_t* d, const uint8_t* report, uint16_t len);
 static void process_drm_kee(uni_hid_device_t* d, const uint8_t* report, uint16_t len);
 static void process_drm_e(uni_hid_device_t* d, const uint8_t* report, uint16_t len);
+static void process_accel(uni_hid_device_t* d, const uint8_t* report);
+static void process_buttons_and_nunchuk(uni_hid_device_t* d, const uint8_t* buttons, const uint8_t* e, uint16_t len);
 static nunchuk_t process_nunchuk(const uint8_t* e, uint16_t len);
 static balance_board_t process_balance_board(uni_hid_device_t* d, const uint8_t* e, uint16_t len);
 
@@ -190,8 +214,13 @@ static void wii_fsm_req_status(uni_hid_device_t* d);
 static void wii_fsm_assign_device(uni_hid_device_t* d);
 static void wii_fsm_update_led(uni_hid_device_t* d);
 static void wii_fsm_dump_eeprom(uni_hid_device_t* d);
+static void wii_fsm_ext_from_cache(uni_hid_device_t* d);
+static void wii_fsm_validate_cache(uni_hid_device_t* d);
+static void wii_load_cache(uni_hid_device_t* d);
+static void wii_store_cache(uni_hid_device_t* d);
 
 static void wii_read_mem(uni_hid_device_t* d, wii_read_type_t t, uint32_t offset, uint16_t size);
+static void wii_request_drm(uni_hid_device_t* d);
 static wii_instance_t* get_wii_instance(uni_hid_device_t* d);
 static void wii_set_led(uni_hid_device_t* d, uni_gamepad_seat_t seat);
 static void on_wii_set_rumble_on(btstack_timer_source_t* ts);
@@ -206,6 +235,8 @@ static const char* wii_devtype_names[] = {
     "Wii Mote Motion Plus (2nd gen)",  // WII_DEVTYPE_REMOTE_MP
 };
 
+static uint8_t wii_data_policy = WII_DATA_DEFAULT;
+
 static const char* wii_exttype_names[] = {
     "N/A",                 // WII_EXT_NONE
     "Unknown",             // WII_EXT_UNK
@@ -255,6 +286,13 @@ static void process_req_status(uni_hid_device_t* d, const uint8_t* report, uint1
             ins->ext_type = WII_EXT_NONE;
         }
 
+        // The cache is only used when the status report agrees with it.
+        if (ins->cache_hit && ins->ext_type == WII_EXT_NONE) {
+            logi("Wii: extension was removed, ignoring cache\n");
+            ins->cache_hit = false;
+            ins->register_address = 0xa4;
+        }
+
         if (report[2] & 0x08) {
             // Wii Remote only: Enter "accel mode" if "A" is pressed.
             ins->mode = WII_MODE_ACCEL;
@@ -267,6 +305,24 @@ static void process_req_status(uni_hid_device_t* d, const uint8_t* report, uint1
     }
 }
 
+// "id" is the 6-byte extension identifier, read from register 0xa?00fa.
+static enum wii_exttype wii_ext_type_from_id(const uint8_t* id) {
+    if (id[4] == 0x01 && id[5] == 0x20) {
+        // Pro Controller: 00 00 a4 20 01 20
+        return WII_EXT_U_PRO_CONTROLLER;
+    } else if (id[4] == 0x00 && id[5] == 0x00) {
+        // Nunchuck: 00 00 a4 20 00 00
+        return WII_EXT_NUNCHUK;
+    } else if (id[4] == 0x04 && id[5] == 0x02) {
+        // Balance Board: 00 00 a4 20 04 02
+        return WII_EXT_BALANCE_BOARD;
+    } else if (id[4] == 0x01 && id[5] == 0x01) {
+        // Classic / Classic Pro: 0? 00 a4 20 01 01
+        return WII_EXT_CLASSIC_CONTROLLER;
+    }
+    return WII_EXT_UNK;
+}
+
 // Defined here: http://wiibrew.org/wiki/Wiimote#0x21:_Read_Memory_Data
 static void process_req_data_read_register(uni_hid_device_t* d, const uint8_t* report, uint16_t len) {
     uint8_t se = report[3];  // SE: size and error
@@ -284,9 +340,10 @@ static void process_req_data_read_register(uni_hid_device_t* d, const uint8_t* r
         // This contains the read memory from register 0xa?00fa
         // Data is in report[6]..report[11]
 
+        enum wii_exttype ext_type = wii_ext_type_from_id(&report[6]);
+
         // Try to guess device type.
-        if (report[10] == 0x01 && report[11] == 0x20) {
-            // Pro Controller: 00 00 a4 20 01 20
+        if (ext_type == WII_EXT_U_PRO_CONTROLLER) {
             ins->dev_type = WII_DEVTYPE_PRO_CONTROLLER;
             ins->ext_type = WII_EXT_U_PRO_CONTROLLER;
         } else if (ins->dev_type == WII_DEVTYPE_UNK) {
@@ -301,18 +358,11 @@ static void process_req_data_read_register(uni_hid_device_t* d, const uint8_t* r
 
         // Try to guess extension type.
         if (ins->ext_type == WII_EXT_UNK) {
-            if (report[10] == 0x00 && report[11] == 0x00) {
-                // Nunchuck: 00 00 a4 20 00 00
-                ins->ext_type = WII_EXT_NUNCHUK;
+            ins->ext_type = ext_type;
+            if (ext_type == WII_EXT_NUNCHUK) {
                 // If a Nunchuck is attached, WiiMode is treated as vertical mode
                 ins->mode = WII_MODE_VERTICAL;
-            } else if (report[10] == 0x04 && report[11] == 0x02) {
-                // Balance Board: 00 00 a4 20 04 02
-                ins->ext_type = WII_EXT_BALANCE_BOARD;
-            } else if (report[10] == 0x01 && report[11] == 0x01) {
-                // Classic / Classic Pro: 0? 00 a4 20 01 01
-                ins->ext_type = WII_EXT_CLASSIC_CONTROLLER;
-            } else {
+            } else if (ext_type == WII_EXT_UNK) {
                 loge("Wii: Unknown extension\n");
                 printf_hexdump(report, len);
             }
@@ -332,6 +382,28 @@ static void process_req_data_read_register(uni_hid_device_t* d, const uint8_t* r
     }
 }
 
+static void process_req_data_validate_cache(uni_hid_device_t* d, const uint8_t* report, uint16_t len) {
+    ARG_UNUSED(len);
+    uint8_t se = report[3];  // SE: size and error
+    uint8_t s = se >> 4;     // size
+    uint8_t e = se & 0x0f;   // error
+    if (e || s != 5 || report[4] != 0x00 || report[5] != 0xfa) {
+        loge("Wii: could not validate cached extension: 0x%02x\n", se);
+        return;
+    }
+
+    wii_instance_t* ins = get_wii_instance(d);
+    ins->cache_hit = false;
+    if (wii_ext_type_from_id(&report[6]) == ins->ext_type)
+        return;
+
+    // A different extension was attached. The device was already assigned and reported as ready with the cached
+    // extension, so it cannot be assigned again. Disconnect it instead: it is detected again on reconnect.
+    logi("Wii: cached extension is stale, disconnecting\n");
+    uni_bt_device_cache_delete(UNI_BT_DEVICE_CACHE_KIND_WII, d->conn.btaddr);
+    uni_hid_device_disconnect(d);
+}
+
 static void process_req_data_read_calibration_data(uni_hid_device_t* d, const uint8_t* report, uint16_t len) {
     ARG_UNUSED(len);
     uint8_t se = report[3];  // SE: size and error
@@ -462,6 +534,9 @@ static void process_req_data(uni_hid_device_t* d, const uint8_t* report, uint16_
         case WII_FSM_DUMP_EEPROM_IN_PROGRESS:
             process_req_data_dump_eeprom(d, report, len);
             break;
+        case WII_FSM_CACHE_DID_READ_REGISTER:
+            process_req_data_validate_cache(d, report, len);
+            break;
         default:
             loge("process_req_data. Unknown FSM state: 0x%02x\n", ins->state);
             break;
@@ -514,6 +589,7 @@ static void process_drm_k(uni_hid_device_t* d, const uint8_t* report, uint16_t l
 
     switch (ins->mode) {
         case WII_MODE_HORIZONTAL:
+        case WII_MODE_ACCEL:
             process_drm_k_horizontal(ctl, data);
             break;
         case WII_MODE_VERTICAL:
@@ -528,7 +604,7 @@ static void process_drm_k(uni_hid_device_t* d, const uint8_t* report, uint16_t l
     ctl->gamepad.misc_buttons |= (data[1] & 0x10) ? MISC_BUTTON_SELECT : 0;  // Button "-"
 }
 
-// Used for WiiMote in Sideways Mode (Directions and A/B/X/Y Buttons only).
+// Used for WiiMote in Sideways and Accelerometer Mode (Directions and A/B/X/Y Buttons only).
 static void process_drm_k_horizontal(uni_controller_t* ctl, const uint8_t* data) {
     // dpad
     ctl->gamepad.dpad |= (data[0] & 0x01) ? DPAD_DOWN : 0;
@@ -558,8 +634,8 @@ static void process_drm_k_vertical(uni_controller_t* ctl, const uint8_t* data) {
     ctl->gamepad.buttons |= (data[1] & 0x01) ? BUTTON_Y : 0;  // Button "2"
 }
 
-// Used for WiiMote in Accelerometer Mode. Defined here:
-// http://wiibrew.org/wiki/Wiimote#0x31:_Core_Buttons_and_Accelerometer
+// Used for WiiMote in Accelerometer Mode, or when the platform wants the accelerometer.
+// Defined here: http://wiibrew.org/wiki/Wiimote#0x31:_Core_Buttons_and_Accelerometer
 static void process_drm_ka(uni_hid_device_t* d, const uint8_t* report, uint16_t len) {
     // Process Wiimote in "accelerator mode".
     /* DRM_KA: BB*2 AA*3*/
@@ -570,6 +646,13 @@ static void process_drm_ka(uni_hid_device_t* d, const uint8_t* report, uint16_t
         return;
     }
 
+    process_accel(d, report);
+    // Buttons are the same as in DRM_K.
+    process_drm_k(d, report, len);
+}
+
+// Accelerometer from the DRMs that have it: "report" starts with the report id, followed by BB BB AA AA AA.
+static void process_accel(uni_hid_device_t* d, const uint8_t* report) {
     uint16_t x = (report[3] << 2) | ((report[1] >> 5) & 0x3);
     uint16_t y = (report[4] << 2) | ((report[2] >> 4) & 0x2);
     uint16_t z = (report[5] << 2) | ((report[2] >> 5) & 0x2);
@@ -586,21 +669,8 @@ static void process_drm_ka(uni_hid_device_t* d, const uint8_t* report, uint16_t
     ctl->gamepad.accel[0] = sx;
     ctl->gamepad.accel[1] = sy;
     ctl->gamepad.accel[2] = sz;
-
-    // Dpad works as dpad, useful to navigate menus.
-    ctl->gamepad.dpad |= (report[1] & 0x01) ? DPAD_DOWN : 0;
-    ctl->gamepad.dpad |= (report[1] & 0x02) ? DPAD_UP : 0;
-    ctl->gamepad.dpad |= (report[1] & 0x04) ? DPAD_RIGHT : 0;
-    ctl->gamepad.dpad |= (report[1] & 0x08) ? DPAD_LEFT : 0;
-
-    ctl->gamepad.buttons |= (report[2] & 0x02) ? BUTTON_A : 0;  // Button "1"
-    ctl->gamepad.buttons |= (report[2] & 0x01) ? BUTTON_B : 0;  // Button "2"
-    ctl->gamepad.buttons |= (report[2] & 0x08) ? BUTTON_X : 0;  // Big button "A"
-    ctl->gamepad.buttons |= (report[2] & 0x04) ? BUTTON_Y : 0;  // Button Shoulder
-
-    ctl->gamepad.misc_buttons |= (report[2] & 0x80) ? MISC_BUTTON_SYSTEM : 0;  // Button "home"
-    ctl->gamepad.misc_buttons |= (report[2] & 0x10) ? MISC_BUTTON_SELECT : 0;  // Button "-"
-    ctl->gamepad.misc_buttons |= (report[1] & 0x10) ? MISC_BUTTON_START : 0;   // Button "+"
+    // No gyro on the Wiimote. Gyro values are zero.
+    uni_motion_ring_push_gamepad(&d->motion, &ctl->gamepad, btstack_run_loop_get_time_ms());
 }
 
 // Used in WiiMote + Nunchuk Mode
@@ -625,10 +695,15 @@ static void process_drm_ke(uni_hid_device_t* d, const uint8_t* report, uint16_t
         return;
     }
 
+    process_buttons_and_nunchuk(d, &report[1], &report[3], len - 3);
+}
+
+// Wii remote (vertical) + Nunchuk. "buttons" points to BB BB, "e" to the Nunchuk extension bytes.
+static void process_buttons_and_nunchuk(uni_hid_device_t* d, const uint8_t* buttons, const uint8_t* e, uint16_t len) {
     //
     // Process Nunchuk: Right axis, buttons X and Y
     //
-    nunchuk_t n = process_nunchuk(&report[3], len - 3);
+    nunchuk_t n = process_nunchuk(e, len);
     uni_controller_t* ctl = &d->controller;
     const int factor = (AXIS_NORMALIZE_RANGE / 2) / 128;
 
@@ -642,31 +717,42 @@ static void process_drm_ke(uni_hid_device_t* d, const uint8_t* report, uint16_t
     //
 
     // dpad
-    ctl->gamepad.dpad |= (report[1] & 0x01) ? DPAD_LEFT : 0;
-    ctl->gamepad.dpad |= (report[1] & 0x02) ? DPAD_RIGHT : 0;
-    ctl->gamepad.dpad |= (report[1] & 0x04) ? DPAD_DOWN : 0;
-    ctl->gamepad.dpad |= (report[1] & 0x08) ? DPAD_UP : 0;
+    ctl->gamepad.dpad |= (buttons[0] & 0x01) ? DPAD_LEFT : 0;
+    ctl->gamepad.dpad |= (buttons[0] & 0x02) ? DPAD_RIGHT : 0;
+    ctl->gamepad.dpad |= (buttons[0] & 0x04) ? DPAD_DOWN : 0;
+    ctl->gamepad.dpad |= (buttons[0] & 0x08) ? DPAD_UP : 0;
 
-    ctl->gamepad.buttons |= (report[2] & 0x04) ? BUTTON_A : 0;  // Shoulder button
-    ctl->gamepad.buttons |= (report[2] & 0x08) ? BUTTON_B : 0;  // Big button "A"
+    ctl->gamepad.buttons |= (buttons[1] & 0x04) ? BUTTON_A : 0;  // Shoulder button
+    ctl->gamepad.buttons |= (buttons[1] & 0x08) ? BUTTON_B : 0;  // Big button "A"
 
-    ctl->gamepad.buttons |= (report[2] & 0x02) ? BUTTON_SHOULDER_L : 0;  // Button "1"
-    ctl->gamepad.buttons |= (report[2] & 0x01) ? BUTTON_SHOULDER_R : 0;  // Button "2"
+    ctl->gamepad.buttons |= (buttons[1] & 0x02) ? BUTTON_SHOULDER_L : 0;  // Button "1"
+    ctl->gamepad.buttons |= (buttons[1] & 0x01) ? BUTTON_SHOULDER_R : 0;  // Button "2"
 
-    ctl->gamepad.misc_buttons |= (report[2] & 0x80) ? MISC_BUTTON_SYSTEM : 0;  // Button "home"
-    ctl->gamepad.misc_buttons |= (report[2] & 0x10) ? MISC_BUTTON_SELECT : 0;  // Button "-"
-    ctl->gamepad.misc_buttons |= (report[1] & 0x10) ? MISC_BUTTON_START : 0;   // Button "+"
+    ctl->gamepad.misc_buttons |= (buttons[1] & 0x80) ? MISC_BUTTON_SYSTEM : 0;  // Button "home"
+    ctl->gamepad.misc_buttons |= (buttons[1] & 0x10) ? MISC_BUTTON_SELECT : 0;  // Button "-"
+    ctl->gamepad.misc_buttons |= (buttons[0] & 0x10) ? MISC_BUTTON_START : 0;   // Button "+"
 }
 
+// Used in WiiMote + Nunchuk, when the accelerometer is also needed.
 // Defined here:
 // http://wiibrew.org/wiki/Wiimote#0x35:_Core_Buttons_and_Accelerometer_with_16_Extension_Bytes
 static void process_drm_kae(uni_hid_device_t* d, const uint8_t* report, uint16_t len) {
     // Expecting something like:
     // (a1) 35 BB BB AA AA AA EE EE EE EE EE EE EE EE EE EE EE EE EE EE EE EE
-    ARG_UNUSED(d);
-    ARG_UNUSED(report);
-    ARG_UNUSED(len);
-    loge("Wii: drm_kae not supported yet\n");
+    if (len < 12) {
+        loge("Wii: unexpected len; got %d, want >= 12\n", len);
+        return;
+    }
+
+    wii_instance_t* ins = get_wii_instance(d);
+    if (ins->ext_type != WII_EXT_NUNCHUK) {
+        loge("Wii: unexpected Wii extension: got %d, want: %d", ins->ext_type, WII_EXT_NUNCHUK);
+        return;
+    }
+
+    process_accel(d, report);
+    // Buttons use the Nunchuk layout, regardless of the mode.
+    process_buttons_and_nunchuk(d, &report[1], &report[6], len - 6);
 }
 
 static nunchuk_t process_nunchuk(const uint8_t* e, uint16_t len) {
@@ -1034,9 +1120,30 @@ static void wii_fsm_balance_board_read_calibration2(uni_hid_device_t* d) {
     wii_read_mem(d, WII_READ_FROM_REGISTERS, offset, bytes_to_read);
 }
 
+static void wii_fsm_ext_from_cache(uni_hid_device_t* d) {
+    logi("fsm: ext_from_cache\n");
+    wii_instance_t* ins = get_wii_instance(d);
+
+    ins->dev_type = ins->cached_dev_type;
+    ins->ext_type = ins->cached_ext_type;
+    // Same as when the extension is read from the register.
+    if (ins->ext_type == WII_EXT_NUNCHUK)
+        ins->mode = WII_MODE_VERTICAL;
+
+    logi("Wii: Device: %s, Extension: %s (cached)\n", wii_devtype_names[ins->dev_type],
+         wii_exttype_names[ins->ext_type]);
+
+    ins->state = WII_FSM_DEV_GUESSED;
+    wii_process_fsm(d);
+}
+
 static void wii_fsm_assign_device(uni_hid_device_t* d) {
     logi("fsm: assign_device\n");
     wii_instance_t* ins = get_wii_instance(d);
+
+    if (!ins->cache_hit)
+        wii_store_cache(d);
+
     uint8_t dev = ins->dev_type;
     switch (dev) {
         case WII_DEVTYPE_UNK:
@@ -1050,20 +1157,7 @@ static void wii_fsm_assign_device(uni_hid_device_t* d) {
                 logi("Unknown Wii device detected. Treating it as Wii Remote.\n");
             }
             uint8_t reportType = 0xff;
-            if (ins->ext_type == WII_EXT_NUNCHUK) {
-                // Request Nunchuk data
-                if (ins->mode == WII_MODE_ACCEL) {
-                    // Request Core buttons + Accel + extension (nunchuk)
-                    reportType = WIIPROTO_REQ_DRM_KAE;
-                    logi("Wii: requesting Core buttons + Accelerometer + E (Nunchuk)\n");
-                    d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_NUNCHUK_ACCEL;
-                } else {
-                    // Request Core buttons + extension (nunchuk)
-                    reportType = WIIPROTO_REQ_DRM_KE;
-                    logi("Wii: requesting Core buttons + E (Nunchuk)\n");
-                    d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_NUNCHUK;
-                }
-            } else if (ins->ext_type == WII_EXT_CLASSIC_CONTROLLER) {
+            if (ins->ext_type == WII_EXT_CLASSIC_CONTROLLER) {
                 logi("Wii: requesting E (Classic Controller)\n");
                 d->controller_subtype = CONTROLLER_SUBTYPE_WII_CLASSIC;
                 reportType = WIIPROTO_REQ_DRM_E;
@@ -1072,20 +1166,9 @@ static void wii_fsm_assign_device(uni_hid_device_t* d) {
                 d->controller_subtype = CONTROLLER_SUBTYPE_WII_BALANCE_BOARD;
                 reportType = WIIPROTO_REQ_DRM_KEE;
             } else {
-                if (ins->mode == WII_MODE_ACCEL) {
-                    // Request Core buttons + accel
-                    reportType = WIIPROTO_REQ_DRM_KA;
-                    logi("Wii: requesting Core buttons + Accelerometer\n");
-                    d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_ACCEL;
-                } else {
-                    reportType = WIIPROTO_REQ_DRM_K;
-                    logi("Wii: requesting Core buttons\n");
-                    if (ins->mode == WII_MODE_VERTICAL) {
-                        d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_VERTICAL;
-                    } else {
-                        d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_HORIZONTAL;
-                    }
-                }
+                // Wii Remote, with or without Nunchuk: depends on the data policy.
+                wii_request_drm(d);
+                break;
             }
             uint8_t report[] = {0xa2, WIIPROTO_REQ_DRM, 0x00, reportType};
             uni_hid_device_send_intr_report(d, report, sizeof(report));
@@ -1113,7 +1196,21 @@ static void wii_fsm_update_led(uni_hid_device_t* d) {
     ins->state = WII_FSM_LED_UPDATED;
     wii_process_fsm(d);
 
-    uni_hid_device_set_ready_complete(d);
+    if (!uni_hid_device_set_ready_complete(d))
+        return;
+
+    // The cached extension type is validated without delaying the setup.
+    if (ins->cache_hit)
+        wii_fsm_validate_cache(d);
+}
+
+static void wii_fsm_validate_cache(uni_hid_device_t* d) {
+    logi("fsm: validate_cache\n");
+    wii_instance_t* ins = get_wii_instance(d);
+    ins->state = WII_FSM_CACHE_DID_READ_REGISTER;
+
+    uint32_t offset = 0x0000fa | (ins->register_address << 16);
+    wii_read_mem(d, WII_READ_FROM_REGISTERS, offset, 6);
 }
 
 static void wii_fsm_dump_eeprom(struct uni_hid_device_s* d) {
@@ -1161,7 +1258,11 @@ static void wii_process_fsm(uni_hid_device_t* d) {
             wii_fsm_ext_encrypt_off(d);
             break;
         case WII_FSM_EXT_DID_NO_ENCRYPTION:
-            wii_fsm_ext_read_register(d);
+            // The extension must be initialized on every connection, but its type can be taken from the cache.
+            if (ins->cache_hit)
+                wii_fsm_ext_from_cache(d);
+            else
+                wii_fsm_ext_read_register(d);
             break;
         case WII_FSM_EXT_DID_READ_REGISTER:
             // Do nothing
@@ -1183,6 +1284,7 @@ static void wii_process_fsm(uni_hid_device_t* d) {
             wii_fsm_update_led(d);
             break;
         case WII_FSM_LED_UPDATED:
+        case WII_FSM_CACHE_DID_READ_REGISTER:
             break;
         default:
             loge("Wii: wii_process_fsm() unexpected state: %d\n", ins->state);
@@ -1203,6 +1305,8 @@ void uni_hid_parser_wii_setup(uni_hid_device_t* d) {
     // If it fails it will use 0xa60000
     ins->register_address = 0xa4;
 
+    wii_load_cache(d);
+
     // Dump EEPROM
 #if ENABLE_EEPROM_DUMP
     ins->debug_addr = WII_DUMP_ROM_DATA_ADDR_START;
@@ -1322,28 +1426,75 @@ void uni_hid_parser_wii_set_mode(uni_hid_device_t* d, wii_mode_t mode) {
     wii_instance_t* ins = get_wii_instance(d);
 
     ins->mode = mode;
-    switch (ins->mode) {
-        case WII_MODE_HORIZONTAL:
-            d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_HORIZONTAL;
-            break;
-        case WII_MODE_VERTICAL:
-            d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_VERTICAL;
-            break;
-        case WII_MODE_ACCEL:
-            // TODO: request Accel report. As it is, it doesn't work.
-            if (ins->ext_type == WII_EXT_NONE)
-                d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_ACCEL;
-            else if (ins->ext_type == WII_EXT_NUNCHUK)
-                d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_NUNCHUK_ACCEL;
-            break;
-        default:
-            break;
-    }
+
+    // Otherwise, it will be requested once the device gets assigned.
+    if (ins->state < WII_FSM_DEV_ASSIGNED)
+        return;
+    if (ins->dev_type == WII_DEVTYPE_PRO_CONTROLLER || ins->ext_type == WII_EXT_CLASSIC_CONTROLLER ||
+        ins->ext_type == WII_EXT_BALANCE_BOARD)
+        return;
+    wii_request_drm(d);
+}
+
+void uni_hid_parser_wii_set_data_policy(uint8_t data) {
+    wii_data_policy = data;
+}
+
+uint8_t uni_hid_parser_wii_get_data_policy(void) {
+    return wii_data_policy;
 }
 
 //
 // Helpers
 //
+static void wii_load_cache(uni_hid_device_t* d) {
+    wii_instance_t* ins = get_wii_instance(d);
+    balance_board_t* cal[] = {&ins->balance_board_calibration.kg0, &ins->balance_board_calibration.kg17,
+                              &ins->balance_board_calibration.kg34};
+    wii_cache_t cache;
+
+    if (!uni_bt_device_cache_get(UNI_BT_DEVICE_CACHE_KIND_WII, d->conn.btaddr, &cache, sizeof(cache)))
+        return;
+    if (cache.version != WII_CACHE_VERSION || cache.dev_type >= ARRAY_SIZE(wii_devtype_names) ||
+        cache.ext_type >= ARRAY_SIZE(wii_exttype_names))
+        return;
+
+    ins->cached_dev_type = cache.dev_type;
+    ins->cached_ext_type = cache.ext_type;
+    ins->register_address = cache.register_address;
+    for (int i = 0; i < 3; i++) {
+        cal[i]->tr = cache.balance_board_calibration[i][0];
+        cal[i]->br = cache.balance_board_calibration[i][1];
+        cal[i]->tl = cache.balance_board_calibration[i][2];
+        cal[i]->bl = cache.balance_board_calibration[i][3];
+    }
+    ins->cache_hit = true;
+}
+
+static void wii_store_cache(uni_hid_device_t* d) {
+    wii_instance_t* ins = get_wii_instance(d);
+    const balance_board_t* cal[] = {&ins->balance_board_calibration.kg0, &ins->balance_board_calibration.kg17,
+                                    &ins->balance_board_calibration.kg34};
+    wii_cache_t cache;
+
+    // Only worth it when the extension type had to be read from the registers.
+    if (ins->ext_type == WII_EXT_NONE || ins->ext_type == WII_EXT_UNK)
+        return;
+
+    memset(&cache, 0, sizeof(cache));
+    cache.version = WII_CACHE_VERSION;
+    cache.dev_type = ins->dev_type;
+    cache.ext_type = ins->ext_type;
+    cache.register_address = ins->register_address;
+    for (int i = 0; i < 3; i++) {
+        cache.balance_board_calibration[i][0] = cal[i]->tr;
+        cache.balance_board_calibration[i][1] = cal[i]->br;
+        cache.balance_board_calibration[i][2] = cal[i]->tl;
+        cache.balance_board_calibration[i][3] = cal[i]->bl;
+    }
+    uni_bt_device_cache_set(UNI_BT_DEVICE_CACHE_KIND_WII, d->conn.btaddr, &cache, sizeof(cache));
+}
+
 static wii_instance_t* get_wii_instance(uni_hid_device_t* d) {
     return (wii_instance_t*)&d->parser_data[0];
 }
@@ -1422,6 +1573,47 @@ static void on_wii_set_rumble_off(btstack_timer_source_t* ts) {
     wii_stop_rumble_now(d);
 }
 
+// Wii Remote, with or without Nunchuk: requests the smallest DRM that covers what the mode
+// and the platform need, and updates the subtype accordingly.
+static void wii_request_drm(uni_hid_device_t* d) {
+    wii_instance_t* ins = get_wii_instance(d);
+    bool accel = ins->mode == WII_MODE_ACCEL || (wii_data_policy & WII_DATA_ACCEL);
+    bool nunchuk = ins->ext_type == WII_EXT_NUNCHUK && (wii_data_policy & WII_DATA_NUNCHUK);
+    uint8_t report_type;
+
+    if (nunchuk) {
+        if (accel) {
+            // Request Core buttons + Accel + extension (nunchuk)
+            report_type = WIIPROTO_REQ_DRM_KAE;
+            logi("Wii: requesting Core buttons + Accelerometer + E (Nunchuk)\n");
+            d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_NUNCHUK_ACCEL;
+        } else {
+            // Request Core buttons + extension (nunchuk)
+            report_type = WIIPROTO_REQ_DRM_KE;
+            logi("Wii: requesting Core buttons + E (Nunchuk)\n");
+            d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_NUNCHUK;
+        }
+    } else {
+        if (accel) {
+            // Request Core buttons + accel
+            report_type = WIIPROTO_REQ_DRM_KA;
+            logi("Wii: requesting Core buttons + Accelerometer\n");
+        } else {
+            report_type = WIIPROTO_REQ_DRM_K;
+            logi("Wii: requesting Core buttons\n");
+        }
+        if (ins->mode == WII_MODE_ACCEL)
+            d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_ACCEL;
+        else if (ins->mode == WII_MODE_VERTICAL)
+            d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_VERTICAL;
+        else
+            d->controller_subtype = CONTROLLER_SUBTYPE_WIIMOTE_HORIZONTAL;
+    }
+
+    uint8_t report[] = {0xa2, WIIPROTO_REQ_DRM, 0x00, report_type};
+    uni_hid_device_send_intr_report(d, report, sizeof(report));
+}
+
 static void wii_read_mem(uni_hid_device_t* d, wii_read_type_t t, uint32_t offset, uint16_t size) {
     logi("****** read_mem: offset=0x%04x, size=%d from=%d\n", offset, size, t);
     uint8_t report[] = {
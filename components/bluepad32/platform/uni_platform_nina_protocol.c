@@ -0,0 +1,953 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2020 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+// NINA / AirLift protocol: request handlers and the data that is sent to the host.
+// The transport (SPI-slave on ESP32) is in uni_platform_nina.c.
+
+// Logic based on Adafruit NINA-fw code: https://github.com/adafruit/nina-fw
+
+#include "platform/uni_platform_nina_protocol.h"
+
+#include <string.h>
+
+#include <btstack_util.h>
+
+#include "sdkconfig.h"
+
+#include "bt/uni_bt.h"
+#include "controller/uni_controller.h"
+#include "uni_common.h"
+#include "uni_log.h"
+#include "uni_version.h"
+
+enum {
+    NINA_CONTROLLER_INVALID = -1,
+};
+
+typedef struct __attribute__((packed)) {
+    // Usage Page: 0x01 (Generic Desktop Controls)
+    uint8_t dpad;
+    int32_t axis_x;
+    int32_t axis_y;
+    int32_t axis_rx;
+    int32_t axis_ry;
+
+    // Usage Page: 0x02 (Sim controls)
+    int32_t brake;
+    int32_t throttle;
+
+    // Usage Page: 0x09 (Button)
+    uint16_t buttons;
+
+    // Misc buttons (from 0x0c (Consumer) and others)
+    uint8_t misc_buttons;
+
+    // Gyro / Accel
+    int32_t gyro[3];
+    int32_t accel[3];
+} nina_gamepad_t;
+
+typedef struct __attribute__((packed)) {
+    int32_t delta_x;
+    int32_t delta_y;
+    uint8_t buttons;
+    uint8_t misc_buttons;
+    int8_t scroll_wheel;
+} nina_mouse_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t tr;      // Top right
+    uint16_t br;      // Bottom right
+    uint16_t tl;      // Top left
+    uint16_t bl;      // Bottom left
+    int temperature;  // Temperature
+} nina_balance_board_t;
+
+enum {
+    CONTROLLER_CLASS_NONE,
+    CONTROLLER_CLASS_GAMEPAD,
+    CONTROLLER_CLASS_MOUSE,
+    CONTROLLER_CLASS_KEYBOARD,
+    CONTROLLER_CLASS_BALANCE_BOARD,
+};
+
+typedef struct __attribute__((packed)) {
+    int8_t idx;
+    // Class of controller: gamepad, mouse, balance, etc.
+    uint8_t klass;
+    union {
+        nina_gamepad_t gamepad;
+        nina_mouse_t mouse;
+        nina_balance_board_t balance;
+    };
+    uint8_t battery;
+} nina_controller_t;
+
+enum {
+    PROPERTY_FLAG_RUMBLE = BIT(0),
+    PROPERTY_FLAG_PLAYER_LEDS = BIT(1),
+    PROPERTY_FLAG_PLAYER_LIGHTBAR = BIT(2),
+
+    PROPERTY_FLAG_BALANCE_BOARD = BIT(12),
+    PROPERTY_FLAG_GAMEPAD = BIT(13),
+    PROPERTY_FLAG_MOUSE = BIT(14),
+    PROPERTY_FLAG_KEYBOARD = BIT(15),
+};
+
+// This is sent via the wire. Adding new properties at the end Ok.
+// If so, update Protocol version.
+typedef struct __attribute__((packed)) {
+    uint8_t idx;          // Device index
+    uint8_t btaddr[6];    // BT Addr
+    uint8_t type;         // model: copy from nina_gamepad_t
+    uint8_t subtype;      // subtype. E.g: Wii Remote 2nd version
+    uint16_t vendor_id;   // VID
+    uint16_t product_id;  // PID
+    uint16_t flags;       // Features like Rumble, LEDs, etc.
+} nina_controller_properties_t;
+
+//
+// Globals
+//
+#ifdef CONFIG_BLUEPAD32_PLATFORM_AIRLIFT
+static const char FIRMWARE_VERSION[] = "Bluepad32 for AirLift v" UNI_VERSION;
+#elif defined(CONFIG_BLUEPAD32_PLATFORM_NINA)
+static const char FIRMWARE_VERSION[] = "Bluepad32 for NINA v" UNI_VERSION;
+#else
+// FIXME: This file should not be compiled when NINA/AirLift is not used.
+static const char FIRMWARE_VERSION[] = "";
+#endif
+
+static const uni_nina_protocol_ops_t* _ops;
+static nina_controller_t _controllers[CONFIG_BLUEPAD32_MAX_DEVICES];
+static nina_controller_properties_t _controllers_properties[CONFIG_BLUEPAD32_MAX_DEVICES];
+static volatile uni_gamepad_seat_t _gamepad_seats;
+
+// Negotiated with the host with "request_set_protocol_features".
+enum {
+    PROTOCOL_FEATURE_DATA_AVAILABLE_GPIO = BIT(0),
+};
+#define PROTOCOL_FEATURES_SUPPORTED (PROTOCOL_FEATURE_DATA_AVAILABLE_GPIO)
+
+// When push mode is enabled, this GPIO goes LOW when new controller data is
+// available, and goes back HIGH once the host reads it.
+// Uses the same polarity as the READY GPIO.
+static volatile int8_t _data_available_gpio = -1;
+
+// NINA-fw commands. Taken from:
+// https://github.com/arduino-libraries/WiFiNINA/blob/master/src/utility/wifi_spi.h
+// https://github.com/adafruit/Adafruit_CircuitPython_ESP32SPI/blob/master/adafruit_esp32spi/adafruit_esp32spi.py
+enum {
+    CMD_START = 0xe0,
+    CMD_END = 0xee,
+    CMD_ERR = 0xef,
+    CMD_REPLY_FLAG = BIT(7),
+};
+
+// Possible answers when the request doesn't need an answer, like in "set_xxx".
+enum {
+    RESPONSE_ERROR = 0,
+    RESPONSE_OK = 1,
+};
+
+#define PROTOCOL_VERSION_HI 0x01
+#define PROTOCOL_VERSION_LO 0x06
+
+// Should be called with the lock taken
+static void set_data_available_locked(bool available) {
+    if (_data_available_gpio < 0)
+        return;
+    _ops->digital_write(_data_available_gpio, available ? 0 : 1);
+}
+
+// Command 0x00
+static int request_protocol_version(const uint8_t command[], int command_len, uint8_t response[]) {
+    response[2] = 1;  // Number of parameters
+    response[3] = 2;  // Param len
+    response[4] = PROTOCOL_VERSION_HI;
+    response[5] = PROTOCOL_VERSION_LO;
+
+    return 6;
+}
+
+// Command 0x01
+static int request_gamepads_data(const uint8_t command[], int command_len, uint8_t response[]) {
+    // Returned struct:
+    // --- generic to all requests
+    // byte 2: number of parameters (contains the number of gamepads)
+    //      3: param len (sizeof(_gamepads[0])
+    //      4: gamepad N data
+
+    _ops->lock();
+
+    int total_controllers = 0;
+    int offset = 3;
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        if (_gamepad_seats & BIT(i)) {
+            total_controllers++;
+            // Update param len
+            // +1 is for the "idx" field
+            response[offset] = sizeof(_controllers[0].gamepad) + 1;
+            // Update param (data)
+            response[offset + 1] = _controllers[i].idx;
+            memcpy(&response[offset + 2], &_controllers[i].gamepad, sizeof(_controllers[0].gamepad));
+            // +1 for len
+            // +1 for idx
+            offset += sizeof(_controllers[0].gamepad) + 1 + 1;
+        }
+    }
+
+    response[2] = total_controllers;  // total params
+
+    _ops->unlock();
+
+    // "offset" has the total length
+    return offset;
+}
+
+// Command 0x02
+static int request_set_gamepad_player_leds(const uint8_t command[], int command_len, uint8_t response[]) {
+    // command[2]: total params
+    // command[3]: param len
+    int idx = command[4];
+    // command[5]: param len
+    // command[6]: leds
+
+    if (idx < 0 || idx >= CONFIG_BLUEPAD32_MAX_DEVICES) {
+        response[2] = 1;  // total params
+        response[3] = 1;  // param len
+        response[4] = RESPONSE_ERROR;
+
+        return 5;
+    }
+
+    uni_nina_pending_request_t request = (uni_nina_pending_request_t){
+        .controller_idx = idx,
+        .cmd = UNI_NINA_PENDING_REQUEST_CMD_PLAYER_LEDS,
+        .args[0] = command[6],
+    };
+    _ops->queue_pending_request(&request);
+
+    // TODO: We really don't know whether this request will succeed
+    response[2] = 1;  // Number of parameters
+    response[3] = 1;  // Lenghts of each parameter
+    response[4] = RESPONSE_OK;
+
+    return 5;
+}
+
+// Command 0x03
+static int request_set_gamepad_color_led(const uint8_t command[], int command_len, uint8_t response[]) {
+    // command[2]: total params
+    // command[3]: param len
+    int idx = command[4];
+    // command[5]: param len
+    // command[6-8]: RGB
+
+    if (idx < 0 || idx >= CONFIG_BLUEPAD32_MAX_DEVICES) {
+        response[2] = 1;  // total params
+        response[3] = 1;  // param len
+        response[4] = RESPONSE_ERROR;
+
+        return 5;
+    }
+
+    uni_nina_pending_request_t request = (uni_nina_pending_request_t){
+        .controller_idx = idx,
+        .cmd = UNI_NINA_PENDING_REQUEST_CMD_LIGHTBAR_COLOR,
+        .args[0] = command[6],
+        .args[1] = command[7],
+        .args[2] = command[8],
+    };
+    _ops->queue_pending_request(&request);
+
+    // TODO: We really don't know whether this request will succeed
+    response[2] = 1;  // Number of parameters
+    response[3] = 1;  // Lenghts of each parameter
+    response[4] = RESPONSE_OK;
+
+    return 5;
+}
+
+// Command 0x04
+static int request_set_gamepad_rumble(const uint8_t command[], int command_len, uint8_t response[]) {
+    // command[2]: total params
+    // command[3]: param len
+    int idx = command[4];
+    // command[5]: param len
+    // command[6,7]: force, duration
+
+    if (idx < 0 || idx >= CONFIG_BLUEPAD32_MAX_DEVICES) {
+        response[2] = 1;  // total params
+        response[3] = 1;  // param len
+        response[4] = RESPONSE_ERROR;
+
+        return 5;
+    }
+
+    uni_nina_pending_request_t request = (uni_nina_pending_request_t){
+        .controller_idx = idx,
+        .cmd = UNI_NINA_PENDING_REQUEST_CMD_RUMBLE,
+        .args[0] = command[6],
+        .args[1] = command[7],
+    };
+    _ops->queue_pending_request(&request);
+
+    // TODO: We really don't know whether this request will succeed
+    response[2] = 1;  // Number of parameters
+    response[3] = 1;  // Param len
+    response[4] = RESPONSE_OK;
+
+    return 5;
+}
+
+// Command 0x05
+static int request_forget_bluetooth_keys(const uint8_t command[], int command_len, uint8_t response[]) {
+    response[2] = 1;  // Number of parameters
+    response[3] = 1;  // Param len
+    response[4] = RESPONSE_OK;
+
+    uni_bt_del_keys_safe();
+    return 5;
+}
+
+// Command 0x06
+static int request_get_gamepad_properties(const uint8_t command[], int command_len, uint8_t response[]) {
+    // command[2]: total params
+    // command[3]: param len
+    int idx = command[4];
+
+    if (idx < 0 || idx >= CONFIG_BLUEPAD32_MAX_DEVICES) {
+        // To be consistent with the "OK" case, we return 2 parameters on "Error".
+        response[2] = 2;  // Number of parameters
+        response[3] = 1;  // Param len
+        response[4] = RESPONSE_ERROR;
+        response[5] = 1;  // Param len
+        response[6] = 0;  // Ignore
+        return 7;
+    };
+
+    response[2] = 2;                                   // Number of parameters
+    response[3] = 1;                                   // Param len
+    response[4] = RESPONSE_OK;                         // Ok
+    response[5] = sizeof(_controllers_properties[0]);  // Param len
+
+    // Response buffer is not cleared between requests.
+    memset(&response[6], 0, sizeof(nina_controller_properties_t));
+
+    _ops->lock();
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        if (_controllers_properties[i].idx == idx) {
+            memcpy(&response[6], &_controllers_properties[i], sizeof(_controllers_properties[0]));
+            break;
+        }
+    }
+    _ops->unlock();
+
+    return 6 + sizeof(nina_controller_properties_t);
+}
+
+// Command 0x07
+static int request_enable_bluetooth_connections(const uint8_t command[], int command_len, uint8_t response[]) {
+    bool enabled = command[4];
+    uni_bt_enable_new_connections_safe(enabled);
+
+    response[2] = 1;  // total params
+    response[3] = 1;  // param len
+    response[4] = RESPONSE_OK;
+
+    return 5;
+}
+
+// Command 0x08
+static int request_disconnect_gamepad(const uint8_t command[], int command_len, uint8_t response[]) {
+    // command[2]: total params
+    // command[3]: param len
+    int idx = command[4];
+    uint8_t ret = RESPONSE_OK;
+
+    if (idx < 0 || idx >= CONFIG_BLUEPAD32_MAX_DEVICES) {
+        ret = RESPONSE_ERROR;
+        goto exit;
+    }
+
+    uni_nina_pending_request_t request = (uni_nina_pending_request_t){
+        .controller_idx = idx,
+        .cmd = UNI_NINA_PENDING_REQUEST_CMD_DISCONNECT,
+    };
+    _ops->queue_pending_request(&request);
+
+exit:
+    response[2] = 1;  // total params
+    response[3] = 1;  // param len
+    response[4] = ret;
+    return 5;
+}
+
+// Command 0x09
+static int request_controllers_data(const uint8_t command[], int command_len, uint8_t response[]) {
+    // Returned struct:
+    // --- generic to all requests
+    // byte 2: number of parameters (contains the number of controllers)
+    //      3: param len (sizeof(_controllers[0])
+    //      4: gamepad N data
+
+    _ops->lock();
+
+    int total_controllers = 0;
+    int offset = 3;
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        if (_gamepad_seats & BIT(i)) {
+            total_controllers++;
+            // Update param len
+            response[offset] = sizeof(_controllers[0]);
+            // Update param (data)
+            memcpy(&response[offset + 1], &_controllers[i], sizeof(_controllers[0]));
+            offset += sizeof(_controllers[0]) + 1;
+        }
+    }
+
+    response[2] = total_controllers;  // total params
+
+    // Host has the latest data
+    set_data_available_locked(false);
+
+    _ops->unlock();
+
+    // "offset" has the total length
+    return offset;
+}
+
+// Command 0x0a
+static int request_set_protocol_features(const uint8_t command[], int command_len, uint8_t response[]) {
+    // command[2]: total params, should be 3
+    // command[3]: param len, should be 2
+    // command[4,5]: host protocol version, hi / lo
+    // command[6]: param len, should be 1
+    // command[7]: features
+    // command[8]: param len, should be 1
+    // command[9]: data available GPIO
+    // command[10]: CMD_END
+    if (command_len < 11 || command[2] != 3 || command[3] != 2 || command[6] != 1 || command[8] != 1)
+        return 0;
+
+    uint8_t features = command[7];
+    uint8_t gpio = command[9];
+    uint8_t ret = RESPONSE_OK;
+
+    features &= PROTOCOL_FEATURES_SUPPORTED;
+
+    _ops->lock();
+    if (_data_available_gpio >= 0) {
+        // Leave the previous pin "not available"
+        _ops->digital_write(_data_available_gpio, 1);
+        _data_available_gpio = -1;
+    }
+    if ((features & PROTOCOL_FEATURE_DATA_AVAILABLE_GPIO) && !_ops->reserve_data_available_gpio(gpio)) {
+        features &= ~PROTOCOL_FEATURE_DATA_AVAILABLE_GPIO;
+        ret = RESPONSE_ERROR;
+    }
+    if (features & PROTOCOL_FEATURE_DATA_AVAILABLE_GPIO) {
+        _data_available_gpio = gpio;
+        // Report the current state so that the host can do the initial read
+        set_data_available_locked(_gamepad_seats != 0);
+    }
+    _ops->unlock();
+
+    logi("NINA: Host protocol v%d.%d, features: %#x\n", command[4], command[5], features);
+
+    response[2] = 3;  // Number of parameters
+    response[3] = 1;  // Param len
+    response[4] = ret;
+    response[5] = 2;  // Param len
+    response[6] = PROTOCOL_VERSION_HI;
+    response[7] = PROTOCOL_VERSION_LO;
+    response[8] = 1;  // Param len
+    response[9] = features;
+
+    return 10;
+}
+
+// Command 0x0b
+// Forward declaration, since batched commands are dispatched with "command_handlers".
+static int request_batch(const uint8_t command[], int command_len, uint8_t response[]);
+
+// Command 0x1a
+static int request_set_debug(const uint8_t command[], int command_len, uint8_t response[]) {
+    // Since v4.0, this feature is not supported anymore. Cannot enable/disable output in runtime
+    // This is to simplify how the console is initialized.
+    //    uni_uart_enable_output(command[4]);
+    response[2] = 1;           // total params
+    response[3] = 1;           // param len
+    response[4] = command[4];  // return the value requested
+
+    return 5;
+}
+
+// Command 0x20
+// This is to make the default "CheckFirmwareVersion" sketch happy.
+// Taken from wl_definitions.h
+// See:
+// https://github.com/arduino-libraries/WiFiNINA/blob/master/src/utility/wl_definitions.h
+enum { WL_IDLE_STATUS = 0 };
+
+static int request_get_conn_status(const uint8_t command[], int command_len, uint8_t response[]) {
+    response[2] = 1;  // total params
+    response[3] = 1;  // param len
+    response[4] = WL_IDLE_STATUS;
+
+    return 5;
+}
+
+// Command 0x22
+static int request_get_mac_address(const uint8_t command[], int command_len, uint8_t response[]) {
+    bd_addr_t bt_addr;
+
+    uni_bt_get_local_bd_addr_safe(bt_addr);
+
+    response[2] = 1;            // Number of parameters
+    response[3] = BD_ADDR_LEN;  // Parameter 1 length
+
+    memcpy(&response[4], bt_addr, BD_ADDR_LEN);
+
+    return 4 + BD_ADDR_LEN;
+}
+
+// Command 0x37
+static int request_get_fw_version(const uint8_t command[], int command_len, uint8_t response[]) {
+    response[2] = 1;                         // Number of parameters
+    response[3] = sizeof(FIRMWARE_VERSION);  // Parameter 1 length
+
+    memcpy(&response[4], FIRMWARE_VERSION, sizeof(FIRMWARE_VERSION));
+
+    return 4 + sizeof(FIRMWARE_VERSION);
+}
+
+// Command 0x50
+static int request_set_pin_mode(const uint8_t command[], int command_len, uint8_t response[]) {
+    // command[2]: total params, should be 2
+    // command[3]: param len, should be 1
+    uint8_t pin = command[4];
+    // command[5]: param 2 len: should be 1
+    uint8_t mode = command[6];
+
+    response[2] = 1;  // number of parameters
+    response[3] = 1;  // parameter 1 length
+    response[4] = _ops->set_pin_mode(pin, mode) ? RESPONSE_OK : RESPONSE_ERROR;
+    return 5;
+}
+
+// Command 0x51
+static int request_digital_write(const uint8_t command[], int command_len, uint8_t response[]) {
+    // command[2]: total params, should be 2
+    // command[3]: param len, should be 1
+    uint8_t pin = command[4];
+    // command[5]: param len, should be 1
+    uint8_t value = !!command[6];
+
+    response[2] = 1;  // total parameters
+    response[3] = 1;  // param len
+    response[4] = _ops->digital_write(pin, value) ? RESPONSE_OK : RESPONSE_ERROR;
+    return 5;
+}
+
+// Command 0x52
+static int request_analog_write(const uint8_t command[], int command_len, uint8_t response[]) {
+    // command[2]: total params, should be 2
+    // command[3]: param len, should be 1
+    uint8_t pin = command[4];
+    // command[5]: param len, should be 1
+    uint8_t value = command[6];
+
+    response[2] = 1;  // total parameters
+    response[3] = 1;  // param len
+    response[4] = _ops->analog_write(pin, value) ? RESPONSE_OK : RESPONSE_ERROR;
+    return 5;
+}
+
+// Command 0x53
+static int request_digital_read(const uint8_t command[], int command_len, uint8_t response[]) {
+    // TODO: Not possible to return an error
+    // command[2]: total params, should be 1
+    // command[3]: param len, should be 1
+    uint8_t pin = command[4];
+    uint8_t value = _ops->digital_read(pin);
+
+    response[2] = 1;      // number of parameters
+    response[3] = 1;      // parameter 1 length
+    response[4] = value;  // response
+    return 5;
+}
+
+// Command 0x54
+static int request_analog_read(const uint8_t command[], int command_len, uint8_t response[]) {
+    // TODO: Not possible to return an error
+    // command[2]: total params, should be 1
+    // command[3]: param len, should be 1
+    uint8_t pin = command[4];
+    uint16_t value = _ops->analog_read(pin);
+
+    response[2] = 1;             // number of parameters
+    response[3] = 2;             // parameter 1 length
+    response[4] = value & 0xff;  // response
+    response[5] = value >> 8;    // response
+    return 6;
+}
+
+typedef int (*command_handler_t)(const uint8_t command[], int command_len, uint8_t response[] /* out */);
+
+static const command_handler_t command_handlers[] = {
+    // 0x00 -> 0x0f: Bluepad32 own extensions
+    // These 16 entries are NULL in NINA. Perhaps they are reserved for future
+    // use? Seems to be safe to use them for Bluepad32 commands.
+    request_protocol_version,
+    request_gamepads_data,                 // data
+    request_set_gamepad_player_leds,       // the 4 LEDs that is available in many gamepads.
+    request_set_gamepad_color_led,         // available on DS4, DualSense
+    request_set_gamepad_rumble,            // available on DS4, Xbox, Switch, etc.
+    request_forget_bluetooth_keys,         // forget stored Bluetooth keys
+    request_get_gamepad_properties,        // get gamepad properties like BTAddr, VID/PID, etc.
+    request_enable_bluetooth_connections,  // Enable/Disable bluetooth connection
+    request_disconnect_gamepad,            // Disconnect gamepad
+    request_controllers_data,              // Gamepad, Mouse, Balance. Deprecates request_gamepads_data
+    request_set_protocol_features,         // Negotiate optional features, like the "data available" GPIO
+    request_batch,                         // Several "set" commands in one frame
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+
+    // 0x10 -> 0x1f
+    NULL,  // setNet
+    NULL,  // setPassPhrase,
+    NULL,  // setKey,
+    NULL,
+    NULL,               // setIPconfig,
+    NULL,               // setDNSconfig,
+    NULL,               // setHostname,
+    NULL,               // setPowerMode,
+    NULL,               // setApNet,
+    NULL,               // setApPassPhrase,
+    request_set_debug,  // setDebug (0x1a)
+    NULL,               // getTemperature,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+
+    // 0x20 -> 0x2f
+    request_get_conn_status,  // getConnStatus (0x20)
+    NULL,                     // getIPaddr,
+    request_get_mac_address,  // getMACaddr,
+    NULL,                     // getCurrSSID,
+    NULL,                     // getCurrBSSID,
+    NULL,                     // getCurrRSSI,
+    NULL,                     // getCurrEnct,
+    NULL,                     // scanNetworks,
+    NULL,                     // startServerTcp,
+    NULL,                     // getStateTcp,
+    NULL,                     // dataSentTcp,
+    NULL,                     // availDataTcp,
+    NULL,                     // getDataTcp,
+    NULL,                     // startClientTcp,
+    NULL,                     // stopClientTcp,
+    NULL,                     // getClientStateTcp,
+
+    // 0x30 -> 0x3f
+    NULL,  // disconnect,
+    NULL,
+    NULL,                    // getIdxRSSI,
+    NULL,                    // getIdxEnct,
+    NULL,                    // reqHostByName,
+    NULL,                    // getHostByName,
+    NULL,                    // startScanNetworks,
+    request_get_fw_version,  // getFwVersion (0x37)
+    NULL,
+    NULL,  // sendUDPdata,
+    NULL,  // getRemoteData,
+    NULL,  // getTime,
+    NULL,  // getIdxBSSID,
+    NULL,  // getIdxChannel,
+    NULL,  // ping,
+    NULL,  // getSocket,
+
+    // 0x40 -> 0x4f
+    NULL,  // setClientCert,
+    NULL,  // setCertKey,
+    NULL,
+    NULL,
+    NULL,  // sendDataTcp,
+    NULL,  // getDataBufTcp,
+    NULL,  // insertDataBuf,
+    NULL,
+    NULL,
+    NULL,
+    NULL,  // wpa2EntSetIdentity,
+    NULL,  // wpa2EntSetUsername,
+    NULL,  // wpa2EntSetPassword,
+    NULL,  // wpa2EntSetCACert,
+    NULL,  // wpa2EntSetCertKey,
+    NULL,  // wpa2EntEnable,
+
+    // 0x50 -> 0x5f
+    request_set_pin_mode,   // setPinMode,
+    request_digital_write,  // setDigitalWrite,
+    request_analog_write,   // setAnalogWrite,
+    request_digital_read,   // setDigitalRead,
+    request_analog_read,    // setAnalogRead,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+
+    // 0x60 -> 0x6f
+    NULL,  // writeFile,
+    NULL,  // readFile,
+    NULL,  // deleteFile,
+    NULL,  // existsFile,
+    NULL,  // downloadFile,
+    NULL,  // applyOTA,
+    NULL,  // renameFile,
+    NULL,  // downloadOTA,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+};
+#define COMMAND_HANDLERS_MAX (sizeof(command_handlers) / sizeof(command_handlers[0]))
+
+// Commands that can be part of a batch.
+// All of them return one parameter of 1 byte with the status.
+static bool is_batchable_command(uint8_t cmd) {
+    switch (cmd) {
+        case 0x02:  // request_set_gamepad_player_leds
+        case 0x03:  // request_set_gamepad_color_led
+        case 0x04:  // request_set_gamepad_rumble
+        case 0x07:  // request_enable_bluetooth_connections
+        case 0x08:  // request_disconnect_gamepad
+        case 0x50:  // request_set_pin_mode
+        case 0x51:  // request_digital_write
+        case 0x52:  // request_analog_write
+            return true;
+        default:
+            return false;
+    }
+}
+
+static int request_batch(const uint8_t command[], int command_len, uint8_t response[]) {
+    // Each parameter is a sub-command, without the START / END bytes:
+    // command[2]: total params (number of sub-commands)
+    // command[3]: param len
+    // command[4]: sub-command
+    // command[5]: sub-command total params
+    // command[6]: sub-command param len
+    // ...
+    //
+    // Response has one parameter for each sub-command:
+    // response[N]: param len, always 2
+    // response[N+1]: sub-command
+    // response[N+2]: status
+    uint8_t sub_command[UNI_NINA_PROTOCOL_BUFFER_LEN];
+    uint8_t sub_response[UNI_NINA_PROTOCOL_BUFFER_LEN];
+
+    int total = command[2];
+    int offset = 3;
+    int response_offset = 3;
+
+    // Validate the whole frame before running any sub-command. Bytes past "command_len"
+    // might be from a previous request.
+    for (int i = 0; i < total; i++) {
+        if (offset >= command_len)
+            return 0;
+        int len = command[offset];
+        // +1 for the "param len" in the command, and +1 for the CMD_END in the response
+        if (len < 2 || offset + 1 + len > command_len || response_offset + 3 + 1 > UNI_NINA_PROTOCOL_BUFFER_LEN)
+            return 0;
+        offset += 1 + len;
+        response_offset += 3;
+    }
+    if (offset >= command_len || command[offset] != CMD_END)
+        return 0;
+
+    offset = 3;
+    response_offset = 3;
+    for (int i = 0; i < total; i++) {
+        int len = command[offset];
+        uint8_t cmd = command[offset + 1];
+        uint8_t status = RESPONSE_ERROR;
+
+        if (is_batchable_command(cmd)) {
+            // Rebuild a "standalone" command so that the handlers can parse it
+            memset(sub_command, 0, UNI_NINA_PROTOCOL_COMMAND_MIN_LEN);
+            sub_command[0] = command[0];
+            memcpy(&sub_command[1], &command[offset + 1], len);
+            if (command_handlers[cmd](sub_command, 1 + len, sub_response) > 4)
+                status = sub_response[4];
+        }
+
+        response[response_offset] = 2;  // Param len
+        response[response_offset + 1] = cmd;
+        response[response_offset + 2] = status;
+        response_offset += 3;
+
+        offset += 1 + len;
+    }
+
+    response[2] = total;  // Number of parameters
+    return response_offset;
+}
+
+int uni_nina_protocol_process_request(const uint8_t command[], int command_len, uint8_t response[] /* out */) {
+    int response_len = 0;
+    /* Cmd Struct Message, from:
+    https://github.com/arduino-libraries/WiFiNINA/blob/master/src/utility/spi_drv.cpp
+     ________________________________________________________________________
+    | START CMD | C/R  | CMD  | N.PARAM | PARAM LEN | PARAM  | .. | END CMD |
+    |___________|______|______|_________|___________|________|____|_________|
+    |   8 bit   | 1bit | 7bit |  8bit   |   8bit    | nbytes | .. |   8bit  |
+    |___________|______|______|_________|___________|________|____|_________|
+    */
+
+    if (command_len >= 2 && command[0] == CMD_START && command[1] < COMMAND_HANDLERS_MAX) {
+        command_handler_t command_handler = command_handlers[command[1]];
+
+        if (command_handler) {
+            // To make the code "compatible", we pass "command" to all the request
+            // handlers. On an ideal world, we should pass &command[2] instead.
+            response_len = command_handler(command, command_len, response);
+        }
+    }
+
+    if (response_len <= 0) {
+        loge("NINA: Error in request:\n");
+        printf_hexdump(command, command_len);
+        // Response for invalid requests
+        response[0] = CMD_ERR;
+        response[1] = 0x00;
+        response[2] = CMD_END;
+
+        response_len = 3;
+    } else {
+        response[0] = CMD_START;
+        response[1] = (command[1] | CMD_REPLY_FLAG);
+
+        // Add extra byte to indicate end of command
+        response[response_len] = CMD_END;
+        response_len++;
+    }
+
+    return response_len;
+}
+
+//
+// Controller state
+// Called from the Bluetooth thread
+//
+
+uint8_t uni_nina_protocol_get_seats(void) {
+    return _gamepad_seats;
+}
+
+void uni_nina_protocol_on_controller_ready(int idx, uni_hid_device_t* d) {
+    // This is how "client" knows which gamepad emitted the events.
+    _controllers[idx].idx = idx;
+
+    // FIXME: To save RAM gamepad_properties should be updated at "request time".
+    // It requires to add a mutex in uni_hid_device, and that has its own issues.
+    // As a quick hack, it is easier to copy them now.
+    _controllers_properties[idx].idx = idx;
+    _controllers_properties[idx].type = d->controller_type;
+    _controllers_properties[idx].subtype = d->controller_subtype;
+    _controllers_properties[idx].vendor_id = d->vendor_id;
+    _controllers_properties[idx].product_id = d->product_id;
+    _controllers_properties[idx].flags = (d->report_parser.set_player_leds ? PROPERTY_FLAG_PLAYER_LEDS : 0) |
+                                         (d->report_parser.play_dual_rumble ? PROPERTY_FLAG_RUMBLE : 0) |
+                                         (d->report_parser.set_lightbar_color ? PROPERTY_FLAG_PLAYER_LIGHTBAR : 0);
+
+    // TODO: Most probably a device cannot be a mouse a keyboard and a gamepad at the same time,
+    // and 2 bits should be more than enough.
+    // But for simplicity, let's use one bit for each category.
+    if (uni_hid_device_is_mouse(d))
+        _controllers_properties[idx].flags |= PROPERTY_FLAG_MOUSE;
+
+    if (uni_hid_device_is_keyboard(d))
+        _controllers_properties[idx].flags |= PROPERTY_FLAG_KEYBOARD;
+
+    if (uni_hid_device_is_gamepad(d))
+        _controllers_properties[idx].flags |= PROPERTY_FLAG_GAMEPAD;
+
+    memcpy(_controllers_properties[idx].btaddr, d->conn.btaddr, sizeof(_controllers_properties[0].btaddr));
+
+    _gamepad_seats |= BIT(idx);
+}
+
+void uni_nina_protocol_on_controller_disconnected(int idx) {
+    _gamepad_seats &= ~BIT(idx);
+
+    _ops->lock();
+    memset(&_controllers[idx], 0, sizeof(_controllers[0]));
+    _controllers[idx].idx = NINA_CONTROLLER_INVALID;
+    set_data_available_locked(true);
+    _ops->unlock();
+
+    memset(&_controllers_properties[idx], 0, sizeof(_controllers_properties[0]));
+    _controllers_properties[idx].idx = NINA_CONTROLLER_INVALID;
+}
+
+void uni_nina_protocol_on_controller_data(int idx, const uni_controller_t* ctl) {
+    // Populate gamepad data on shared struct.
+    nina_controller_t* controller = &_controllers[idx];
+    _ops->lock();
+    nina_controller_t prev = *controller;
+    switch (ctl->klass) {
+        case UNI_CONTROLLER_CLASS_GAMEPAD:
+            controller->gamepad.dpad = ctl->gamepad.dpad;
+            controller->gamepad.axis_x = ctl->gamepad.axis_x;
+            controller->gamepad.axis_y = ctl->gamepad.axis_y;
+            controller->gamepad.axis_rx = ctl->gamepad.axis_rx;
+            controller->gamepad.axis_ry = ctl->gamepad.axis_ry;
+            controller->gamepad.brake = ctl->gamepad.brake;
+            controller->gamepad.throttle = ctl->gamepad.throttle;
+            controller->gamepad.buttons = ctl->gamepad.buttons;
+            controller->gamepad.misc_buttons = ctl->gamepad.misc_buttons;
+            memcpy(controller->gamepad.gyro, ctl->gamepad.gyro, sizeof(ctl->gamepad.gyro));
+            memcpy(controller->gamepad.accel, ctl->gamepad.accel, sizeof(ctl->gamepad.accel));
+            break;
+        case UNI_CONTROLLER_CLASS_MOUSE:
+            controller->mouse.delta_x = ctl->mouse.delta_x;
+            controller->mouse.delta_y = ctl->mouse.delta_y;
+            controller->mouse.buttons = ctl->mouse.buttons;
+            controller->mouse.misc_buttons = ctl->mouse.misc_buttons;
+            controller->mouse.scroll_wheel = ctl->mouse.scroll_wheel;
+            break;
+        case UNI_CONTROLLER_CLASS_BALANCE_BOARD:
+            break;
+        default:
+            break;
+    }
+
+    controller->klass = ctl->klass;
+    controller->battery = ctl->battery;
+
+    // Only wake up the host when something changed
+    if (memcmp(&prev, controller, sizeof(prev)) != 0)
+        set_data_available_locked(true);
+
+    _ops->unlock();
+}
+
+void uni_nina_protocol_init(const uni_nina_protocol_ops_t* ops) {
+    _ops = ops;
+}
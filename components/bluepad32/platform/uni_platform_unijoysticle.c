@@ -550,33 +550,6 @@ static bool test_gamepad_misc_button_pressed(uni_hid_device_t* d, uni_gamepad_t*
     return false;
 }
 
-static bool test_keyboard_key_pressed(uni_hid_device_t* d, uni_keyboard_t* kb, uint8_t usage_key, uint32_t key_mask) {
-    uni_platform_unijoysticle_instance_t* ins = uni_platform_unijoysticle_get_instance(d);
-    bool already_pressed = ins->debouncer & key_mask;
-    bool found = false;
-
-    // Only return true the first time it is pressed.
-    // Next time will occur when the button is released and pressed again.
-    for (int i = 0; i < UNI_KEYBOARD_PRESSED_KEYS_MAX; i++) {
-        // Assume not found if value is between 0 and 3, which are all errors.
-        if (kb->pressed_keys[i] < HID_USAGE_KB_ERROR_UNDEFINED)
-            break;
-        if (kb->pressed_keys[i] == usage_key) {
-            found = true;
-            break;
-        }
-    }
-    if (found) {
-        if (already_pressed)
-            return false;
-        ins->debouncer |= key_mask;
-        return true;
-    } else {
-        ins->debouncer &= ~key_mask;
-    }
-    return false;
-}
-
 static void test_gamepad_select_button(uni_hid_device_t* d, uni_gamepad_t* gp) {
     if (test_gamepad_misc_button_pressed(d, gp, MISC_BUTTON_SELECT))
         try_swap_ports(d);
@@ -587,20 +560,6 @@ static void test_gamepad_start_button(uni_hid_device_t* d, uni_gamepad_t* gp) {
         set_next_gamepad_mode(d);
 }
 
-static void test_keyboard_esc_key(uni_hid_device_t* d, uni_keyboard_t* kb) {
-    // FIXME: BUTTON_A should not be mapped to ESC.
-    // Define BIT constants for 32 keys (size of the bitmask)
-    if (test_keyboard_key_pressed(d, kb, HID_USAGE_KB_ESCAPE, BUTTON_A))
-        try_swap_ports(d);
-}
-
-static void test_keyboard_tab_key(uni_hid_device_t* d, uni_keyboard_t* kb) {
-    // FIXME: BUTTON_B should not be mapped to Tab.
-    // Define BIT constants for 32 keys (size of the bitmask)
-    if (test_keyboard_key_pressed(d, kb, HID_USAGE_KB_TAB, BUTTON_B))
-        set_next_gamepad_mode(d);
-}
-
 static void unijoysticle_on_controller_data(uni_hid_device_t* d, uni_controller_t* ctl) {
     if (d == NULL) {
         loge("ERROR: unijoysticle_on_device_gamepad_data: Invalid NULL device\n");
@@ -660,6 +619,11 @@ static void unijoysticle_on_oob_event(uni_platform_oob_event_t event, void* data
             try_swap_ports(d);
             break;
         }
+
+        case UNI_PLATFORM_OOB_LINK_QUALITY_LOW:
+            // Already logged by the link quality monitor. Nothing to show: the LEDs are used for the ports.
+            break;
+
         default:
             loge("ERROR: unijoysticle_on_device_oob_event: unsupported event: 0x%04x\n", event);
     }
@@ -1124,6 +1088,7 @@ static void process_balance_board(uni_hid_device_t* d, uni_balance_board_t* bb)
 static void process_keyboard(uni_hid_device_t* d, uni_keyboard_t* kb) {
     uni_platform_unijoysticle_instance_t* ins = uni_platform_unijoysticle_get_instance(d);
     uni_joystick_t joy, joy_ext;
+    uni_keyboard_event_t event;
     memset(&joy, 0, sizeof(joy));
     memset(&joy_ext, 0, sizeof(joy_ext));
 
@@ -1146,10 +1111,15 @@ static void process_keyboard(uni_hid_device_t* d, uni_keyboard_t* kb) {
             loge("Unijoysticle: Mode %d not supported with keyboard\n", ins->gamepad_mode);
     }
 
-    // Swap ?
-    test_keyboard_esc_key(d, kb);
-    // Change mode ?
-    test_keyboard_tab_key(d, kb);
+    // Once per key press. Esc: swap ports. Tab: change mode.
+    while (uni_keyboard_ring_peek(&d->key_events, &ins->key_events_cursor, &event, 1) == 1) {
+        if (!event.pressed)
+            continue;
+        if (event.key == HID_USAGE_KB_ESCAPE)
+            try_swap_ports(d);
+        else if (event.key == HID_USAGE_KB_TAB)
+            set_next_gamepad_mode(d);
+    }
 }
 
 static void set_gamepad_seat(uni_hid_device_t* d, uni_gamepad_seat_t seat) {
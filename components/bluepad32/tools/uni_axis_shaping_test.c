@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+// uni_axis_shaping test. Host only.
+// Compiles curves with uni_axis_shaping_compile() and checks the tables, and the sticks and pedals
+// after uni_axis_shaping_apply().
+//
+// Usage:
+//   uni_axis_shaping_test check    Runs the checks. Returns non-zero on failure.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "controller/uni_axis_shaping.h"
+#include "uni_property.h"
+
+static int failures;
+
+// The checks pass the shaping explicitly, so the global configuration, and the properties, are not used.
+void uni_property_set(uni_property_idx_t idx, uni_property_value_t value) {
+    ARG_UNUSED(idx);
+    ARG_UNUSED(value);
+}
+
+uni_property_value_t uni_property_get(uni_property_idx_t idx) {
+    uni_property_value_t val;
+
+    ARG_UNUSED(idx);
+    memset(&val, 0, sizeof(val));
+    return val;
+}
+
+static void expect(const char* name, int32_t got, int32_t want) {
+    if (got != want) {
+        printf("FAIL: %s: %d, want %d\n", name, got, want);
+        failures++;
+    }
+}
+
+static void expect_stick(const uni_axis_shaping_t* shaping,
+                         const char* name,
+                         int32_t x,
+                         int32_t y,
+                         int32_t want_x,
+                         int32_t want_y) {
+    uni_gamepad_t gp;
+
+    memset(&gp, 0, sizeof(gp));
+    gp.axis_x = x;
+    gp.axis_y = y;
+    gp.axis_rx = x;
+    gp.axis_ry = y;
+    uni_axis_shaping_apply(shaping, &gp);
+    if (gp.axis_x != want_x || gp.axis_y != want_y || gp.axis_rx != want_x || gp.axis_ry != want_y) {
+        printf("FAIL: %s: (%d,%d) -> (%d,%d) / (%d,%d), want (%d,%d)\n", name, x, y, gp.axis_x, gp.axis_y,
+               gp.axis_rx, gp.axis_ry, want_x, want_y);
+        failures++;
+    }
+}
+
+static int32_t apply_pedal(const uni_axis_shaping_t* shaping, int32_t v) {
+    uni_gamepad_t gp;
+
+    memset(&gp, 0, sizeof(gp));
+    gp.brake = v;
+    gp.throttle = v;
+    uni_axis_shaping_apply(shaping, &gp);
+    if (gp.brake != gp.throttle) {
+        printf("FAIL: pedal %d: brake %d != throttle %d\n", v, gp.brake, gp.throttle);
+        failures++;
+    }
+    return gp.brake;
+}
+
+static void check_deadzone(void) {
+    static uni_axis_shaping_t shaping;
+    uni_axis_shaping_config_t config;
+
+    memset(&config, 0, sizeof(config));
+    config.pedal.deadzone = 100;
+    config.pedal.anti_deadzone = 200;
+    config.stick = config.pedal;
+    uni_axis_shaping_compile(&config, &shaping);
+
+    expect("deadzone: linear", shaping.pedal_linear, false);
+    expect("deadzone: 0", apply_pedal(&shaping, 0), 0);
+    expect("deadzone: last zero", apply_pedal(&shaping, 100), 0);
+    expect("deadzone: first after the deadzone", apply_pedal(&shaping, 101), 200);
+    expect("deadzone: max", apply_pedal(&shaping, UNI_AXIS_SHAPING_MAX), UNI_AXIS_SHAPING_MAX);
+    expect("deadzone: out of range", apply_pedal(&shaping, 2000), UNI_AXIS_SHAPING_MAX);
+    expect("deadzone: negative", apply_pedal(&shaping, -5), 0);
+
+    for (int i = 1; i < UNI_AXIS_SHAPING_LUT_SIZE; i++) {
+        if (shaping.pedal[i] < shaping.pedal[i - 1]) {
+            printf("FAIL: deadzone: not monotonic at %d\n", i);
+            failures++;
+            break;
+        }
+    }
+
+    // Sticks: the deadzone is in curve units, about twice the stick units.
+    expect_stick(&shaping, "deadzone: stick inside", 50, 0, 0, 0);
+    expect_stick(&shaping, "deadzone: stick outside", 51, 0, 100, 0);
+}
+
+static void check_expo(void) {
+    static uni_axis_shaping_t shaping;
+    uni_axis_shaping_config_t config;
+
+    // Expo 0: identity, and nothing to apply.
+    memset(&config, 0, sizeof(config));
+    uni_axis_shaping_compile(&config, &shaping);
+    expect("expo 0: linear", shaping.pedal_linear && shaping.stick_linear, true);
+    for (int i = 0; i < UNI_AXIS_SHAPING_LUT_SIZE; i++) {
+        if (shaping.pedal[i] != i || shaping.stick[i] != i) {
+            printf("FAIL: expo 0: lut[%d] = %d / %d\n", i, shaping.pedal[i], shaping.stick[i]);
+            failures++;
+            break;
+        }
+    }
+    expect_stick(&shaping, "expo 0: stick", -512, 511, -512, 511);
+
+    // Expo max: cubic.
+    config.pedal.expo = UNI_AXIS_SHAPING_MAX;
+    uni_axis_shaping_compile(&config, &shaping);
+    expect("expo max: 0", apply_pedal(&shaping, 0), 0);
+    // 512^3 / MAX^2
+    expect("expo max: half", apply_pedal(&shaping, 512), 128);
+    expect("expo max: max", apply_pedal(&shaping, UNI_AXIS_SHAPING_MAX), UNI_AXIS_SHAPING_MAX);
+    for (int i = 1; i < UNI_AXIS_SHAPING_LUT_SIZE; i++) {
+        if (shaping.pedal[i] < shaping.pedal[i - 1] || shaping.pedal[i] > i) {
+            printf("FAIL: expo max: lut[%d] = %d\n", i, shaping.pedal[i]);
+            failures++;
+            break;
+        }
+    }
+
+    // Out of range: ignored, linear.
+    config.pedal.expo = UNI_AXIS_SHAPING_MAX + 1;
+    uni_axis_shaping_compile(&config, &shaping);
+    expect("expo invalid: linear", shaping.pedal_linear, true);
+}
+
+static void check_points(void) {
+    static uni_axis_shaping_t shaping;
+    uni_axis_shaping_config_t config;
+    char str[UNI_AXIS_SHAPING_POINTS_STR_LEN];
+
+    memset(&config, 0, sizeof(config));
+    expect("points: parse", uni_axis_shaping_parse_points("256:512,768:768", &config.pedal), true);
+    expect("points: num", config.pedal.num_points, 2);
+    uni_axis_shaping_format_points(&config.pedal, str);
+    if (strcmp(str, "256:512,768:768") != 0) {
+        printf("FAIL: points: format: '%s'\n", str);
+        failures++;
+    }
+    uni_axis_shaping_compile(&config, &shaping);
+
+    // Between the implicit (0,0), the points, and the implicit (MAX,MAX).
+    expect("points: 0", apply_pedal(&shaping, 0), 0);
+    expect("points: before the first", apply_pedal(&shaping, 128), 256);
+    expect("points: first", apply_pedal(&shaping, 256), 512);
+    expect("points: between", apply_pedal(&shaping, 512), 640);
+    expect("points: second", apply_pedal(&shaping, 768), 768);
+    expect("points: after the last", apply_pedal(&shaping, 896), 896);
+    expect("points: max", apply_pedal(&shaping, UNI_AXIS_SHAPING_MAX), UNI_AXIS_SHAPING_MAX);
+
+    // Invalid curves are rejected.
+    expect("points: unsorted", uni_axis_shaping_parse_points("500:10,400:20", &config.pedal), true);
+    uni_axis_shaping_compile(&config, &shaping);
+    expect("points: unsorted is linear", shaping.pedal_linear, true);
+    expect("points: x out of range", uni_axis_shaping_parse_points("1023:10", &config.pedal), false);
+    expect("points: bad format", uni_axis_shaping_parse_points("10-20", &config.pedal), false);
+}
+
+static void check_radial(void) {
+    static uni_axis_shaping_t shaping;
+    uni_axis_shaping_config_t config;
+
+    memset(&config, 0, sizeof(config));
+    config.stick.deadzone = 100;
+    config.stick.expo = UNI_AXIS_SHAPING_MAX / 2;
+    uni_axis_shaping_compile(&config, &shaping);
+
+    // Square gates: the corners are beyond the circle, and must still reach full deflection.
+    expect_stick(&shaping, "radial: corner ++", 511, 511, 511, 511);
+    expect_stick(&shaping, "radial: corner --", -512, -512, -512, -512);
+    expect_stick(&shaping, "radial: corner +-", 511, -512, 511, -512);
+    expect_stick(&shaping, "radial: edge", 0, -512, 0, -512);
+    expect_stick(&shaping, "radial: edge +", 0, 511, 0, 511);
+
+    // The deadzone is on the distance from the center, not per axis.
+    expect_stick(&shaping, "radial: center", 0, 0, 0, 0);
+    expect_stick(&shaping, "radial: inside", 35, -35, 0, 0);
+    expect_stick(&shaping, "radial: outside", 0, 60, 0, 6);
+}
+
+static void check_axial(void) {
+    static uni_axis_shaping_t shaping;
+    uni_axis_shaping_config_t config;
+
+    memset(&config, 0, sizeof(config));
+    config.stick.deadzone = 100;
+    config.stick_axial = true;
+    uni_axis_shaping_compile(&config, &shaping);
+
+    // -512 saturates the table, like 511. The output is symmetric.
+    expect_stick(&shaping, "axial: -512", -512, 0, -511, 0);
+    expect_stick(&shaping, "axial: full", -512, 511, -511, 511);
+
+    // The deadzone is per axis.
+    expect_stick(&shaping, "axial: inside", 40, -40, 0, 0);
+    expect_stick(&shaping, "axial: one axis", 500, 40, 499, 0);
+}
+
+static int check(void) {
+    check_deadzone();
+    check_expo();
+    check_points();
+    check_radial();
+    check_axial();
+
+    if (failures)
+        printf("%d checks failed\n", failures);
+    else
+        printf("All checks passed\n");
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "check") == 0)
+        return check();
+
+    printf("Usage: %s check\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+// uni_crc32_le() test and microbenchmark. Host only.
+// Compares the slice-by-4 implementation against the bitwise reference.
+//
+// Usage:
+//   uni_crc32_test check               Runs the checks. Returns non-zero on failure.
+//   uni_crc32_test bench [iterations]  Bytes/s of the bitwise reference and uni_crc32_le(), per buffer size.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "uni_utils.h"
+
+#define CRCPOLY 0xedb88320
+#define TEST_MAX_LEN 1024
+#define TEST_DEFAULT_ITERATIONS 200000
+
+static uint8_t buffer[TEST_MAX_LEN];
+
+// Bitwise reference: one bit per iteration, no tables.
+static uint32_t crc32_le_bitwise(uint32_t crc, const uint8_t* data, size_t len) {
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ (CRCPOLY & -(crc & 1));
+    }
+    return crc;
+}
+
+static void fill_buffer(unsigned int seed) {
+    srand(seed);
+    for (int i = 0; i < TEST_MAX_LEN; i++)
+        buffer[i] = rand() & 0xff;
+}
+
+static int check(void) {
+    static const uint8_t check_string[] = "123456789";
+    static const uint8_t hid_output_header = 0xa2;
+    int failures = 0;
+    uint32_t crc;
+
+    // Standard CRC-32 check value.
+    crc = ~uni_crc32_le(0xffffffff, check_string, sizeof(check_string) - 1);
+    if (crc != 0xcbf43926) {
+        printf("FAIL: check value: 0x%08x != 0xcbf43926\n", crc);
+        failures++;
+    }
+
+    crc = uni_crc32_le(0xffffffff, &hid_output_header, 1);
+    if (crc != UNI_CRC32_LE_SEED_HID_OUTPUT) {
+        printf("FAIL: UNI_CRC32_LE_SEED_HID_OUTPUT: 0x%08x != 0x%08x\n", crc, UNI_CRC32_LE_SEED_HID_OUTPUT);
+        failures++;
+    }
+
+    // Every length and alignment, so that both the 4-byte loop and the tail are covered.
+    fill_buffer(1);
+    for (size_t offset = 0; offset < 4; offset++) {
+        for (size_t len = 0; len <= TEST_MAX_LEN - offset; len++) {
+            uint32_t expected = crc32_le_bitwise(0xffffffff, buffer + offset, len);
+            crc = uni_crc32_le(0xffffffff, buffer + offset, len);
+            if (crc != expected) {
+                printf("FAIL: offset=%zu len=%zu: 0x%08x != 0x%08x\n", offset, len, crc, expected);
+                failures++;
+            }
+        }
+    }
+
+    // Incremental: any split must give the same value as a single call.
+    fill_buffer(2);
+    uint32_t expected = crc32_le_bitwise(0xffffffff, buffer, 100);
+    for (size_t split = 0; split <= 100; split++) {
+        crc = uni_crc32_le(0xffffffff, buffer, split);
+        crc = uni_crc32_le(crc, buffer + split, 100 - split);
+        if (crc != expected) {
+            printf("FAIL: split=%zu: 0x%08x != 0x%08x\n", split, crc, expected);
+            failures++;
+        }
+    }
+
+    if (failures)
+        printf("%d checks failed\n", failures);
+    else
+        printf("All checks passed\n");
+    return failures ? 1 : 0;
+}
+
+static double elapsed_s(const struct timespec* start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int bench(long iterations) {
+    // 10: DS4 / DualSense short output report. 79: DualSense BT output report. 1024: long buffer.
+    static const size_t sizes[] = {10, 79, 1024};
+    // Prevents the compiler from optimizing away the loops.
+    volatile uint32_t sink = 0;
+
+    fill_buffer(3);
+    printf("%8s %16s %16s %8s\n", "bytes", "bitwise MB/s", "uni_crc32 MB/s", "speedup");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        struct timespec start;
+        size_t len = sizes[i];
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (long n = 0; n < iterations; n++)
+            sink ^= crc32_le_bitwise(0xffffffff ^ (uint32_t)n, buffer, len);
+        double bitwise_s = elapsed_s(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (long n = 0; n < iterations; n++)
+            sink ^= uni_crc32_le(0xffffffff ^ (uint32_t)n, buffer, len);
+        double sliced_s = elapsed_s(&start);
+
+        double mbytes = (double)len * iterations / 1e6;
+        printf("%8zu %16.1f %16.1f %7.1fx\n", len, mbytes / bitwise_s, mbytes / sliced_s, bitwise_s / sliced_s);
+    }
+    (void)sink;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "check") == 0)
+        return check();
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0)
+        return bench(argc >= 3 ? atol(argv[2]) : TEST_DEFAULT_ITERATIONS);
+
+    printf("Usage: %s check | bench [iterations]\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+// uni_keyboard_ring_t test. Host only.
+// Feeds keyboard reports to uni_keyboard_ring_update() and checks the generated events.
+//
+// Usage:
+//   uni_keyboard_test check    Runs the checks. Returns non-zero on failure.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "controller/uni_keyboard.h"
+#include "hid_usage.h"
+
+// More keys than UNI_KEYBOARD_PRESSED_KEYS_MAX, like an N-key rollover keyboard would report.
+#define TEST_MANY_KEYS 16
+// More events than UNI_KEYBOARD_RING_SIZE.
+#define TEST_OVERFLOW_KEYS (UNI_KEYBOARD_RING_SIZE + 8)
+
+static int failures;
+
+// Builds a report, like the keyboard parser does: the first keys go to "pressed_keys", all of them to the bitmap.
+static void make_report(uni_keyboard_t* kb, uint8_t modifiers, const uint8_t* keys, int num_keys) {
+    memset(kb, 0, sizeof(*kb));
+    kb->modifiers = modifiers;
+    for (int i = 0; i < 8; i++) {
+        if (modifiers & BIT(i))
+            uni_keyboard_set_key_pressed(kb, HID_USAGE_KB_LEFT_CONTROL + i);
+    }
+    for (int i = 0; i < num_keys; i++) {
+        uni_keyboard_set_key_pressed(kb, keys[i]);
+        if (i < UNI_KEYBOARD_PRESSED_KEYS_MAX)
+            kb->pressed_keys[i] = keys[i];
+    }
+}
+
+static void expect_event(const char* name, const uni_keyboard_event_t* e, uint8_t key, bool pressed, uint32_t ts) {
+    if (e->key != key || e->pressed != pressed || e->timestamp_ms != ts) {
+        printf("FAIL: %s: key=%#x pressed=%d ts=%u, want key=%#x pressed=%d ts=%u\n", name, e->key, e->pressed,
+               e->timestamp_ms, key, pressed, ts);
+        failures++;
+    }
+}
+
+static void expect_count(const char* name, int got, int want) {
+    if (got != want) {
+        printf("FAIL: %s: %d events, want %d\n", name, got, want);
+        failures++;
+    }
+}
+
+static void check_ordering(void) {
+    static const uint8_t first[] = {HID_USAGE_KB_D, HID_USAGE_KB_A, HID_USAGE_KB_B};
+    static const uint8_t second[] = {HID_USAGE_KB_C, HID_USAGE_KB_B};
+    uni_keyboard_ring_t ring;
+    uni_keyboard_event_t events[UNI_KEYBOARD_RING_SIZE];
+    uni_keyboard_t kb;
+    int n;
+
+    uni_keyboard_ring_reset(&ring);
+
+    // Presses, in usage order. Not in report order.
+    make_report(&kb, UNI_KEYBOARD_MODIFIER_LEFT_SHIFT, first, sizeof(first));
+    uni_keyboard_ring_update(&ring, &kb, 10);
+    n = uni_keyboard_ring_read(&ring, events, UNI_KEYBOARD_RING_SIZE);
+    expect_count("ordering: press", n, 4);
+    if (n == 4) {
+        expect_event("ordering: press 0", &events[0], HID_USAGE_KB_A, true, 10);
+        expect_event("ordering: press 1", &events[1], HID_USAGE_KB_B, true, 10);
+        expect_event("ordering: press 2", &events[2], HID_USAGE_KB_D, true, 10);
+        expect_event("ordering: press 3", &events[3], HID_USAGE_KB_LEFT_SHIFT, true, 10);
+        if (events[0].modifiers != UNI_KEYBOARD_MODIFIER_LEFT_SHIFT) {
+            printf("FAIL: ordering: modifiers=%#x\n", events[0].modifiers);
+            failures++;
+        }
+    }
+
+    // Same report: no events.
+    uni_keyboard_ring_update(&ring, &kb, 20);
+    expect_count("ordering: same report", uni_keyboard_ring_read(&ring, events, UNI_KEYBOARD_RING_SIZE), 0);
+
+    // Releases before presses, even when the pressed key has a lower usage.
+    make_report(&kb, 0, second, sizeof(second));
+    uni_keyboard_ring_update(&ring, &kb, 30);
+    n = uni_keyboard_ring_read(&ring, events, UNI_KEYBOARD_RING_SIZE);
+    expect_count("ordering: release", n, 4);
+    if (n == 4) {
+        expect_event("ordering: release 0", &events[0], HID_USAGE_KB_A, false, 30);
+        expect_event("ordering: release 1", &events[1], HID_USAGE_KB_D, false, 30);
+        expect_event("ordering: release 2", &events[2], HID_USAGE_KB_LEFT_SHIFT, false, 30);
+        expect_event("ordering: release 3", &events[3], HID_USAGE_KB_C, true, 30);
+    }
+}
+
+static void check_many_keys(void) {
+    uni_keyboard_ring_t ring;
+    uni_keyboard_event_t events[UNI_KEYBOARD_RING_SIZE];
+    uni_keyboard_t kb;
+    uint8_t keys[TEST_MANY_KEYS];
+    int n;
+
+    for (int i = 0; i < TEST_MANY_KEYS; i++)
+        keys[i] = HID_USAGE_KB_A + i;
+
+    uni_keyboard_ring_reset(&ring);
+    make_report(&kb, 0, keys, TEST_MANY_KEYS);
+    uni_keyboard_ring_update(&ring, &kb, 10);
+    n = uni_keyboard_ring_read(&ring, events, UNI_KEYBOARD_RING_SIZE);
+    expect_count("many keys: press", n, TEST_MANY_KEYS);
+    for (int i = 0; i < n && i < TEST_MANY_KEYS; i++)
+        expect_event("many keys: press", &events[i], keys[i], true, 10);
+
+    make_report(&kb, 0, NULL, 0);
+    uni_keyboard_ring_update(&ring, &kb, 20);
+    n = uni_keyboard_ring_read(&ring, events, UNI_KEYBOARD_RING_SIZE);
+    expect_count("many keys: release", n, TEST_MANY_KEYS);
+    for (int i = 0; i < n && i < TEST_MANY_KEYS; i++)
+        expect_event("many keys: release", &events[i], keys[i], false, 20);
+}
+
+static void check_overflow(void) {
+    uni_keyboard_ring_t ring;
+    uni_keyboard_event_t events[UNI_KEYBOARD_RING_SIZE];
+    uni_keyboard_t kb;
+    uint8_t keys[TEST_OVERFLOW_KEYS];
+    uint32_t cursor = 0;
+    int n;
+
+    for (int i = 0; i < TEST_OVERFLOW_KEYS; i++)
+        keys[i] = HID_USAGE_KB_A + i;
+
+    uni_keyboard_ring_reset(&ring);
+    make_report(&kb, 0, keys, TEST_OVERFLOW_KEYS);
+    uni_keyboard_ring_update(&ring, &kb, 10);
+
+    // Peek skips the events that were overwritten.
+    n = uni_keyboard_ring_peek(&ring, &cursor, events, UNI_KEYBOARD_RING_SIZE);
+    expect_count("overflow: peek", n, UNI_KEYBOARD_RING_SIZE);
+    if (cursor != TEST_OVERFLOW_KEYS) {
+        printf("FAIL: overflow: cursor=%u, want %d\n", cursor, TEST_OVERFLOW_KEYS);
+        failures++;
+    }
+    if (n > 0)
+        expect_event("overflow: peek oldest", &events[0], keys[TEST_OVERFLOW_KEYS - UNI_KEYBOARD_RING_SIZE], true, 10);
+
+    // The oldest ones are lost, the newest ones are kept in order.
+    n = uni_keyboard_ring_read(&ring, events, UNI_KEYBOARD_RING_SIZE);
+    expect_count("overflow: read", n, UNI_KEYBOARD_RING_SIZE);
+    for (int i = 0; i < n && i < UNI_KEYBOARD_RING_SIZE; i++)
+        expect_event("overflow: read", &events[i], keys[TEST_OVERFLOW_KEYS - UNI_KEYBOARD_RING_SIZE + i], true, 10);
+    expect_count("overflow: empty", uni_keyboard_ring_read(&ring, events, UNI_KEYBOARD_RING_SIZE), 0);
+}
+
+static void check_roll_over(void) {
+    static const uint8_t held[] = {HID_USAGE_KB_A, HID_USAGE_KB_B};
+    static const uint8_t more[] = {HID_USAGE_KB_A, HID_USAGE_KB_B, HID_USAGE_KB_C};
+    uni_keyboard_ring_t ring;
+    uni_keyboard_event_t events[UNI_KEYBOARD_RING_SIZE];
+    uni_keyboard_t kb;
+    int n;
+
+    uni_keyboard_ring_reset(&ring);
+    make_report(&kb, 0, held, sizeof(held));
+    uni_keyboard_ring_update(&ring, &kb, 10);
+    expect_count("rollover: press", uni_keyboard_ring_read(&ring, events, UNI_KEYBOARD_RING_SIZE), 2);
+
+    // Past the rollover limit, a 6KRO boot keyboard reports ErrorRollOver in every slot, and only the modifiers.
+    make_report(&kb, UNI_KEYBOARD_MODIFIER_LEFT_SHIFT, NULL, 0);
+    memset(kb.pressed_keys, HID_USAGE_KB_ERROR_ROLL_OVER, 6);
+    uni_keyboard_ring_update(&ring, &kb, 20);
+    expect_count("rollover: error report", uni_keyboard_ring_read(&ring, events, UNI_KEYBOARD_RING_SIZE), 0);
+
+    // Held keys are not pressed again.
+    make_report(&kb, 0, more, sizeof(more));
+    uni_keyboard_ring_update(&ring, &kb, 30);
+    n = uni_keyboard_ring_read(&ring, events, UNI_KEYBOARD_RING_SIZE);
+    expect_count("rollover: next report", n, 1);
+    if (n == 1)
+        expect_event("rollover: next report", &events[0], HID_USAGE_KB_C, true, 30);
+}
+
+static int check(void) {
+    check_ordering();
+    check_many_keys();
+    check_overflow();
+    check_roll_over();
+
+    if (failures)
+        printf("%d checks failed\n", failures);
+    else
+        printf("All checks passed\n");
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "check") == 0)
+        return check();
+
+    printf("Usage: %s check\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,477 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+// NINA / AirLift protocol simulator. Host only.
+// Runs uni_platform_nina_protocol.c without the SPI-slave transport, so that
+// protocol changes can be verified without a board.
+//
+// Usage:
+//   uni_nina_sim check              Runs the protocol checks. Returns non-zero on failure.
+//   uni_nina_sim bench [frames]     Commands/s and bytes per controller update, per protocol version.
+//   uni_nina_sim replay <file>      Replays a command stream. See replay() for the format.
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bt/uni_bt.h"
+#include "platform/uni_platform_nina_protocol.h"
+#include "uni_common.h"
+#include "uni_hid_device.h"
+
+#define SIM_MAX_CONTROLLERS CONFIG_BLUEPAD32_MAX_DEVICES
+#define SIM_DEFAULT_FRAMES 100000
+// The host reads the controllers once per frame, and sends the rumble / LEDs every N frames.
+#define SIM_OUTPUT_EVERY_N_FRAMES 16
+#define SIM_DATA_AVAILABLE_GPIO 33
+#define SIM_GPIO_COUNT 40
+
+enum {
+    CMD_START = 0xe0,
+    CMD_END = 0xee,
+    CMD_ERR = 0xef,
+};
+
+static bool verbose;
+static uint8_t gpio_levels[SIM_GPIO_COUNT];
+static int pending_requests;
+static uni_hid_device_t devices[SIM_MAX_CONTROLLERS];
+static uint32_t rand_state = 1;
+
+//
+// Stubs for the functions used by the protocol layer
+//
+void uni_log(const char* fmt, ...) {
+    va_list args;
+
+    if (!verbose)
+        return;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+void printf_hexdump(const void* data, int size) {
+    const uint8_t* p = data;
+
+    if (!verbose)
+        return;
+    for (int i = 0; i < size; i++)
+        printf("%02x ", p[i]);
+    printf("\n");
+}
+
+void uni_bt_del_keys_safe(void) {}
+
+void uni_bt_enable_new_connections_safe(bool enabled) {
+    ARG_UNUSED(enabled);
+}
+
+void uni_bt_get_local_bd_addr_safe(bd_addr_t addr) {
+    memset(addr, 0, BD_ADDR_LEN);
+}
+
+bool uni_hid_device_is_gamepad(uni_hid_device_t* d) {
+    ARG_UNUSED(d);
+    return true;
+}
+
+bool uni_hid_device_is_mouse(uni_hid_device_t* d) {
+    ARG_UNUSED(d);
+    return false;
+}
+
+bool uni_hid_device_is_keyboard(uni_hid_device_t* d) {
+    ARG_UNUSED(d);
+    return false;
+}
+
+//
+// Transport ops
+//
+static void ops_lock(void) {}
+
+static void ops_unlock(void) {}
+
+static void ops_queue_pending_request(const uni_nina_pending_request_t* request) {
+    ARG_UNUSED(request);
+    pending_requests++;
+}
+
+static bool ops_set_pin_mode(uint8_t pin, uint8_t mode) {
+    ARG_UNUSED(mode);
+    return pin < SIM_GPIO_COUNT;
+}
+
+static bool ops_digital_write(uint8_t pin, uint8_t value) {
+    if (pin >= SIM_GPIO_COUNT)
+        return false;
+    gpio_levels[pin] = value;
+    return true;
+}
+
+static bool ops_analog_write(uint8_t pin, uint8_t value) {
+    return ops_digital_write(pin, value);
+}
+
+static uint8_t ops_digital_read(uint8_t pin) {
+    return (pin < SIM_GPIO_COUNT) ? gpio_levels[pin] : 0;
+}
+
+static uint16_t ops_analog_read(uint8_t pin) {
+    return ops_digital_read(pin);
+}
+
+static bool ops_reserve_data_available_gpio(uint8_t pin) {
+    return pin == SIM_DATA_AVAILABLE_GPIO;
+}
+
+static const uni_nina_protocol_ops_t sim_ops = {
+    .lock = ops_lock,
+    .unlock = ops_unlock,
+    .queue_pending_request = ops_queue_pending_request,
+    .set_pin_mode = ops_set_pin_mode,
+    .digital_write = ops_digital_write,
+    .analog_write = ops_analog_write,
+    .digital_read = ops_digital_read,
+    .analog_read = ops_analog_read,
+    .reserve_data_available_gpio = ops_reserve_data_available_gpio,
+};
+
+//
+// Helpers
+//
+static uint32_t sim_rand(void) {
+    // Deterministic, so that runs can be compared.
+    rand_state = rand_state * 1103515245 + 12345;
+    return rand_state >> 16;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sim_reset(void) {
+    uint8_t response[UNI_NINA_PROTOCOL_BUFFER_LEN];
+    // Disables the "data available" GPIO, in case a previous run enabled it.
+    const uint8_t disable_features[] = {CMD_START, 0x0a, 3, 2, 1, 6, 1, 0, 1, 0, CMD_END};
+
+    uni_nina_protocol_init(&sim_ops);
+    uni_nina_protocol_process_request(disable_features, sizeof(disable_features), response);
+    for (int i = 0; i < SIM_MAX_CONTROLLERS; i++)
+        uni_nina_protocol_on_controller_disconnected(i);
+    memset(gpio_levels, 1, sizeof(gpio_levels));
+    pending_requests = 0;
+    rand_state = 1;
+}
+
+static void sim_connect(int idx) {
+    uni_hid_device_t* d = &devices[idx];
+
+    memset(d, 0, sizeof(*d));
+    d->vendor_id = 0x054c;
+    d->product_id = 0x09cc;
+    d->conn.btaddr[5] = idx;
+    uni_nina_protocol_on_controller_ready(idx, d);
+}
+
+// Synthetic controller update. "change" is the chance, in percent, that something moved.
+static void sim_update(int idx, int change) {
+    static uni_controller_t ctls[SIM_MAX_CONTROLLERS];
+    uni_controller_t* ctl = &ctls[idx];
+
+    ctl->klass = UNI_CONTROLLER_CLASS_GAMEPAD;
+    ctl->battery = 200;
+    if ((int)(sim_rand() % 100) < change) {
+        ctl->gamepad.axis_x = (int32_t)(sim_rand() % 1024) - 512;
+        ctl->gamepad.axis_y = (int32_t)(sim_rand() % 1024) - 512;
+        ctl->gamepad.buttons = sim_rand() & 0x0f;
+    }
+    uni_nina_protocol_on_controller_data(idx, ctl);
+}
+
+// Like the SPI transport: the command is received into its own buffer, and the bytes past "len",
+// up to UNI_NINA_PROTOCOL_COMMAND_MIN_LEN, are cleared.
+static int sim_request(const uint8_t* command, int len, uint8_t* response, uint64_t* bytes) {
+    uint8_t buf[UNI_NINA_PROTOCOL_BUFFER_LEN];
+    int response_len;
+
+    if (len > UNI_NINA_PROTOCOL_BUFFER_LEN)
+        len = UNI_NINA_PROTOCOL_BUFFER_LEN;
+    memcpy(buf, command, len);
+    if (len < UNI_NINA_PROTOCOL_COMMAND_MIN_LEN)
+        memset(&buf[len], 0, UNI_NINA_PROTOCOL_COMMAND_MIN_LEN - len);
+
+    response_len = uni_nina_protocol_process_request(buf, len, response);
+    *bytes += len + response_len;
+    return response_len;
+}
+
+//
+// Checks
+//
+static int failures;
+
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            fprintf(stderr, "%s:%d: FAILED: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                        \
+        }                                                                      \
+    } while (0)
+
+static int check(void) {
+    uint8_t response[UNI_NINA_PROTOCOL_BUFFER_LEN];
+    uint64_t bytes = 0;
+    int len;
+
+    sim_reset();
+
+    // Protocol version
+    const uint8_t version[] = {CMD_START, 0x00, 0, CMD_END};
+    len = sim_request(version, sizeof(version), response, &bytes);
+    CHECK(len == 7 && response[0] == CMD_START && response[1] == 0x80 && response[4] == 1 && response[6] == CMD_END);
+
+    // Controllers data: one param per connected controller
+    sim_connect(0);
+    sim_connect(2);
+    sim_update(0, 100);
+    const uint8_t data[] = {CMD_START, 0x09, 0, CMD_END};
+    len = sim_request(data, sizeof(data), response, &bytes);
+    CHECK(response[2] == 2);
+    CHECK(response[len - 1] == CMD_END);
+
+    // Push mode: the GPIO goes low on new data, and high once the host reads it
+    const uint8_t features[] = {CMD_START, 0x0a, 3, 2, 1, 6, 1, 1, 1, SIM_DATA_AVAILABLE_GPIO, CMD_END};
+    len = sim_request(features, sizeof(features), response, &bytes);
+    CHECK(len > 4 && response[4] == 1 && response[9] == 1);
+    sim_request(data, sizeof(data), response, &bytes);
+    CHECK(gpio_levels[SIM_DATA_AVAILABLE_GPIO] == 1);
+    sim_update(0, 100);
+    CHECK(gpio_levels[SIM_DATA_AVAILABLE_GPIO] == 0);
+    sim_request(data, sizeof(data), response, &bytes);
+    CHECK(gpio_levels[SIM_DATA_AVAILABLE_GPIO] == 1);
+
+    // Feature request with the wrong param lens is rejected
+    const uint8_t bad_features[] = {CMD_START, 0x0a, 3, 2, 1, 6, 2, 1, 1, SIM_DATA_AVAILABLE_GPIO, CMD_END};
+    len = sim_request(bad_features, sizeof(bad_features), response, &bytes);
+    CHECK(len == 3 && response[0] == CMD_ERR);
+
+    // Batch: rumble + LEDs for controller 0, and an unsupported command
+    const uint8_t batch[] = {
+        CMD_START, 0x0b, 3,                      // Header, 3 sub-commands
+        7,         0x04, 2, 1, 0, 2, 0x80, 0x10,  // Rumble
+        6,         0x02, 2, 1, 0, 1, 0x05,        // Player LEDs
+        2,         0x01, 0,                       // Gamepads data: can't be batched
+        CMD_END,
+    };
+    pending_requests = 0;
+    len = sim_request(batch, sizeof(batch), response, &bytes);
+    CHECK(len == 13 && response[2] == 3);
+    CHECK(response[4] == 0x04 && response[5] == 1);
+    CHECK(response[7] == 0x02 && response[8] == 1);
+    CHECK(response[10] == 0x01 && response[11] == 0);
+    CHECK(pending_requests == 2);
+
+    // Truncated batch: rejected as a whole, without side effects
+    pending_requests = 0;
+    len = sim_request(batch, 10, response, &bytes);
+    CHECK(len == 3 && response[0] == CMD_ERR);
+    CHECK(pending_requests == 0);
+
+    // Batch without CMD_END: rejected as a whole
+    len = sim_request(batch, sizeof(batch) - 1, response, &bytes);
+    CHECK(len == 3 && response[0] == CMD_ERR);
+    CHECK(pending_requests == 0);
+
+    if (failures == 0)
+        printf("All checks passed\n");
+    return failures ? 1 : 0;
+}
+
+//
+// Benchmark
+//
+typedef enum {
+    HOST_POLL_GAMEPADS,     // v1.4: polls command 0x01 every frame
+    HOST_POLL_CONTROLLERS,  // v1.4: polls command 0x09 every frame
+    HOST_PUSH,              // v1.5: reads command 0x09 only when the "data available" GPIO is low
+    HOST_PUSH_BATCH,        // v1.6: like v1.5, and sends the rumble / LEDs in one batch
+} host_mode_t;
+
+static void bench_mode(const char* name, host_mode_t mode, int frames, int change) {
+    uint8_t response[UNI_NINA_PROTOCOL_BUFFER_LEN];
+    uint64_t bytes = 0;
+    uint64_t commands = 0;
+    uint64_t updates = 0;
+    uint64_t elapsed = 0;
+    uint64_t t0;
+
+    const uint8_t gamepads[] = {CMD_START, 0x01, 0, CMD_END};
+    const uint8_t controllers[] = {CMD_START, 0x09, 0, CMD_END};
+    const uint8_t features[] = {CMD_START, 0x0a, 3, 2, 1, 6, 1, 1, 1, SIM_DATA_AVAILABLE_GPIO, CMD_END};
+    uint8_t rumble[] = {CMD_START, 0x04, 2, 1, 0, 2, 0x80, 0x10, CMD_END};
+    uint8_t leds[] = {CMD_START, 0x02, 2, 1, 0, 1, 0x05, CMD_END};
+    uint8_t batch[] = {CMD_START, 0x0b, 2, 7, 0x04, 2, 1, 0, 2, 0x80, 0x10, 6, 0x02, 2, 1, 0, 1, 0x05, CMD_END};
+
+    sim_reset();
+    for (int i = 0; i < SIM_MAX_CONTROLLERS; i++)
+        sim_connect(i);
+
+    if (mode == HOST_PUSH || mode == HOST_PUSH_BATCH) {
+        t0 = now_ns();
+        sim_request(features, sizeof(features), response, &bytes);
+        elapsed += now_ns() - t0;
+        commands++;
+    }
+
+    for (int frame = 0; frame < frames; frame++) {
+        for (int i = 0; i < SIM_MAX_CONTROLLERS; i++)
+            sim_update(i, change);
+        updates += SIM_MAX_CONTROLLERS;
+
+        t0 = now_ns();
+        switch (mode) {
+            case HOST_POLL_GAMEPADS:
+                sim_request(gamepads, sizeof(gamepads), response, &bytes);
+                commands++;
+                break;
+            case HOST_POLL_CONTROLLERS:
+                sim_request(controllers, sizeof(controllers), response, &bytes);
+                commands++;
+                break;
+            case HOST_PUSH:
+            case HOST_PUSH_BATCH:
+                if (gpio_levels[SIM_DATA_AVAILABLE_GPIO] == 0) {
+                    sim_request(controllers, sizeof(controllers), response, &bytes);
+                    commands++;
+                }
+                break;
+        }
+
+        if (frame % SIM_OUTPUT_EVERY_N_FRAMES == 0) {
+            for (int i = 0; i < SIM_MAX_CONTROLLERS; i++) {
+                if (mode == HOST_PUSH_BATCH) {
+                    batch[7] = i;
+                    batch[15] = i;
+                    sim_request(batch, sizeof(batch), response, &bytes);
+                    commands++;
+                } else {
+                    rumble[4] = i;
+                    leds[4] = i;
+                    sim_request(rumble, sizeof(rumble), response, &bytes);
+                    sim_request(leds, sizeof(leds), response, &bytes);
+                    commands += 2;
+                }
+            }
+        }
+        elapsed += now_ns() - t0;
+    }
+
+    printf("%-28s %3d%% %12.0f %10llu %10.2f\n", name, change, commands * 1e9 / (elapsed ? elapsed : 1),
+           (unsigned long long)commands, (double)bytes / updates);
+}
+
+static int bench(int frames) {
+    static const int changes[] = {100, 25};
+
+    printf("%d controllers, %d frames. Rumble + LEDs every %d frames.\n", SIM_MAX_CONTROLLERS, frames,
+           SIM_OUTPUT_EVERY_N_FRAMES);
+    printf("%-28s %4s %12s %10s %10s\n", "protocol", "chg", "commands/s", "commands", "bytes/upd");
+    for (unsigned int i = 0; i < ARRAY_SIZE(changes); i++) {
+        bench_mode("v1.4 poll gamepads (0x01)", HOST_POLL_GAMEPADS, frames, changes[i]);
+        bench_mode("v1.4 poll controllers (0x09)", HOST_POLL_CONTROLLERS, frames, changes[i]);
+        bench_mode("v1.5 push (0x0a + 0x09)", HOST_PUSH, frames, changes[i]);
+        bench_mode("v1.6 push + batch (0x0b)", HOST_PUSH_BATCH, frames, changes[i]);
+    }
+    return 0;
+}
+
+//
+// Replay
+//
+// One entry per line. Empty lines and lines starting with "#" are ignored.
+//   connect <idx>              Controller <idx> gets connected
+//   disconnect <idx>           Controller <idx> gets disconnected
+//   update <idx> <percent>     Synthetic update for controller <idx>, with a <percent> chance of changes
+//   <hex bytes>                Command frame, like "e0 00 00 ee". The response is printed.
+static int replay(const char* filename) {
+    uint8_t command[UNI_NINA_PROTOCOL_BUFFER_LEN];
+    uint8_t response[UNI_NINA_PROTOCOL_BUFFER_LEN];
+    char line[1024];
+    uint64_t bytes = 0;
+    int line_num = 0;
+    int idx, arg;
+    FILE* f;
+
+    f = fopen(filename, "r");
+    if (f == NULL) {
+        perror(filename);
+        return 1;
+    }
+
+    sim_reset();
+    while (fgets(line, sizeof(line), f) != NULL) {
+        line_num++;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == 0)
+            continue;
+
+        if (sscanf(line, "connect %d", &idx) == 1 && idx >= 0 && idx < SIM_MAX_CONTROLLERS) {
+            sim_connect(idx);
+        } else if (sscanf(line, "disconnect %d", &idx) == 1 && idx >= 0 && idx < SIM_MAX_CONTROLLERS) {
+            uni_nina_protocol_on_controller_disconnected(idx);
+        } else if (sscanf(line, "update %d %d", &idx, &arg) == 2 && idx >= 0 && idx < SIM_MAX_CONTROLLERS) {
+            sim_update(idx, arg);
+        } else {
+            char* p = line;
+            char* end;
+            int len = 0;
+
+            while (len < (int)sizeof(command)) {
+                long v = strtol(p, &end, 16);
+                if (end == p)
+                    break;
+                command[len++] = v;
+                p = end;
+            }
+            if (len == 0) {
+                fprintf(stderr, "%s:%d: invalid line\n", filename, line_num);
+                fclose(f);
+                return 1;
+            }
+
+            int response_len = sim_request(command, len, response, &bytes);
+            printf("%4d:", line_num);
+            for (int i = 0; i < response_len; i++)
+                printf(" %02x", response[i]);
+            printf("\n");
+        }
+    }
+    fclose(f);
+
+    printf("Total bytes: %llu, pending requests: %d, data available GPIO: %d\n", (unsigned long long)bytes,
+           pending_requests, gpio_levels[SIM_DATA_AVAILABLE_GPIO]);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (getenv("UNI_NINA_SIM_VERBOSE") != NULL)
+        verbose = true;
+
+    if (argc >= 2 && strcmp(argv[1], "check") == 0)
+        return check();
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0)
+        return bench(argc >= 3 ? atoi(argv[2]) : SIM_DEFAULT_FRAMES);
+    if (argc >= 3 && strcmp(argv[1], "replay") == 0)
+        return replay(argv[2]);
+
+    fprintf(stderr, "Usage: %s check | bench [frames] | replay <file>\n", argv[0]);
+    return 1;
+}
@@ -13,6 +13,8 @@
 #include "bt/uni_bt_bredr.h"
 #include "bt/uni_bt_defines.h"
 #include "bt/uni_bt_le.h"
+#include "bt/uni_bt_link_quality.h"
+#include "bt/uni_bt_sdp.h"
 #include "bt/uni_bt_service.h"
 #include "controller/uni_controller_type.h"
 #include "parser/uni_hid_parser_8bitdo.h"
@@ -73,6 +75,7 @@ uni_hid_device_t* uni_hid_device_create(bd_addr_t address) {
 
             memset(&g_devices[i], 0, sizeof(g_devices[i]));
             bd_addr_copy(g_devices[i].conn.btaddr, address);
+            g_devices[i].conn.setup_start_ms = btstack_run_loop_get_time_ms();
 
             // Delete device if it doesn't have a connection
             start_connection_timeout(&g_devices[i]);
@@ -82,6 +85,15 @@ uni_hid_device_t* uni_hid_device_create(bd_addr_t address) {
     return NULL;
 }
 
+int uni_hid_device_get_free_slots_count(void) {
+    int count = 0;
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        if (bd_addr_cmp(g_devices[i].conn.btaddr, zero_addr) == 0)
+            count++;
+    }
+    return count;
+}
+
 uni_hid_device_t* uni_hid_device_create_virtual(uni_hid_device_t* parent) {
     if (!uni_virtual_device_is_enabled())
         return NULL;
@@ -106,6 +118,7 @@ uni_hid_device_t* uni_hid_device_create_virtual(uni_hid_device_t* parent) {
             g_devices[i].cod = parent->cod;
             g_devices[i].controller_type = parent->controller_type;
             g_devices[i].controller_subtype = parent->controller_subtype;
+            g_devices[i].conn.setup_start_ms = parent->conn.setup_start_ms;
 
             // All virtual devices have a "controller type", which is known by the parent.
             g_devices[i].flags |= FLAGS_HAS_CONTROLLER_TYPE;
@@ -239,7 +252,8 @@ bool uni_hid_device_set_ready_complete(uni_hid_device_t* d) {
         return false;
     }
 
-    logi("Device setup (%s) is complete\n", bd_addr_to_str(d->conn.btaddr));
+    logi("Device setup (%s) is complete, time to ready: %u ms\n", bd_addr_to_str(d->conn.btaddr),
+         (unsigned)(btstack_run_loop_get_time_ms() - d->conn.setup_start_ms));
 
     // Remove the timer once the connection was established.
     btstack_run_loop_remove_timer(&d->connection_timer);
@@ -256,6 +270,7 @@ bool uni_hid_device_set_ready_complete(uni_hid_device_t* d) {
     uni_bt_service_on_device_ready(d);
 
     uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_DEVICE_READY);
+    uni_bt_link_quality_on_device_ready(d);
     return true;
 }
 
@@ -325,7 +340,7 @@ uni_error_t uni_hid_device_on_device_discovered(bd_addr_t addr, const char* name
     }
 
     // As returned by BTStack, the bigger the RSSI number, the better, being 255 the closest possible (?).
-    if (rssi < (255 - 100)) {
+    if (rssi < HID_DEVICE_MIN_RSSI) {
         logi("Device %s too far away, try moving it closer to Bluepad32 device\n", bd_addr_to_str(addr));
         return UNI_ERROR_IGNORE_DEVICE;
     }
@@ -503,12 +518,17 @@ void uni_hid_device_delete(uni_hid_device_t* d) {
     // Remove the timer. If it was still running, it will crash if the handler gets called.
     btstack_run_loop_remove_timer(&d->connection_timer);
 
+    // The SDP queue might still reference it.
+    if (IS_ENABLED(UNI_ENABLE_BREDR) && !uni_hid_device_is_virtual_device(d))
+        uni_bt_sdp_query_cancel(d);
+
     uni_hid_device_init(d);
 }
 
 void uni_hid_device_dump_device(uni_hid_device_t* d) {
     const char* conn_type;
     gap_connection_type_t type;
+    uni_bt_link_quality_t link_quality;
 
     if (uni_hid_device_is_virtual_device(d)) {
         conn_type = "virtual";
@@ -536,6 +556,19 @@ void uni_hid_device_dump_device(uni_hid_device_t* d) {
         "incoming=%d\n",
         d->conn.handle, conn_type, d->hids_cid, d->conn.control_cid, d->conn.interrupt_cid, d->cod, d->flags,
         d->conn.incoming);
+    if (d->conn.protocol == UNI_BT_CONN_PROTOCOL_BR_EDR)
+        logi("\tbr/edr link: mode=%s, sniff interval=%d.%03d ms, sniff allowed=%d\n",
+             (d->conn.mode == ACL_CONNECTION_MODE_SNIFF)  ? "sniff"
+             : (d->conn.mode == ACL_CONNECTION_MODE_HOLD) ? "hold"
+                                                      : "active",
+             d->conn.sniff_interval * 625 / 1000, d->conn.sniff_interval * 625 % 1000, d->conn.sniff_allowed);
+    if (d->conn.protocol == UNI_BT_CONN_PROTOCOL_BLE)
+        logi("\tle conn: interval=%d.%02d ms, latency=%d, supervision timeout=%d ms\n",
+             d->conn.le_conn_interval * 125 / 100, d->conn.le_conn_interval * 125 % 100, d->conn.le_conn_latency,
+             d->conn.le_supervision_timeout * 10);
+    if (uni_bt_link_quality_get(d, &link_quality))
+        logi("\tlink quality: rssi=%d dBm, quality=%d, failed contacts=%d, low=%d\n", link_quality.rssi,
+             link_quality.link_quality, link_quality.failed_contacts, link_quality.low);
     logi("\tmodel: vid=0x%04x, pid=0x%04x, model='%s', name='%s'\n", d->vendor_id, d->product_id,
          uni_gamepad_get_model_name(d->controller_type), d->name);
     logi("\tbattery: %d / 255, type=%s\n", d->controller.battery,
@@ -736,6 +769,7 @@ void uni_hid_device_guess_controller_type_from_pid_vid(uni_hid_device_t* d) {
             d->report_parser.init_report = uni_hid_parser_mouse_init_report;
             d->report_parser.parse_usage = uni_hid_parser_mouse_parse_usage;
             d->report_parser.device_dump = uni_hid_parser_mouse_device_dump;
+            d->report_parser.set_report_result = uni_hid_parser_mouse_set_report_result;
             logi("Device detected as Mouse: 0x%02x\n", type);
             break;
         case CONTROLLER_TYPE_GenericKeyboard:
@@ -770,22 +804,45 @@ void uni_hid_device_set_connection_handle(uni_hid_device_t* d, hci_con_handle_t
     d->conn.handle = handle;
 }
 
+void uni_hid_device_set_mappings(uni_hid_device_t* d, const uni_gamepad_mappings_lut_t* lut) {
+    d->mappings = lut;
+}
+
+void uni_hid_device_set_axis_shaping(uni_hid_device_t* d, const uni_axis_shaping_t* shaping) {
+    d->axis_shaping = shaping;
+}
+
 void uni_hid_device_process_controller(uni_hid_device_t* d) {
     uni_gamepad_t gp;
+    uni_controller_t ctl;
     if (uni_bt_conn_get_state(&d->conn) != UNI_BT_CONN_STATE_DEVICE_READY) {
         return;
     }
 
     if (d->controller.klass == UNI_CONTROLLER_CLASS_GAMEPAD) {
-        gp = uni_gamepad_remap(&d->controller.gamepad);
+        if (d->mappings)
+            gp = uni_gamepad_remap_with_lut(&d->controller.gamepad, d->mappings);
+        else
+            gp = uni_gamepad_remap(&d->controller.gamepad);
         d->controller.gamepad = gp;
+        uni_motion_fusion_update(&d->motion_fusion, &d->motion, &d->controller.gamepad);
+    } else if (d->controller.klass == UNI_CONTROLLER_CLASS_KEYBOARD) {
+        uni_keyboard_ring_update(&d->key_events, &d->controller.keyboard, btstack_run_loop_get_time_ms());
     }
 
+    // Shape a copy: some parsers (e.g. Switch subcommand replies) re-report without
+    // refreshing the sticks, and shaping them in place would compound the curve.
+    ctl = d->controller;
+    if (ctl.klass == UNI_CONTROLLER_CLASS_GAMEPAD)
+        uni_axis_shaping_apply(d->axis_shaping, &ctl.gamepad);
+
     if (uni_get_platform()->on_controller_data != NULL)
-        uni_get_platform()->on_controller_data(d, &d->controller);
+        uni_get_platform()->on_controller_data(d, &ctl);
     else if (uni_get_platform()->on_gamepad_data != NULL)
         // Deprecated: should implement only on_controller_data
-        uni_get_platform()->on_gamepad_data(d, &d->controller.gamepad);
+        uni_get_platform()->on_gamepad_data(d, &ctl.gamepad);
+
+    uni_bt_service_on_controller_data(d, &ctl);
 
     // FIXME: each backend should decide what to do with misc buttons
     process_misc_button_system(d);
@@ -8,6 +8,8 @@
 
 #include "bt/uni_bt_allowlist.h"
 #include "bt/uni_bt_setup.h"
+#include "controller/uni_axis_shaping.h"
+#include "controller/uni_motion_fusion.h"
 #include "platform/uni_platform.h"
 #include "uni_config.h"
 #include "uni_console.h"
@@ -35,6 +37,8 @@ int uni_init(int argc, const char** argv) {
     uni_bt_setup();
     uni_bt_allowlist_init();
     uni_virtual_device_init();
+    uni_motion_fusion_init();
+    uni_axis_shaping_init();
 
 #if CONFIG_BLUEPAD32_USB_CONSOLE_ENABLE
     uni_console_init();
@@ -150,12 +150,11 @@ static void to_joy_from_keyboard(const uni_keyboard_t* kb, uni_joystick_t* out_j
         return;
     }
 
-    // Keys
-    for (int i = 0; i < UNI_KEYBOARD_PRESSED_KEYS_MAX; i++) {
-        // Stop on values from 0-3, they invalid codes.
-        const uint8_t key = kb->pressed_keys[i];
-        if (key <= HID_USAGE_KB_ERROR_UNDEFINED)
-            break;
+    // Keys. From the bitmap, since N-key rollover keyboards might have more than
+    // UNI_KEYBOARD_PRESSED_KEYS_MAX keys pressed.
+    for (int key = HID_USAGE_KB_A; key < HID_USAGE_KB_LEFT_CONTROL; key++) {
+        if (!uni_keyboard_is_key_pressed(kb, key))
+            continue;
         switch (key) {
             // Valid for both "single" and "twin stick" modes
             // 1st joystick: Arrow keys
@@ -8,7 +8,6 @@
  */
 #include "uni_mouse_quadrature.h"
 
-#include <math.h>
 #include <stdbool.h>
 #include <string.h>
 #include <sys/cdefs.h>
@@ -19,7 +18,6 @@
 #include <freertos/task.h>
 
 #include "uni_log.h"
-#include "uni_property.h"
 
 // Probably I could use a smaller divider, and only do "1 tick per 80us".
 // That would work Ok except that it will lose resolution when we divide "128 steps by delta".
@@ -39,9 +37,6 @@
 #define TASK_TIMER_STACK_SIZE (2048)
 #define TASK_TIMER_PRIO (10)
 
-// Default scale factor for the mouse movement
-#define DETAULT_SCALE_FACTOR (1)
-
 enum direction {
     PHASE_DIRECTION_NEG,
     PHASE_DIRECTION_POS,
@@ -72,10 +67,6 @@ static bool timer_started[UNI_MOUSE_QUADRATURE_PORT_MAX];
 
 static TaskHandle_t s_timer_tasks[UNI_MOUSE_QUADRATURE_PORT_MAX][UNI_MOUSE_QUADRATURE_ENCODER_MAX];
 
-// "Scale factor" for mouse movement. To make the mouse move faster or slower.
-// Bigger means slower movement.
-static float s_scale_factor;
-
 static bool initialized;
 
 static void process_quadrature(struct quadrature_state* q) {
@@ -213,26 +204,22 @@ static void process_update(struct quadrature_state* q, int32_t delta) {
         // - when it reaches 0, triggers the ISR.
         //
         // But a quadrature has 4 states (hence the name). So takes 4 "ticks" to have
-        // complete "state.", which is represented with "s_scale_factor",
-        // kind of "hand tuned" so that the mice movement feels "good" (to me).
+        // complete "state.", kind of "hand tuned" so that the mice movement feels "good" (to me).
         //
         // The smaller "units" is, the faster the mouse moves.
         //
         // But to avoid a "division" in the mouse driver, and a multiplication here,
-        // (which will lose precision), we just use a "s_scale_factor" of 1 instead of 4,
-        // and we don't divide by 4 here.
+        // (which will lose precision), we don't divide by 4 here.
         // Alternative: Do not divide the time, and use a constant "tick" time. But if we do so,
         // the movement will have "jank".
         // Perhaps for small deltas we can have a predefined "unit time".
         //
-        // s_scale_factor is used as a divisor to honor the "scale" name:
-        // smaller numbers make it slower, high number faster
-        float max_ticks = 128 * TICKS_PER_80US;
-        float delta_f = abs_delta;
-        float units_f = max_ticks / (delta_f * s_scale_factor);
-        if (units_f < TICKS_PER_80US)
-            units_f = TICKS_PER_80US;
-        units = roundf(units_f);
+        // The mouse scale is not applied here: "delta" is already scaled by the mouse parser,
+        // per device, in fixed point. See uni_hid_parser_mouse_set_global_scale().
+        uint32_t max_ticks = 128 * TICKS_PER_80US;
+        units = (max_ticks + abs_delta / 2) / abs_delta;
+        if (units < TICKS_PER_80US)
+            units = TICKS_PER_80US;
     } else {
         // If there is no update, set timer to update less frequently
         units = ONE_SECOND * 60;
@@ -251,9 +238,6 @@ void uni_mouse_quadrature_init(int cpu_id) {
         }
     }
 
-    // Default value that can be overridden from the console
-    s_scale_factor = uni_mouse_quadrature_get_scale_factor();
-
     // Create tasks
     xTaskCreatePinnedToCore(init_from_cpu_task, "uni.init_timers", TASK_TIMER_STACK_SIZE, NULL, TASK_TIMER_PRIO, NULL,
                             cpu_id);
@@ -341,19 +325,3 @@ void uni_mouse_quadrature_update(int port_idx, int32_t dx, int32_t dy) {
     // This is based on empiric evidence. Also, it seems that SmallyMouse is doing the same thing
     process_update(&s_quadratures[port_idx][UNI_MOUSE_QUADRATURE_ENCODER_V], -dy);
 }
-
-void uni_mouse_quadrature_set_scale_factor(float scale) {
-    uni_property_value_t value;
-    value.f32 = scale;
-
-    s_scale_factor = scale;
-    uni_property_set(UNI_PROPERTY_IDX_MOUSE_SCALE, value);
-}
-
-float uni_mouse_quadrature_get_scale_factor(void) {
-    uni_property_value_t value;
-
-    value = uni_property_get(UNI_PROPERTY_IDX_MOUSE_SCALE);
-    s_scale_factor = value.f32;
-    return value.f32;
-}
@@ -25,6 +25,12 @@ static const uni_property_t properties[] = {
      .default_value.boolean = false
 #endif  // CONFIG_BLUEPAD32_ENABLE_BLE_BY_DEFAULT
     },
+    {UNI_PROPERTY_IDX_BREDR_FLUSH_TIMEOUT, UNI_PROPERTY_NAME_BREDR_FLUSH_TIMEOUT, UNI_PROPERTY_TYPE_U32,
+     .default_value.u32 = UNI_BT_FLUSH_TIMEOUT_MS},
+    {UNI_PROPERTY_IDX_BREDR_QOS_ENABLED, UNI_PROPERTY_NAME_BREDR_QOS_ENABLED, UNI_PROPERTY_TYPE_BOOL,
+     .default_value.boolean = false},
+    {UNI_PROPERTY_IDX_BREDR_SNIFF_IDLE, UNI_PROPERTY_NAME_BREDR_SNIFF_IDLE, UNI_PROPERTY_TYPE_U32,
+     .default_value.u32 = UNI_BT_SNIFF_IDLE_MS},
     {UNI_PROPERTY_IDX_GAP_INQ_LEN, UNI_PROPERTY_NAME_GAP_INQ_LEN, UNI_PROPERTY_TYPE_U8,
      .default_value.u8 = UNI_BT_INQUIRY_LENGTH},
     // It seems that with gap_security_level(0) all controllers work except Nintendo Switch Pro controller.
@@ -39,7 +45,39 @@ static const uni_property_t properties[] = {
      .default_value.u8 = UNI_BT_MAX_PERIODIC_LENGTH},
     {UNI_PROPERTY_IDX_GAP_MIN_PERIODIC_LEN, UNI_PROPERTY_NAME_GAP_MIN_PERIODIC_LEN, UNI_PROPERTY_TYPE_U8,
      .default_value.u8 = UNI_BT_MIN_PERIODIC_LENGTH},
+    {UNI_PROPERTY_IDX_LINK_QUALITY_MIN, UNI_PROPERTY_NAME_LINK_QUALITY_MIN, UNI_PROPERTY_TYPE_U8,
+     .default_value.u8 = UNI_BT_LINK_QUALITY_MIN},
+    {UNI_PROPERTY_IDX_LINK_QUALITY_PERIOD, UNI_PROPERTY_NAME_LINK_QUALITY_PERIOD, UNI_PROPERTY_TYPE_U32,
+     .default_value.u32 = UNI_BT_LINK_QUALITY_PERIOD_MS},
+    {UNI_PROPERTY_IDX_LINK_QUALITY_RSSI_MIN, UNI_PROPERTY_NAME_LINK_QUALITY_RSSI_MIN, UNI_PROPERTY_TYPE_U8,
+     .default_value.u8 = UNI_BT_LINK_QUALITY_RSSI_MIN},
+    {UNI_PROPERTY_IDX_MOTION_FUSION_ENABLED, UNI_PROPERTY_NAME_MOTION_FUSION_ENABLED, UNI_PROPERTY_TYPE_BOOL,
+#ifdef CONFIG_BLUEPAD32_ENABLE_MOTION_FUSION_BY_DEFAULT
+     .default_value.boolean = true
+#else
+     .default_value.boolean = false
+#endif  // CONFIG_BLUEPAD32_ENABLE_MOTION_FUSION_BY_DEFAULT
+    },
     {UNI_PROPERTY_IDX_MOUSE_SCALE, UNI_PROPERTY_NAME_MOUSE_SCALE, UNI_PROPERTY_TYPE_FLOAT, .default_value.f32 = 1.0f},
+    // Axis shaping. Values go from 0 to 1023. See uni_axis_shaping.h
+    {UNI_PROPERTY_IDX_PEDAL_ANTI_DEADZONE, UNI_PROPERTY_NAME_PEDAL_ANTI_DEADZONE, UNI_PROPERTY_TYPE_U32,
+     .default_value.u32 = 0},
+    {UNI_PROPERTY_IDX_PEDAL_CURVE, UNI_PROPERTY_NAME_PEDAL_CURVE, UNI_PROPERTY_TYPE_STRING, .default_value.str = NULL},
+    {UNI_PROPERTY_IDX_PEDAL_DEADZONE, UNI_PROPERTY_NAME_PEDAL_DEADZONE, UNI_PROPERTY_TYPE_U32, .default_value.u32 = 0},
+    {UNI_PROPERTY_IDX_PEDAL_EXPO, UNI_PROPERTY_NAME_PEDAL_EXPO, UNI_PROPERTY_TYPE_U32, .default_value.u32 = 0},
+    {UNI_PROPERTY_IDX_SCAN_ADAPTIVE, UNI_PROPERTY_NAME_SCAN_ADAPTIVE, UNI_PROPERTY_TYPE_BOOL,
+     .default_value.boolean = true},
+    {UNI_PROPERTY_IDX_SCAN_BURST, UNI_PROPERTY_NAME_SCAN_BURST, UNI_PROPERTY_TYPE_U32,
+     .default_value.u32 = UNI_BT_SCAN_BURST_MS},
+    {UNI_PROPERTY_IDX_SCAN_MIN_DUTY, UNI_PROPERTY_NAME_SCAN_MIN_DUTY, UNI_PROPERTY_TYPE_U8,
+     .default_value.u8 = UNI_BT_SCAN_MIN_DUTY},
+    {UNI_PROPERTY_IDX_STICK_ANTI_DEADZONE, UNI_PROPERTY_NAME_STICK_ANTI_DEADZONE, UNI_PROPERTY_TYPE_U32,
+     .default_value.u32 = 0},
+    {UNI_PROPERTY_IDX_STICK_AXIAL, UNI_PROPERTY_NAME_STICK_AXIAL, UNI_PROPERTY_TYPE_BOOL,
+     .default_value.boolean = false},
+    {UNI_PROPERTY_IDX_STICK_CURVE, UNI_PROPERTY_NAME_STICK_CURVE, UNI_PROPERTY_TYPE_STRING, .default_value.str = NULL},
+    {UNI_PROPERTY_IDX_STICK_DEADZONE, UNI_PROPERTY_NAME_STICK_DEADZONE, UNI_PROPERTY_TYPE_U32, .default_value.u32 = 0},
+    {UNI_PROPERTY_IDX_STICK_EXPO, UNI_PROPERTY_NAME_STICK_EXPO, UNI_PROPERTY_TYPE_U32, .default_value.u32 = 0},
     {UNI_PROPERTY_IDX_VERSION, UNI_PROPERTY_NAME_VERSION, UNI_PROPERTY_TYPE_STRING, .default_value.str = UNI_VERSION,
      .flags = UNI_PROPERTY_FLAG_READ_ONLY},
     {UNI_PROPERTY_IDX_VIRTUAL_DEVICE_ENABLED, UNI_PROPERTY_NAME_VIRTUAL_DEVICE_ENABLED, UNI_PROPERTY_TYPE_BOOL,
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2023 Ricardo Quesada
+// http://retro.moe/unijoysticle2
+
+#include "uni_ring.h"
+
+#include <string.h>
+
+void uni_ring_reset(uni_ring_t* ring) {
+    ring->head = 0;
+    ring->count = 0;
+    ring->pushed = 0;
+}
+
+void uni_ring_push(uni_ring_t* ring, void* elements, size_t element_size, uint8_t capacity, const void* element) {
+    memcpy((uint8_t*)elements + ring->head * element_size, element, element_size);
+    ring->head = (ring->head + 1) & (capacity - 1);
+    if (ring->count < capacity)
+        ring->count++;
+    ring->pushed++;
+}
+
+int uni_ring_read(uni_ring_t* ring, const void* elements, size_t element_size, uint8_t capacity, void* out, int max) {
+    int n = (max < ring->count) ? max : ring->count;
+    if (n <= 0)
+        return 0;
+
+    int tail = (ring->head - ring->count) & (capacity - 1);
+
+    for (int i = 0; i < n; i++) {
+        memcpy((uint8_t*)out + i * element_size, (const uint8_t*)elements + tail * element_size, element_size);
+        tail = (tail + 1) & (capacity - 1);
+    }
+    ring->count -= n;
+    return n;
+}
+
+int uni_ring_peek(const uni_ring_t* ring,
+                  uint32_t* cursor,
+                  const void* elements,
+                  size_t element_size,
+                  uint8_t capacity,
+                  void* out,
+                  int max) {
+    uint32_t pending = ring->pushed - *cursor;
+
+    // Too far behind, or the elements were already removed.
+    if (pending > ring->count) {
+        *cursor = ring->pushed - ring->count;
+        pending = ring->count;
+    }
+
+    int n = (max < (int)pending) ? max : (int)pending;
+    if (n <= 0)
+        return 0;
+
+    // "pushed" and "head" wrap around at the same time, since the capacity is a power of two.
+    for (int i = 0; i < n; i++) {
+        size_t idx = *cursor & (capacity - 1);
+        memcpy((uint8_t*)out + i * element_size, (const uint8_t*)elements + idx * element_size, element_size);
+        (*cursor)++;
+    }
+    return n;
+}
@@ -6,6 +6,7 @@
 #include "sdkconfig.h"
 
 #include <bt/uni_bt.h>
+#include <controller/uni_motion_fusion.h>
 #include <uni_log.h>
 #include <uni_version.h>
 #include <uni_virtual_device.h>
@@ -93,6 +94,10 @@ void Bluepad32::enableVirtualDevice(bool enabled) {
     uni_virtual_device_set_enabled(enabled);
 }
 
+void Bluepad32::enableMotionFusion(bool enabled) {
+    uni_motion_fusion_set_enabled(enabled);
+}
+
 void Bluepad32::enableBLEService(bool enabled) {
     uni_bt_enable_service_safe(enabled);
 }
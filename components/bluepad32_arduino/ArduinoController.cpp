@@ -93,6 +93,34 @@ void Controller::playDualRumble(uint16_t delayedStartMs,
         loge("error playing dual rumble");
 }
 
+int Controller::readMotionSamples(MotionSample* out, int maxSamples) const {
+    if (!isConnected())
+        return 0;
+
+    int ret = arduino_read_motion_samples(_idx, out, maxSamples);
+    return (ret < 0) ? 0 : ret;
+}
+
+Controller::Quaternion Controller::orientation() const {
+    const float one = UNI_GAMEPAD_ORIENTATION_ONE;
+    const int32_t* q = _data.gamepad.orientation;
+    return {q[0] / one, q[1] / one, q[2] / one, q[3] / one};
+}
+
+Controller::Vector3 Controller::gravity() const {
+    const float one = UNI_GAMEPAD_ORIENTATION_ONE;
+    const int32_t* v = _data.gamepad.gravity;
+    return {v[0] / one, v[1] / one, v[2] / one};
+}
+
+int Controller::readTouchEvents(TouchEvent* out, int maxEvents) const {
+    if (!isConnected())
+        return 0;
+
+    int ret = arduino_read_touch_events(_idx, out, maxEvents);
+    return (ret < 0) ? 0 : ret;
+}
+
 String Controller::getModelName() const {
     for (int i = 0; i < ARRAY_SIZE(_controllerNames); i++) {
         if (_properties.type == _controllerNames[i].type)
@@ -110,27 +138,27 @@ bool Controller::isKeyPressed(KeyboardKey key) const {
         return isModifierPressed(key);
     }
 
-    for (int i = 0; i < UNI_KEYBOARD_PRESSED_KEYS_MAX; i++) {
-        // Return early on error
-        if (_data.keyboard.pressed_keys[i] <= HID_USAGE_KB_ERROR_UNDEFINED)
-            return false;
-        if (_data.keyboard.pressed_keys[i] == key)
-            return true;
-    }
-    return false;
+    // The bitmap has all the pressed keys, even when there are more than UNI_KEYBOARD_PRESSED_KEYS_MAX.
+    return uni_keyboard_is_key_pressed(&_data.keyboard, key);
 }
 
 bool Controller::isAnyKeyPressed() const {
-    for (unsigned char pressed_key : _data.keyboard.pressed_keys) {
-        // Reserved for >= 0xe8
-        if (pressed_key >= Keyboard_A && pressed_key < 0xe8)
+    // Reserved for >= 0xe8. Modifiers are in the bitmap too.
+    for (int key = Keyboard_A; key < 0xe8; key++) {
+        if (uni_keyboard_is_key_pressed(&_data.keyboard, key))
             return true;
     }
-    if (_data.keyboard.modifiers)
-        return true;
     return false;
 }
 
+int Controller::readKeyboardEvents(KeyboardEvent* out, int maxEvents) const {
+    if (!isConnected())
+        return 0;
+
+    int ret = arduino_read_keyboard_events(_idx, out, maxEvents);
+    return (ret < 0) ? 0 : ret;
+}
+
 bool Controller::isModifierPressed(KeyboardKey key) const {
     static uint8_t convertion[] = {
         UNI_KEYBOARD_MODIFIER_LEFT_CONTROL,   //
@@ -154,6 +182,14 @@ bool Controller::isModifierPressed(KeyboardKey key) const {
     return (_data.keyboard.modifiers & modifier);
 }
 
+ControllerProperties Controller::getProperties() const {
+    ControllerProperties properties;
+
+    if (arduino_get_controller_properties(_idx, &properties) != UNI_ARDUINO_ERROR_SUCCESS)
+        return _properties;
+    return properties;
+}
+
 // Private functions
 void Controller::onConnected() {
     _connected = true;
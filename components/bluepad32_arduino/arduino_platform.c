@@ -18,8 +18,12 @@
 #include <freertos/semphr.h>
 
 #include "bt/uni_bt.h"
+#include "bt/uni_bt_link_quality.h"
 #include "cmd_system.h"
 #include "controller/uni_controller.h"
+#include "controller/uni_keyboard.h"
+#include "controller/uni_motion.h"
+#include "controller/uni_touch.h"
 #include "platform/uni_platform.h"
 #include "uni_common.h"
 #include "uni_hid_device.h"
@@ -236,6 +240,14 @@ static uni_error_t arduino_on_device_ready(uni_hid_device_t* d) {
 }
 
 static void arduino_on_controller_data(uni_hid_device_t* d, uni_controller_t* ctl) {
+    uni_bt_link_quality_t link_quality;
+#if CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS
+    uni_motion_sample_t sample;
+    uni_touch_event_t touch;
+    uni_keyboard_event_t key_event;
+#endif  // CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS
+    bool has_link_quality;
+
     process_pending_requests();
 
     arduino_instance_t* ins = get_arduino_instance(d);
@@ -245,16 +257,36 @@ static void arduino_on_controller_data(uni_hid_device_t* d, uni_controller_t* ct
         return;
     }
 
+    has_link_quality = uni_bt_link_quality_get(d, &link_quality);
+
     // Populate gamepad data on shared struct.
     xSemaphoreTake(_controller_mutex, portMAX_DELAY);
     _controllers[ins->controller_idx].data = *ctl;
     _controllers[ins->controller_idx].data_updated = true;
+    if (has_link_quality) {
+        _controllers[ins->controller_idx].properties.rssi = link_quality.rssi;
+        _controllers[ins->controller_idx].properties.link_quality = link_quality.link_quality;
+        _controllers[ins->controller_idx].properties.failed_contacts = link_quality.failed_contacts;
+    }
+#if CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS
+    // The device rings are filled by the parsers without the mutex, so they can't be read from CPU1.
+    while (uni_motion_ring_read(&d->motion, &sample, 1) == 1)
+        uni_motion_ring_push(&_controllers[ins->controller_idx].motion, &sample);
+    while (uni_touch_ring_read(&d->touch, &touch, 1) == 1)
+        uni_touch_ring_push(&_controllers[ins->controller_idx].touch, &touch);
+    while (uni_keyboard_ring_read(&d->key_events, &key_event, 1) == 1)
+        uni_keyboard_ring_push(&_controllers[ins->controller_idx].key_events, &key_event);
+#endif  // CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS
     xSemaphoreGive(_controller_mutex);
 }
 
 static void arduino_on_device_oob_event(uni_platform_oob_event_t event, void* data) {
-    ARG_UNUSED(event);
-    ARG_UNUSED(data);
+    if (event == UNI_PLATFORM_OOB_LINK_QUALITY_LOW) {
+        uni_hid_device_t* d = (uni_hid_device_t*)data;
+        arduino_instance_t* ins = get_arduino_instance(d);
+        logi("Arduino: controller idx=%d, link quality is low\n", ins->controller_idx);
+        return;
+    }
     // TODO: Do something ?
 }
 
@@ -323,6 +355,63 @@ int arduino_get_controller_properties(int idx, arduino_controller_properties_t*
     return UNI_ARDUINO_ERROR_SUCCESS;
 }
 
+int arduino_read_motion_samples(int idx, arduino_motion_sample_t* out, int max_samples) {
+    int ret;
+
+    if (idx < 0 || idx >= CONFIG_BLUEPAD32_MAX_DEVICES)
+        return UNI_ARDUINO_ERROR_INVALID_DEVICE;
+    if (_controllers[idx].idx == UNI_ARDUINO_GAMEPAD_INVALID)
+        return UNI_ARDUINO_ERROR_INVALID_DEVICE;
+
+#if CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS
+    xSemaphoreTake(_controller_mutex, portMAX_DELAY);
+    ret = uni_motion_ring_read(&_controllers[idx].motion, out, max_samples);
+    xSemaphoreGive(_controller_mutex);
+#else
+    ret = UNI_ARDUINO_ERROR_NO_DATA;
+#endif  // CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS
+
+    return ret;
+}
+
+int arduino_read_touch_events(int idx, arduino_touch_event_t* out, int max_events) {
+    int ret;
+
+    if (idx < 0 || idx >= CONFIG_BLUEPAD32_MAX_DEVICES)
+        return UNI_ARDUINO_ERROR_INVALID_DEVICE;
+    if (_controllers[idx].idx == UNI_ARDUINO_GAMEPAD_INVALID)
+        return UNI_ARDUINO_ERROR_INVALID_DEVICE;
+
+#if CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS
+    xSemaphoreTake(_controller_mutex, portMAX_DELAY);
+    ret = uni_touch_ring_read(&_controllers[idx].touch, out, max_events);
+    xSemaphoreGive(_controller_mutex);
+#else
+    ret = UNI_ARDUINO_ERROR_NO_DATA;
+#endif  // CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS
+
+    return ret;
+}
+
+int arduino_read_keyboard_events(int idx, arduino_keyboard_event_t* out, int max_events) {
+    int ret;
+
+    if (idx < 0 || idx >= CONFIG_BLUEPAD32_MAX_DEVICES)
+        return UNI_ARDUINO_ERROR_INVALID_DEVICE;
+    if (_controllers[idx].idx == UNI_ARDUINO_GAMEPAD_INVALID)
+        return UNI_ARDUINO_ERROR_INVALID_DEVICE;
+
+#if CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS
+    xSemaphoreTake(_controller_mutex, portMAX_DELAY);
+    ret = uni_keyboard_ring_read(&_controllers[idx].key_events, out, max_events);
+    xSemaphoreGive(_controller_mutex);
+#else
+    ret = UNI_ARDUINO_ERROR_NO_DATA;
+#endif  // CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS
+
+    return ret;
+}
+
 int arduino_set_player_leds(int idx, uint8_t leds) {
     if (idx < 0 || idx >= CONFIG_BLUEPAD32_MAX_DEVICES)
         return UNI_ARDUINO_ERROR_INVALID_DEVICE;
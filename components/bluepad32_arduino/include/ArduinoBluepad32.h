@@ -60,6 +60,11 @@ class Bluepad32 {
     // By default, it is disabled.
     void enableVirtualDevice(bool enabled);
 
+    // Enables the orientation calculation for controllers with gyro / accelerometer,
+    // like DualSense, DualShock4, Switch and Wii. See Controller::orientation().
+    // By default, it is disabled.
+    void enableMotionFusion(bool enabled);
+
     // Enables the BLE Service in Bluepad32.
     // This service allows clients, like a mobile app, to setup and see the state of Bluepad32.
     // By default, it is disabled.
@@ -65,6 +65,13 @@ class Controller {
         CONTROLLER_TYPE_GenericMouse = 800,
     };
 
+    struct Quaternion {
+        float w, x, y, z;
+    };
+    struct Vector3 {
+        float x, y, z;
+    };
+
     Controller();
 
     //
@@ -91,6 +98,23 @@ class Controller {
     int32_t accelY() const { return _data.gamepad.accel[1]; }
     int32_t accelZ() const { return _data.gamepad.accel[2]; }
 
+    // gyro*() / accel*() only have the latest sample. Controllers like Switch report more
+    // than one sample per report. This returns all the samples received since the last call,
+    // oldest first. Returns the number of samples copied to "out".
+    // Always 0 if CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS is disabled.
+    int readMotionSamples(MotionSample* out, int maxSamples) const;
+
+    // Touchpad events, like the ones from DualShock 4 and DualSense: all the fingers and all the
+    // frames received since the last call, oldest first. Returns the number of events copied to "out".
+    // Always 0 if CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS is disabled.
+    int readTouchEvents(TouchEvent* out, int maxEvents) const;
+
+    // Requires BP32.enableMotionFusion(true). All zeros until the orientation is known.
+    // Orientation as a unit quaternion. Controllers without gyro, like the Wii, don't report yaw.
+    Quaternion orientation() const;
+    // Unit vector that points "up", in the controller coordinates.
+    Vector3 gravity() const;
+
     //
     // Shared between Mouse & Gamepad
     //
@@ -143,6 +167,10 @@ class Controller {
     int32_t deltaX() const { return _data.mouse.delta_x; }
     int32_t deltaY() const { return _data.mouse.delta_y; }
     int8_t scrollWheel() const { return _data.mouse.scroll_wheel; }
+    int8_t pan() const { return _data.mouse.pan; }
+    // In 1/UNI_MOUSE_WHEEL_HIRES_UNITS of a detent.
+    int16_t scrollWheelHiRes() const { return _data.mouse.scroll_wheel_hires; }
+    int16_t panHiRes() const { return _data.mouse.pan_hires; }
 
     //
     // Wii Balance Board related
@@ -158,6 +186,10 @@ class Controller {
     //
     bool isKeyPressed(KeyboardKey key) const;
     bool isAnyKeyPressed() const;
+    // isKeyPressed() only has the latest state. This returns every press and release received since
+    // the last call, oldest first, so that quick key strokes are not lost. Returns the number of events
+    // copied to "out". Always 0 if CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS is disabled.
+    int readKeyboardEvents(KeyboardEvent* out, int maxEvents) const;
 
     //
     // Shared among all
@@ -184,7 +216,8 @@ class Controller {
     // Returns the controller model.
     int getModel() const { return _properties.type; }
     String getModelName() const;
-    ControllerProperties getProperties() const { return _properties; }
+    // Properties like the link quality get updated while connected.
+    ControllerProperties getProperties() const;
 
     // "Output" functions.
 
@@ -9,5 +9,8 @@
 #include "arduino_platform.h"
 
 using ControllerData = arduino_controller_data_t;
+using MotionSample = arduino_motion_sample_t;
+using TouchEvent = arduino_touch_event_t;
+using KeyboardEvent = arduino_keyboard_event_t;
 
 #endif  // BP32_ARDUINO_CONTROLLER_DATA_H
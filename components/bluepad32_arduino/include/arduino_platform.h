@@ -25,7 +25,12 @@ extern "C" {
 
 #include <stdint.h>
 
+#include "sdkconfig.h"
+
 #include "controller/uni_controller.h"
+#include "controller/uni_keyboard.h"
+#include "controller/uni_motion.h"
+#include "controller/uni_touch.h"
 #include "platform/uni_platform.h"
 #include "uni_common.h"
 
@@ -47,6 +52,9 @@ enum {
 
 typedef uni_controller_t arduino_controller_data_t;
 typedef uni_gamepad_t arduino_gamepad_data_t;
+typedef uni_motion_sample_t arduino_motion_sample_t;
+typedef uni_touch_event_t arduino_touch_event_t;
+typedef uni_keyboard_event_t arduino_keyboard_event_t;
 
 typedef struct {
     uint8_t btaddr[6];    // BT Addr
@@ -55,6 +63,11 @@ typedef struct {
     uint16_t vendor_id;   // VID
     uint16_t product_id;  // PID
     uint16_t flags;       // Features like Rumble, LEDs, etc.
+
+    // Link quality, updated periodically while connected. All zeros until the first sample arrives.
+    int8_t rssi;               // Smoothed RSSI in dBm. On BR/EDR it is relative to the golden receive power range
+    uint8_t link_quality;      // 0-255, the higher the better. BR/EDR only
+    uint16_t failed_contacts;  // BR/EDR only
 } arduino_controller_properties_t;
 typedef arduino_controller_properties_t arduino_gamepad_properties_t;
 
@@ -63,6 +76,15 @@ typedef struct {
     arduino_controller_data_t data;
     bool data_updated;
 
+#if CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS
+    // Gyro / accel samples received since the last read. Oldest ones get overwritten.
+    uni_motion_ring_t motion;
+    // Touchpad events received since the last read. Oldest ones get overwritten.
+    uni_touch_ring_t touch;
+    // Key press / release events received since the last read. Oldest ones get overwritten.
+    uni_keyboard_ring_t key_events;
+#endif  // CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS
+
     // TODO: To reduce RAM, the properties should be calculated at "request time", and
     // not store them "forever".
     arduino_controller_properties_t properties;
@@ -76,6 +98,14 @@ int arduino_get_controller_data(int idx, arduino_controller_data_t* out_data);
 // Deprecated: Call arduino_get_controller_properties () instead.
 int arduino_get_gamepad_properties(int idx, arduino_gamepad_properties_t* out_properties);
 int arduino_get_controller_properties(int idx, arduino_gamepad_properties_t* out_properties);
+// The arduino_read_*() functions need CONFIG_BLUEPAD32_ARDUINO_EVENT_RINGS. Otherwise they return
+// UNI_ARDUINO_ERROR_NO_DATA.
+// Returns the number of samples copied to "out", oldest first, or a negative error.
+int arduino_read_motion_samples(int idx, arduino_motion_sample_t* out, int max_samples);
+// Returns the number of events copied to "out", oldest first, or a negative error.
+int arduino_read_touch_events(int idx, arduino_touch_event_t* out, int max_events);
+// Returns the number of events copied to "out", oldest first, or a negative error.
+int arduino_read_keyboard_events(int idx, arduino_keyboard_event_t* out, int max_events);
 int arduino_set_player_leds(int idx, uint8_t leds);
 int arduino_set_lightbar_color(int idx, uint8_t r, uint8_t g, uint8_t b);
 int arduino_play_dual_rumble(int idx,